@@ -0,0 +1,449 @@
+/**
+ * @file bench/spp_bench.cpp
+ */
+
+#include "ccsds/crc.h"
+#include "ccsds/spp.h"
+#include "ccsds/spp_decode.h"
+#include "ccsds/spp_secondary.h"
+#include "ccsds/tm.h"
+#include "benchmark/benchmark.h"
+#include <algorithm>
+#include <vector>
+
+/**
+ * @defgroup bench Benchmarks
+ * @{
+ */
+
+/**
+ * CCSDS service discarding transferred DUs.
+ */
+class discard_service : public ccsds::base_service {
+    public:
+        discard_service() = default;
+        virtual ~discard_service() = default;
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override
+        {
+            benchmark::DoNotOptimize(du.get());
+            return ccsds::error();
+        }
+};
+
+/**
+ * Loopback CCSDS service for benchmarks.
+ */
+class bench_loopback_service : public ccsds::base_service {
+    public:
+        bench_loopback_service() :
+            service(nullptr)
+        {}
+        virtual ~bench_loopback_service() = default;
+
+        /**
+         * Set service to loopback to.
+         * @param serv CCSDS service to receive packets.
+         */
+        void set_service(ccsds::spp::octet_service& serv)
+        {
+            service = &serv;
+        }
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override
+        {
+            // The octet service always puts the header in a PDU at the start of the chain
+            ccsds::base_du* du = const_cast<ccsds::base_du*>(sdu.release());
+            service->reception(std::unique_ptr<ccsds::spp::pdu>(static_cast<ccsds::spp::pdu*>(du)));
+            return ccsds::error();
+        }
+
+        ccsds::spp::octet_service* service; ///< Service to loopback to.
+};
+
+/**
+ * Octet service exposing packet assembly.
+ */
+class bench_octet_service : public ccsds::spp::octet_service {
+    public:
+        using ccsds::spp::octet_service::octet_service;
+        using ccsds::spp::octet_service::assembly;
+};
+
+/**
+ * Indication function discarding received SDUs.
+ */
+static void discard_sdu(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool loss)
+{
+    benchmark::DoNotOptimize(sdu.get());
+    benchmark::DoNotOptimize(id);
+    benchmark::DoNotOptimize(loss);
+}
+
+/**
+ * Indication function discarding received PDUs.
+ */
+static void discard_pdu(std::unique_ptr<const ccsds::spp::pdu> pdu, ccsds::spp::apid id, bool loss)
+{
+    benchmark::DoNotOptimize(pdu.get());
+    benchmark::DoNotOptimize(id);
+    benchmark::DoNotOptimize(loss);
+}
+
+/**
+ * Build a received space packet.
+ * @param data Packet data field.
+ * @param len Length of data in bytes.
+ * @param count Packet sequence count.
+ * @return Space packet PDU.
+ */
+static std::unique_ptr<ccsds::spp::pdu> bench_packet(uint8_t* data, size_t len, uint16_t count)
+{
+    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+    (*pdu)->header.identification = ccsds::spp::identification(static_cast<ccsds::spp::apid>(0x1AB), ccsds::spp::TELEMETRY, false);
+    (*pdu)->header.sequence_control = ccsds::spp::sequence_control(ccsds::spp::SEQUENCE_UNSEGMENTED, count);
+    (*pdu)->header.data_length = ccsds::htons(len - 1);
+    pdu->append(std::make_unique<ccsds::buffered_du>(data, len));
+    return pdu;
+}
+
+/**
+ * Benchmark octet_service::assembly over payload sizes.
+ */
+static void octet_assembly(benchmark::State& state)
+{
+    bench_octet_service service(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    std::vector<uint8_t> data(state.range(0));
+
+    for(auto _ : state){
+        auto sdu = std::make_unique<ccsds::buffered_du>(data.data(), data.size());
+        auto pdu = service.assembly(std::move(sdu), false, ccsds::spp::TELEMETRY);
+        benchmark::DoNotOptimize(pdu.get());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (data.size() + sizeof(ccsds::spp::primary_header)));
+}
+BENCHMARK(octet_assembly)->RangeMultiplier(4)->Range(16, 65536);
+
+/**
+ * Benchmark octet_service::request to a discarding subnetwork.
+ */
+static void octet_request(benchmark::State& state)
+{
+    discard_service discard;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &discard);
+    std::vector<uint8_t> data(state.range(0));
+
+    for(auto _ : state){
+        auto sdu = std::make_unique<ccsds::buffered_du>(data.data(), data.size());
+        benchmark::DoNotOptimize(service.request(std::move(sdu), false, ccsds::spp::TELEMETRY));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(octet_request)->Arg(64);
+
+/**
+ * Benchmark octet_service::request copying user data into one DU.
+ */
+static void octet_request_copy(benchmark::State& state)
+{
+    discard_service discard;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &discard);
+    std::vector<uint8_t> data(state.range(0));
+
+    for(auto _ : state){
+        benchmark::DoNotOptimize(service.request(data.data(), data.size(), false, ccsds::spp::TELEMETRY));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(octet_request_copy)->Arg(16)->Arg(64)->Arg(256);
+
+/**
+ * Benchmark packet_service::reception over payload sizes.
+ * @note Includes building the received PDU.
+ */
+static void packet_reception(benchmark::State& state)
+{
+    ccsds::spp::packet_service service(nullptr);
+    service.set_indication(&discard_pdu);
+    std::vector<uint8_t> data(state.range(0));
+
+    uint16_t count = 0;
+    for(auto _ : state){
+        service.reception(bench_packet(data.data(), data.size(), count++));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (data.size() + sizeof(ccsds::spp::primary_header)));
+}
+BENCHMARK(packet_reception)->RangeMultiplier(4)->Range(16, 65536);
+
+/**
+ * Benchmark octet_service::reception over payload sizes.
+ * @note Includes building the received PDU.
+ */
+static void octet_reception(benchmark::State& state)
+{
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    service.set_indication(&discard_sdu);
+    std::vector<uint8_t> data(state.range(0));
+
+    uint16_t count = 0;
+    for(auto _ : state){
+        service.reception(bench_packet(data.data(), data.size(), count++));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (data.size() + sizeof(ccsds::spp::primary_header)));
+}
+BENCHMARK(octet_reception)->RangeMultiplier(4)->Range(16, 65536);
+
+/**
+ * Build a chain of buffers.
+ * @param data Buffer viewed by every node.
+ * @param len Number of nodes in the chain.
+ * @return Head of the chain.
+ */
+static std::unique_ptr<const ccsds::base_du> bench_chain(uint8_t* data, size_t len)
+{
+    std::unique_ptr<const ccsds::base_du> chain;
+    for(size_t i = 0; i < len; ++i){
+        std::unique_ptr<ccsds::buffered_du> du = std::make_unique<ccsds::buffered_du>(data, 16);
+        if(chain){
+            du->append(std::move(chain));
+        }
+        chain = std::move(du);
+    }
+    return chain;
+}
+
+/**
+ * Benchmark base_du::totalSize over chain lengths.
+ */
+static void chain_total_size(benchmark::State& state)
+{
+    uint8_t data[16];
+    std::unique_ptr<const ccsds::base_du> chain = bench_chain(data, state.range(0));
+
+    for(auto _ : state){
+        benchmark::DoNotOptimize(chain->totalSize());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(chain_total_size)->RangeMultiplier(4)->Range(1, 4096);
+
+/**
+ * Benchmark base_du::length over chain lengths.
+ */
+static void chain_length(benchmark::State& state)
+{
+    uint8_t data[16];
+    std::unique_ptr<const ccsds::base_du> chain = bench_chain(data, state.range(0));
+
+    for(auto _ : state){
+        benchmark::DoNotOptimize(chain->length());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(chain_length)->RangeMultiplier(4)->Range(1, 4096);
+
+/**
+ * Benchmark assembling packets from chained SDUs over chain lengths.
+ */
+static void chain_assembly(benchmark::State& state)
+{
+    bench_octet_service service(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    uint8_t data[16];
+
+    for(auto _ : state){
+        state.PauseTiming();
+        std::unique_ptr<const ccsds::base_du> chain = bench_chain(data, state.range(0));
+        state.ResumeTiming();
+        auto pdu = service.assembly(std::move(chain), false, ccsds::spp::TELEMETRY);
+        benchmark::DoNotOptimize(pdu.get());
+        state.PauseTiming();
+        pdu.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(chain_assembly)->RangeMultiplier(4)->Range(1, 4096);
+
+/**
+ * Benchmark a request looped back to reception over payload sizes.
+ */
+static void loopback(benchmark::State& state)
+{
+    bench_loopback_service loop;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &loop);
+    loop.set_service(service);
+    service.set_indication(&discard_sdu);
+    std::vector<uint8_t> data(state.range(0));
+
+    for(auto _ : state){
+        auto sdu = std::make_unique<ccsds::buffered_du>(data.data(), data.size());
+        benchmark::DoNotOptimize(service.request(std::move(sdu), false, ccsds::spp::TELEMETRY));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (data.size() + sizeof(ccsds::spp::primary_header)));
+}
+BENCHMARK(loopback)->RangeMultiplier(4)->Range(16, 65536);
+
+/**
+ * Primary headers and decoded fields for decoding benchmarks.
+ */
+struct decode_bench_headers {
+    std::vector<ccsds::spp::primary_header> headers; ///< Headers to decode.
+    std::vector<uint16_t> apid, seq;                 ///< Decoded APIDs and sequence counts.
+    std::vector<uint8_t> type, secondary, flags;     ///< Decoded packet types and flags.
+    std::vector<uint32_t> length;                    ///< Decoded data lengths.
+    ccsds::spp::header_fields fields;                ///< Decoded fields.
+
+    /**
+     * Constructor.
+     * @param count Number of headers.
+     */
+    explicit decode_bench_headers(size_t count) :
+        headers(count), apid(count), seq(count), type(count), secondary(count), flags(count), length(count),
+        fields{apid.data(), type.data(), secondary.data(), flags.data(), seq.data(), length.data()}
+    {
+        for(size_t i = 0; i < count; ++i){
+            headers[i].identification = ccsds::spp::identification(static_cast<ccsds::spp::apid>(i & ccsds::spp::APID_MAX), ccsds::spp::TELEMETRY, false);
+            headers[i].sequence_control = ccsds::spp::sequence_control(ccsds::spp::SEQUENCE_UNSEGMENTED, i);
+            headers[i].data_length = ccsds::htons(i);
+        }
+    }
+};
+
+/**
+ * Benchmark decoding arrays of primary headers.
+ */
+static void header_decode(benchmark::State& state)
+{
+    size_t count = state.range(0);
+    decode_bench_headers bench(count);
+
+    for(auto _ : state){
+        benchmark::DoNotOptimize(ccsds::spp::decode_headers(bench.headers.data(), count, bench.fields));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(header_decode)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(256)->Arg(4096)->Arg(32768);
+
+/**
+ * Benchmark decoding arrays of primary headers with the portable kernel,
+ * the baseline of header_decode.  The headers are passed to
+ * decode_headers() in runs shorter than the vector threshold.
+ */
+static void header_decode_scalar(benchmark::State& state)
+{
+    size_t count = state.range(0);
+    decode_bench_headers bench(count);
+    const size_t run = ccsds::spp::VECTOR_THRESHOLD - 1;
+
+    for(auto _ : state){
+        size_t decoded = 0;
+        for(size_t i = 0; i < count; i += run){
+            ccsds::spp::header_fields part = {
+                &bench.fields.apid[i],
+                &bench.fields.type[i],
+                &bench.fields.secondary[i],
+                &bench.fields.flags[i],
+                &bench.fields.count[i],
+                &bench.fields.length[i],
+            };
+            decoded += ccsds::spp::decode_headers(&bench.headers[i], std::min(run, count - i), part);
+        }
+        benchmark::DoNotOptimize(decoded);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(header_decode_scalar)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Arg(64)->Arg(256)->Arg(4096)->Arg(32768);
+
+/**
+ * Benchmark decoding the headers of packets held back to back, as read
+ * from an archive or a socket.
+ */
+static void stream_decode(benchmark::State& state)
+{
+    size_t count = state.range(0);
+    decode_bench_headers bench(count);
+    std::vector<uint8_t> stream;
+    for(size_t i = 0; i < count; ++i){
+        bench.headers[i].data_length = ccsds::htons(15);
+        const uint8_t* header = reinterpret_cast<const uint8_t*>(&bench.headers[i]);
+        stream.insert(stream.end(), header, header + sizeof(ccsds::spp::primary_header));
+        stream.resize(stream.size() + 16);
+    }
+    std::vector<size_t> offsets(count);
+
+    for(auto _ : state){
+        benchmark::DoNotOptimize(ccsds::spp::decode_stream(stream.data(), stream.size(), offsets.data(), count, bench.fields));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(stream_decode)->Arg(16)->Arg(256)->Arg(4096);
+
+/**
+ * Benchmark decoding CUC time codes from the secondary headers of a batch of packets.
+ */
+static void time_decode(benchmark::State& state)
+{
+    typedef ccsds::spp::secondary_field<0, ccsds::cuc<4, 2>> time_field;
+    size_t count = state.range(0);
+    std::vector<uint8_t> buffer(count * 32);
+    std::vector<size_t> offsets(count);
+    for(size_t i = 0; i < count; ++i){
+        offsets[i] = i * 32;
+        ccsds::timestamp time = {static_cast<uint32_t>(i), 0};
+        time_field::encode(&buffer[offsets[i] + sizeof(ccsds::spp::primary_header)], time);
+    }
+    std::vector<ccsds::timestamp> times(count);
+
+    for(auto _ : state){
+        time_field::decode(buffer.data(), offsets.data(), count, times.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(time_decode)->RangeMultiplier(8)->Range(8, 32768);
+
+/**
+ * Benchmark computing the CRC-16-CCITT of a buffer.
+ */
+static void crc16(benchmark::State& state)
+{
+    std::vector<uint8_t> buffer(state.range(0), 0xA5);
+
+    for(auto _ : state){
+        benchmark::DoNotOptimize(ccsds::crc16(buffer.data(), buffer.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(crc16)->RangeMultiplier(4)->Range(16, 65536);
+
+/**
+ * Benchmark multiplexing space packets into TM transfer frames.
+ */
+static void frame_multiplex(benchmark::State& state)
+{
+    discard_service physical;
+    ccsds::tm::frame_service master(0x1, 1115, &physical);
+    ccsds::tm::virtual_channel channel(master, 0);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &channel);
+    std::vector<uint8_t> data(state.range(0));
+
+    for(auto _ : state){
+        service.request(std::make_unique<ccsds::buffered_du>(data.data(), data.size()), false, ccsds::spp::TELEMETRY);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * (data.size() + sizeof(ccsds::spp::primary_header)));
+}
+BENCHMARK(frame_multiplex)->RangeMultiplier(4)->Range(16, 4096);
+
+BENCHMARK_MAIN();
+
+/** @} */ // group bench
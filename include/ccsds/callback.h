@@ -0,0 +1,158 @@
+/**
+ * @file ccsds/callback.h
+ * Context-carrying callbacks
+ */
+
+#ifndef CCSDS_CALLBACK_H_
+#define CCSDS_CALLBACK_H_
+
+#include <cstddef>
+#include <utility>
+
+namespace ccsds {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+template<typename SIGNATURE>
+class callback;
+
+/**
+ * Non-owning callback with an optional context.
+ * A callback is two pointers and never allocates.  Bound member functions
+ * and callables are called through a trampoline they can be inlined into,
+ * so dispatch costs a single indirect call.  It can be made from a plain
+ * function pointer, a function taking a context pointer, a member function
+ * bound to an object, or a reference to a callable object.
+ * @note The context, object or callable must outlive the callback.
+ * @tparam R Return type.
+ * @tparam Args Argument types.
+ */
+template<typename R, typename... Args>
+class callback<R(Args...)> {
+    public:
+        /**
+         * Construct an empty callback.
+         */
+        constexpr callback() :
+            invoke(nullptr),
+            context(nullptr)
+        {}
+
+        /**
+         * Construct an empty callback.
+         */
+        constexpr callback(std::nullptr_t) :
+            callback()
+        {}
+
+        /**
+         * Construct a callback calling a function.
+         * @param func Function to call, may be nullptr.
+         */
+        callback(R (*func)(Args...)) :
+            invoke((func != nullptr) ? &call_function : nullptr),
+            // POSIX requires function pointers to convert to and from void*
+            context(reinterpret_cast<void*>(func))
+        {}
+
+        /**
+         * Construct a callback calling a function with a context.
+         * @param func Function to call, the first argument is context.
+         * @param context Context passed to func.
+         */
+        constexpr callback(R (*func)(void*, Args...), void* context) :
+            invoke(func),
+            context(context)
+        {}
+
+        /**
+         * Make a callback calling a member function of an object.
+         * @tparam MEMBER Member function to call.
+         * @tparam T Type of the object.
+         * @param object Object to call MEMBER on.
+         * @return Callback.
+         */
+        template<auto MEMBER, typename T>
+        static callback bind(T* object)
+        {
+            return callback(&call_member<MEMBER, T>, object);
+        }
+
+        /**
+         * Make a callback calling a callable object, such as a lambda.
+         * @tparam F Type of the callable.
+         * @param callable Callable object, it is referenced and not copied.
+         * @return Callback.
+         */
+        template<typename F>
+        static callback bind(F& callable)
+        {
+            return callback(&call_callable<F>, &callable);
+        }
+
+        /**
+         * Call the callback.
+         * @warning The callback must not be empty.
+         * @param args Arguments.
+         * @return Return value of the callback.
+         */
+        R operator()(Args... args) const
+        {
+            return invoke(context, std::forward<Args>(args)...);
+        }
+
+        /**
+         * Check the callback is not empty.
+         * @return true if the callback is set, false otherwise.
+         */
+        explicit operator bool() const
+        {
+            return invoke != nullptr;
+        }
+
+        /**
+         * Check the callback is empty.
+         * @return true if the callback is empty, false otherwise.
+         */
+        bool operator==(std::nullptr_t) const
+        {
+            return invoke == nullptr;
+        }
+
+        /**
+         * Check the callback is not empty.
+         * @return true if the callback is set, false otherwise.
+         */
+        bool operator!=(std::nullptr_t) const
+        {
+            return invoke != nullptr;
+        }
+
+    private:
+        static R call_function(void* func, Args... args)
+        {
+            return reinterpret_cast<R (*)(Args...)>(func)(std::forward<Args>(args)...);
+        }
+
+        template<auto MEMBER, typename T>
+        static R call_member(void* object, Args... args)
+        {
+            return (static_cast<T*>(object)->*MEMBER)(std::forward<Args>(args)...);
+        }
+
+        template<typename F>
+        static R call_callable(void* callable, Args... args)
+        {
+            return (*static_cast<F*>(callable))(std::forward<Args>(args)...);
+        }
+
+        R   (*invoke)(void*, Args...); ///< Function called with the context.
+        void* context;                 ///< Context, object, callable or plain function.
+};
+
+/** @} */ // group ccsds
+} // namespace ccsds
+
+#endif // CCSDS_CALLBACK_H_
@@ -2,7 +2,13 @@
  * @file ccsds/common.h
  */
 
+#ifndef CCSDS_COMMON_H_
+#define CCSDS_COMMON_H_
+
+#include "ccsds/callback.h"
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 
 namespace ccsds {
@@ -23,6 +29,9 @@ class error {
             NONE = 0,    ///< No error.
             NO_SUPPORT,  ///< Function not supported.
             NO_NETWORK,  ///< Network unavailable.
+            INVALID_ARG, ///< Invalid argument.
+            IO_ERROR,    ///< Subnetwork I/O failed.
+            NO_SPACE,    ///< Queue or buffer full.
         };
 
         /**
@@ -64,8 +73,58 @@ class error {
         code value;  ///< Error code.
 };
 
+/**
+ * Size of a cache line in bytes, used to keep shared state apart.
+ */
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Contiguous segment of a DU chain.
+ * The layout matches POSIX struct iovec.
+ */
+struct segment {
+    const void* base; ///< Start of the segment.
+    size_t      len;  ///< Length of the segment in bytes.
+};
+
+/**
+ * Allocator for DU nodes.
+ * @see base_du::set_allocator
+ */
+class du_allocator {
+    public:
+        /**
+         * Constructor.
+         */
+        du_allocator() = default;
+
+        /**
+         * Destructor.
+         */
+        virtual ~du_allocator() = default;
+
+        /**
+         * Allocate memory for a DU.
+         * @param size Size of the DU in bytes.
+         * @return Pointer to the memory, nullptr to fall back to the heap.
+         */
+        virtual void* allocate(size_t size) noexcept = 0;
+
+        /**
+         * Release memory for a DU.
+         * @param p Pointer to the memory.
+         * @param size Size of the DU in bytes.
+         * @return true if the memory belonged to the allocator, false otherwise.
+         */
+        virtual bool deallocate(void* p, size_t size) noexcept = 0;
+};
+
 /**
  * Generic zero-copy buffer for data units (DU).
+ * DUs are linked into chains, each DU caching the total size and number of
+ * the DUs after it.  The links and cached totals are not part of the data
+ * of a DU, so a chain handed over as const can be relinked without casting
+ * away const.
  */
 class base_du {
     public:
@@ -73,13 +132,22 @@ class base_du {
          * Constructor.
          */
         base_du() :
-            ptr(nullptr)
+            ptr(nullptr),
+            tail_size(0),
+            tail_length(0)
         {}
 
         /**
          * Destructor.
          */
-        virtual ~base_du() = default;
+        virtual ~base_du()
+        {
+            // Unlink the chain one node at a time so long chains do not recurse
+            std::unique_ptr<const base_du> du = std::move(ptr);
+            while(du){
+                du = std::move(du->ptr);
+            }
+        }
 
         /**
          * Get the size of the buffer in bytes.
@@ -93,11 +161,7 @@ class base_du {
          */
         size_t totalSize() const
         {
-            if(ptr){
-                return size() + ptr->totalSize();
-            }else{
-                return size();
-            }
+            return size() + tail_size;
         }
 
         /**
@@ -106,11 +170,7 @@ class base_du {
          */
         size_t length() const
         {
-            if(ptr){
-                return ptr->length() + 1;
-            }else{
-                return 1;
-            }
+            return tail_length + 1;
         }
 
         /**
@@ -119,13 +179,77 @@ class base_du {
          */
         virtual const void* get() const = 0;
 
+        /**
+         * Export the chained buffers as segments for scatter-gather I/O.
+         * Empty buffers are skipped.
+         * @param segments Array to fill with segments.
+         * @param count Length of segments.
+         * @return Number of segments in the chain, segments are only filled
+         * up to count.
+         */
+        size_t gather(segment* segments, size_t count) const
+        {
+            size_t n = 0;
+            for(const base_du* du = this; du != nullptr; du = du->ptr.get()){
+                size_t len = du->size();
+                if(len > 0){
+                    if(n < count){
+                        segments[n].base = du->get();
+                        segments[n].len = len;
+                    }
+                    ++n;
+                }
+            }
+            return n;
+        }
+
         /**
          * Append an DU.
+         * Any DUs after this one are released.
          * @param du DU to append.
+         * @warning The cached totals of this DU go stale if the size of a DU
+         * in the appended chain changes, and those of the DUs before it in
+         * a chain are not updated.  Use extend() or du_chain to link DUs at
+         * the end of a chain.
          */
         void append(std::unique_ptr<const base_du> du)
         {
             ptr.swap(du);
+            if(ptr){
+                tail_size = ptr->totalSize();
+                tail_length = ptr->length();
+            }else{
+                tail_size = 0;
+                tail_length = 0;
+            }
+        }
+
+        /**
+         * Append a DU to the end of the chain.
+         * Walks the whole chain, use du_chain to build long chains.
+         * @param du DU to append.
+         * @warning The cached totals go stale if the size of a linked DU
+         * changes, or if a DU in the middle of a chain is extended, as the
+         * DUs before it are not updated.
+         */
+        void extend(std::unique_ptr<const base_du> du)
+        {
+            if(!du){
+                return;
+            }
+
+            size_t size = du->totalSize();
+            size_t len = du->length();
+            const base_du* last = this;
+            while(true){
+                last->tail_size += size;
+                last->tail_length += len;
+                if(!last->ptr){
+                    break;
+                }
+                last = last->ptr.get();
+            }
+            last->ptr = std::move(du);
         }
 
         /**
@@ -143,11 +267,184 @@ class base_du {
          */
         std::unique_ptr<const base_du> pop()
         {
+            tail_size = 0;
+            tail_length = 0;
             return std::move(ptr);
         }
 
+        /**
+         * Split the chain after the DUs that lie within its first bytes.
+         * Keeps this DU and every DU after it ending within len bytes of
+         * the start of this DU, and updates their cached totals.
+         * @param len Number of bytes to keep, at least size().
+         * @return The first DU not kept, followed by the DUs after it, or
+         * nullptr if the whole chain lies within len bytes.
+         */
+        std::unique_ptr<const base_du> split(size_t len)
+        {
+            // Find the last DU to keep
+            size_t kept = size();
+            const base_du* last = this;
+            while(last->ptr && (kept + last->ptr->size() <= len)){
+                last = last->ptr.get();
+                kept += last->size();
+            }
+
+            size_t removed = last->tail_size;
+            size_t removed_length = last->tail_length;
+            for(const base_du* du = this; du != last; du = du->ptr.get()){
+                du->tail_size -= removed;
+                du->tail_length -= removed_length;
+            }
+            last->tail_size = 0;
+            last->tail_length = 0;
+            return std::move(last->ptr);
+        }
+
+        /**
+         * Set the allocator used for all DU nodes.
+         * @param alloc Allocator to use, nullptr to use the heap.
+         * @warning The allocator must not be changed while DUs allocated
+         * from the previous allocator still exist.
+         */
+        static void set_allocator(du_allocator* alloc);
+
+        /**
+         * Allocate memory from the DU allocator.
+         * Falls back to the heap if no allocator is set or it cannot
+         * provide size bytes.
+         * @param size Size of the memory in bytes.
+         * @return Pointer to the memory.
+         */
+        static void* allocate(size_t size);
+
+        /**
+         * Release memory from allocate().
+         * @param p Pointer to the memory.
+         * @param size Size of the memory in bytes.
+         */
+        static void deallocate(void* p, size_t size);
+
+        /**
+         * Allocate a DU node.
+         * @param size Size of the DU in bytes.
+         * @return Pointer to the memory.
+         */
+        static void* operator new(size_t size);
+
+        /**
+         * Release a DU node.
+         * @param p Pointer to the memory.
+         * @param size Size of the DU in bytes.
+         */
+        static void operator delete(void* p, size_t size);
+
+    private:
+        friend class du_chain;
+
+        mutable std::unique_ptr<const base_du> ptr;         ///< Link list of DU.
+        mutable size_t                         tail_size;   ///< Total size of the buffers after this one.
+        mutable size_t                         tail_length; ///< Number of buffers after this one.
+};
+
+/**
+ * Builder of a DU chain.
+ * DUs are linked at the end of the chain without walking the DUs already
+ * linked, and the cached totals of every DU are set in one pass once the
+ * chain is taken, so building a chain of n DUs takes O(n).
+ */
+class du_chain {
+    public:
+        /**
+         * Constructor.
+         */
+        du_chain() :
+            last(nullptr),
+            total(0),
+            count(0)
+        {}
+
+        du_chain(const du_chain&) = delete;
+        du_chain& operator=(const du_chain&) = delete;
+
+        /**
+         * Append a DU, or a chain of DUs, to the end of the chain.
+         * Only the appended chain is walked.
+         * @param du DU to append.
+         */
+        void append(std::unique_ptr<const base_du> du)
+        {
+            if(!du){
+                return;
+            }
+
+            total += du->totalSize();
+            count += du->length();
+            const base_du* end = du.get();
+            while(end->ptr){
+                end = end->ptr.get();
+            }
+            if(last != nullptr){
+                last->ptr = std::move(du);
+            }else{
+                head = std::move(du);
+            }
+            last = end;
+        }
+
+        /**
+         * Take the chain, leaving the builder empty.
+         * @return Chain of the appended DUs, nullptr if none were appended.
+         */
+        std::unique_ptr<const base_du> take()
+        {
+            size_t remaining = total;
+            size_t after = count;
+            for(const base_du* du = head.get(); du != nullptr; du = du->ptr.get()){
+                remaining -= du->size();
+                du->tail_size = remaining;
+                du->tail_length = --after;
+            }
+            last = nullptr;
+            total = 0;
+            count = 0;
+            return std::move(head);
+        }
+
+        /**
+         * Release the appended DUs.
+         */
+        void clear()
+        {
+            head.reset();
+            last = nullptr;
+            total = 0;
+            count = 0;
+        }
+
+        /**
+         * Check if DUs have been appended.
+         * @return true if the chain is empty, false otherwise.
+         */
+        bool empty() const
+        {
+            return !head;
+        }
+
+        /**
+         * Get the total size of the appended DUs.
+         * @return Size in bytes.
+         */
+        size_t size() const
+        {
+            return total;
+        }
+
     private:
-        std::unique_ptr<const base_du> ptr; ///< Link list of DU.
+        std::unique_ptr<const base_du> head;  ///< First DU of the chain.
+        const base_du*                 last;  ///< Last DU of the chain.
+        size_t                         total; ///< Total size of the chain in bytes.
+        size_t                         count; ///< Number of DUs in the chain.
 };
 
 /**
@@ -163,7 +460,7 @@ class buffered_du : public base_du {
          */
         buffered_du(void* buf, size_t len) :
             buffer(buf),
-            length(len)
+            buffer_length(len)
         {}
 
         /**
@@ -172,7 +469,7 @@ class buffered_du : public base_du {
          */
         virtual size_t size() const override
         {
-            return length;
+            return buffer_length;
         }
 
         /**
@@ -203,8 +500,142 @@ class buffered_du : public base_du {
         }
     
     private:
-        void*  buffer; ///< Buffer for the DU.
-        size_t length; ///< Length of buffer in bytes.
+        void*  buffer;        ///< Buffer for the DU.
+        size_t buffer_length; ///< Length of buffer in bytes.
+};
+
+/**
+ * Zero-copy view into a buffer with shared ownership.
+ * The owner of the buffer is kept alive as long as the view exists.
+ */
+class view_du : public base_du {
+    public:
+        /**
+         * Constructor.
+         * @param owner Owner of the buffer.
+         * @param buf Buffer containing opaque data.
+         * @param len Length of buf in bytes.
+         */
+        view_du(std::shared_ptr<const void> owner, const void* buf, size_t len) :
+            owner(std::move(owner)),
+            buffer(buf),
+            buffer_length(len)
+        {}
+
+        /**
+         * Get the size of the buffer in bytes.
+         * @return Buffer size in bytes.
+         */
+        virtual size_t size() const override
+        {
+            return buffer_length;
+        }
+
+        /**
+         * Access the buffer.
+         * @return Pointer to the buffer.
+         */
+        virtual const void* get() const override
+        {
+            return buffer;
+        }
+
+    private:
+        std::shared_ptr<const void> owner;         ///< Owner of the buffer.
+        const void*                 buffer;        ///< Buffer for the DU.
+        size_t                      buffer_length; ///< Length of buffer in bytes.
+};
+
+/**
+ * DU owning a variable-length buffer.
+ * Buffers of up to N bytes are stored inline in the DU node, so a small
+ * DU is a single allocation.  Larger buffers are allocated from the DU
+ * allocator.
+ * @tparam N Size of the inline buffer in bytes.
+ */
+template<size_t N>
+class owned_du : public base_du {
+    public:
+        /**
+         * Size of the inline buffer in bytes.
+         */
+        static constexpr size_t INLINE_SIZE = N;
+
+        /**
+         * Constructor.
+         * @param len Length of the buffer in bytes, the contents are uninitialized.
+         */
+        owned_du(size_t len) :
+            buffer((len <= N) ? storage : static_cast<uint8_t*>(base_du::allocate(len))),
+            buffer_length(len)
+        {}
+
+        /**
+         * Constructor.
+         * @param buf Data to copy into the buffer.
+         * @param len Length of buf in bytes.
+         */
+        owned_du(const void* buf, size_t len) :
+            owned_du(len)
+        {
+            if(len > 0){
+                memcpy(buffer, buf, len);
+            }
+        }
+
+        /**
+         * Destructor.
+         */
+        virtual ~owned_du()
+        {
+            if(buffer != storage){
+                base_du::deallocate(buffer, buffer_length);
+            }
+        }
+
+        owned_du(const owned_du&) = delete;
+        owned_du& operator=(const owned_du&) = delete;
+
+        /**
+         * Get the size of the buffer in bytes.
+         * @return Buffer size in bytes.
+         */
+        virtual size_t size() const override
+        {
+            return buffer_length;
+        }
+
+        /**
+         * Access the buffer.
+         * @return Pointer to the buffer.
+         */
+        virtual const void* get() const override
+        {
+            return buffer;
+        }
+
+        /**
+         * Access the buffer to fill it.
+         * @return Pointer to the buffer.
+         */
+        uint8_t* data()
+        {
+            return buffer;
+        }
+
+        /**
+         * Check if the buffer is stored inline.
+         * @return true if the buffer is inline, false if it was allocated.
+         */
+        bool inlined() const
+        {
+            return buffer == storage;
+        }
+
+    private:
+        uint8_t*                          buffer;        ///< Buffer for the DU.
+        size_t                            buffer_length; ///< Length of buffer in bytes.
+        alignas(std::max_align_t) uint8_t storage[N];    ///< Inline buffer.
 };
 
 /**
@@ -276,6 +707,43 @@ class base_service {
          * @retval other if failure.
          */
         virtual ccsds::error transfer(std::unique_ptr<const base_du> du) = 0;
+
+        /**
+         * Transfer a batch of DUs from another service.
+         * The default implementation transfers each DU in order.
+         * @param dus DUs to transfer, each DU is released once transferred.
+         * @param count Number of DUs in dus.
+         * @retval error::code::NONE if successful.
+         * @retval other if failure, DUs not transferred remain in dus.
+         */
+        virtual ccsds::error transfer_batch(std::unique_ptr<const base_du> dus[], size_t count);
+
+        /**
+         * Callback function for a completed asynchronous transfer.
+         * @param result Result of the transfer.
+         */
+        typedef ccsds::callback<void(ccsds::error result)> completion;
+
+        /**
+         * Transfer a DU from another service without waiting for the subnetwork.
+         * If the DU is accepted, done is called exactly once with the result
+         * of the transfer, possibly before this function returns and
+         * possibly from another thread.  The default implementation
+         * transfers the DU synchronously.
+         * @param du DU to transfer.
+         * @param done Completion callback, may be empty.
+         * @retval error::code::NONE if the DU was accepted.
+         * @retval other if the DU was not accepted, done is not called.
+         */
+        virtual ccsds::error transfer_async(std::unique_ptr<const base_du> du, completion done);
+
+        /**
+         * Get the number of DUs the service can accept without blocking or
+         * overflowing, so producers can throttle before they are rejected.
+         * The default implementation has unlimited credit.
+         * @return Number of DUs, SIZE_MAX if unlimited.
+         */
+        virtual size_t credit() const;
 };
 
 /**
@@ -283,18 +751,28 @@ class base_service {
  * @param x Original endian uint16.
  * @return Swapped endian uint16.
  */
-inline uint16_t swaps(uint16_t x)
+constexpr uint16_t swaps(uint16_t x)
 {
     return ((x & 0xFF) << 8) | ((x >> 8) & 0xFF);
 }
 
+/**
+ * Swap uint64 to endianness.
+ * @param x Original endian uint64.
+ * @return Swapped endian uint64.
+ */
+constexpr uint64_t swapll(uint64_t x)
+{
+    return __builtin_bswap64(x);
+}
+
 #if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
     /**
      * Convert uint16 to big endian.
      * @param x Little endian uint16.
      * @return Big endian uint16.
      */
-    inline uint16_t htons(uint16_t x)
+    constexpr uint16_t htons(uint16_t x)
     {
         return ccsds::swaps(x);
     }
@@ -304,17 +782,47 @@ inline uint16_t swaps(uint16_t x)
      * @param x Big endian uint16.
      * @return Little endian uint16.
      */
-    inline uint16_t ntohs(uint16_t x)
+    constexpr uint16_t ntohs(uint16_t x)
     {
         return ccsds::swaps(x);
     }
+
+    /**
+     * Convert uint64 to big endian.
+     * @param x Little endian uint64.
+     * @return Big endian uint64.
+     */
+    constexpr uint64_t htonll(uint64_t x)
+    {
+        return ccsds::swapll(x);
+    }
+
+    /**
+     * Convert uint64 to little endian.
+     * @param x Big endian uint64.
+     * @return Little endian uint64.
+     */
+    constexpr uint64_t ntohll(uint64_t x)
+    {
+        return ccsds::swapll(x);
+    }
 #elif (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
-    inline uint16_t htons(uint16_t x)
+    constexpr uint16_t htons(uint16_t x)
     {
         return x;
     }
 
-    inline uint16_t ntohs(uint16_t x)
+    constexpr uint16_t ntohs(uint16_t x)
+    {
+        return x;
+    }
+
+    constexpr uint64_t htonll(uint64_t x)
+    {
+        return x;
+    }
+
+    constexpr uint64_t ntohll(uint64_t x)
     {
         return x;
     }
@@ -324,3 +832,5 @@ inline uint16_t swaps(uint16_t x)
 
 /** @} */ // group ccsds
 } // namespace ccsds
+
+#endif // CCSDS_COMMON_H_
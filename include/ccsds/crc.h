@@ -0,0 +1,81 @@
+/**
+ * @file ccsds/crc.h
+ * CRC-16-CCITT
+ */
+
+#ifndef CCSDS_CRC_H_
+#define CCSDS_CRC_H_
+
+#include "ccsds/common.h"
+#include <cstddef>
+#include <cstdint>
+
+namespace ccsds {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+/**
+ * Initial value of the CRC-16-CCITT.
+ */
+constexpr uint16_t CRC16_INIT = 0xFFFF;
+
+/**
+ * CRC-16-CCITT polynomial, including the x^16 term.
+ */
+constexpr uint32_t CRC16_POLY = 0x11021;
+
+/**
+ * CRC-16-CCITT lookup table built at compile time.
+ */
+struct crc16_octet_table {
+    uint16_t table[256]; ///< CRC of each octet.
+
+    /**
+     * Constructor, builds the table.
+     */
+    constexpr crc16_octet_table() :
+        table{}
+    {
+        for(uint32_t v = 0; v < 256; ++v){
+            uint32_t crc = v << 8;
+            for(int bit = 0; bit < 8; ++bit){
+                crc = (crc & 0x8000) ? ((crc << 1) ^ CRC16_POLY) : (crc << 1);
+            }
+            table[v] = static_cast<uint16_t>(crc);
+        }
+    }
+};
+
+/**
+ * CRC-16-CCITT lookup table, usable in constant expressions and by
+ * targets that do not link the library.
+ */
+inline constexpr crc16_octet_table CRC16_TABLE{};
+
+/**
+ * Compute the CRC-16-CCITT of a buffer.
+ * The polynomial is x^16 + x^12 + x^5 + 1, without reflection or a final
+ * XOR, as used by the packet error control field.  A buffer followed by
+ * its CRC in big endian has a CRC of 0.  Large buffers are folded with
+ * carry-less multiplication when the processor supports it.
+ * @param buf Buffer.
+ * @param len Length of buf in bytes.
+ * @param crc CRC of the preceding data, CRC16_INIT to start a new CRC.
+ * @return CRC of the preceding data and buf.
+ */
+uint16_t crc16(const void* buf, size_t len, uint16_t crc = CRC16_INIT);
+
+/**
+ * Compute the CRC-16-CCITT of a DU chain.
+ * @param du First DU of the chain.
+ * @param crc CRC of the preceding data, CRC16_INIT to start a new CRC.
+ * @return CRC of the preceding data and every buffer in the chain.
+ */
+uint16_t crc16(const base_du& du, uint16_t crc = CRC16_INIT);
+
+/** @} */ // group ccsds
+} // namespace ccsds
+
+#endif // CCSDS_CRC_H_
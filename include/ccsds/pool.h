@@ -0,0 +1,131 @@
+/**
+ * @file ccsds/pool.h
+ * Fixed capacity DU pool
+ */
+
+#ifndef CCSDS_POOL_H_
+#define CCSDS_POOL_H_
+
+#include "ccsds/common.h"
+#include <atomic>
+#include <cstdint>
+
+namespace ccsds {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+/**
+ * Fixed capacity, lock-free pool of DU nodes.
+ * Install with base_du::set_allocator() so that DU nodes, such as the
+ * headers created by octet_service::assembly, are allocated without
+ * using the heap.  Requests larger than the block size, or made while
+ * the pool is exhausted, fall back to the heap.
+ * @tparam SIZE Size of each block in bytes.
+ * @tparam COUNT Number of blocks in the pool.
+ */
+template<size_t SIZE, size_t COUNT>
+class du_pool : public du_allocator {
+    static_assert(COUNT > 0);
+    static_assert(COUNT < UINT32_MAX);
+
+    public:
+        /**
+         * Constructor.
+         */
+        du_pool() :
+            head(0)
+        {
+            for(size_t i = 0; i < COUNT; ++i){
+                links[i].store(i + 1, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Destructor.
+         */
+        virtual ~du_pool() = default;
+
+        du_pool(const du_pool&) = delete;
+        du_pool& operator=(const du_pool&) = delete;
+
+        /**
+         * Allocate a block.
+         * @param size Size of the DU in bytes.
+         * @return Pointer to the block, nullptr if size is too large or the pool is empty.
+         */
+        virtual void* allocate(size_t size) noexcept override
+        {
+            if(size > BLOCK_SIZE){
+                return nullptr;
+            }
+
+            uint64_t old = head.load(std::memory_order_acquire);
+            uint64_t top;
+            do{
+                uint32_t index = old & INDEX_MASK;
+                if(index == EMPTY){
+                    return nullptr;
+                }
+                // The tag in the upper half prevents ABA on concurrent pops
+                top = ((old + TAG_INCREMENT) & ~INDEX_MASK) | links[index].load(std::memory_order_relaxed);
+            }while(!head.compare_exchange_weak(old, top, std::memory_order_acquire, std::memory_order_acquire));
+
+            return storage[old & INDEX_MASK];
+        }
+
+        /**
+         * Release a block.
+         * @param p Pointer to the block.
+         * @param size Size of the DU in bytes.
+         * @return true if the block belongs to the pool, false otherwise.
+         */
+        virtual bool deallocate(void* p, size_t size) noexcept override
+        {
+            (void)size;
+            if(!owns(p)){
+                return false;
+            }
+
+            uint32_t index = (static_cast<uint8_t*>(p) - storage[0]) / BLOCK_SIZE;
+            uint64_t old = head.load(std::memory_order_relaxed);
+            uint64_t top;
+            do{
+                links[index].store(old & INDEX_MASK, std::memory_order_relaxed);
+                top = ((old + TAG_INCREMENT) & ~INDEX_MASK) | index;
+            }while(!head.compare_exchange_weak(old, top, std::memory_order_release, std::memory_order_relaxed));
+
+            return true;
+        }
+
+        /**
+         * Check if a pointer belongs to the pool.
+         * @param p Pointer to check.
+         * @return true if p is a block in the pool, false otherwise.
+         */
+        bool owns(const void* p) const
+        {
+            const uint8_t* b = static_cast<const uint8_t*>(p);
+            return (b >= storage[0]) && (b < storage[0] + sizeof(storage));
+        }
+
+    private:
+        /**
+         * Size of each block, rounded up to keep every block aligned.
+         */
+        static constexpr size_t BLOCK_SIZE = (SIZE + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+        static constexpr uint32_t EMPTY         = COUNT;         ///< Index marking the end of the free list.
+        static constexpr uint64_t INDEX_MASK    = 0xFFFFFFFF;    ///< Free list index in head.
+        static constexpr uint64_t TAG_INCREMENT = 0x100000000;   ///< Free list tag increment in head.
+
+        alignas(std::max_align_t) uint8_t storage[COUNT][BLOCK_SIZE]; ///< Block storage.
+        std::atomic<uint32_t>             links[COUNT];               ///< Free list links by block index.
+        std::atomic<uint64_t>             head;                       ///< Free list tag and head index.
+};
+
+/** @} */ // group ccsds
+} // namespace ccsds
+
+#endif // CCSDS_POOL_H_
@@ -0,0 +1,468 @@
+/**
+ * @file ccsds/queue.h
+ * Lock-free DU queues
+ */
+
+#ifndef CCSDS_QUEUE_H_
+#define CCSDS_QUEUE_H_
+
+#include "ccsds/common.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace ccsds {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+/**
+ * Bounded, lock-free, single producer single consumer ring.
+ * @tparam T Type of the ring elements.
+ * @tparam N Capacity of the ring, must be a power of 2.
+ */
+template<typename T, size_t N>
+class spsc_ring {
+    static_assert((N > 0) && ((N & (N - 1)) == 0), "Capacity must be a power of 2");
+
+    public:
+        /**
+         * Capacity of the ring.
+         */
+        static constexpr size_t CAPACITY = N;
+
+        /**
+         * Constructor.
+         */
+        spsc_ring() :
+            head(0),
+            tail(0)
+        {}
+
+        spsc_ring(const spsc_ring&) = delete;
+        spsc_ring& operator=(const spsc_ring&) = delete;
+
+        /**
+         * Add an element to the ring.
+         * @note Must only be called from the producer thread.
+         * @param value Element to add, only moved from if successful.
+         * @return true if successful, false if the ring is full.
+         */
+        bool push(T& value)
+        {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if(t - head.load(std::memory_order_acquire) == N){
+                return false;
+            }
+            slots[t & (N - 1)] = std::move(value);
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Remove an element from the ring.
+         * @note Must only be called from the consumer thread.
+         * @param value Set to the removed element if successful.
+         * @return true if successful, false if the ring is empty.
+         */
+        bool pop(T& value)
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            if(h == tail.load(std::memory_order_acquire)){
+                return false;
+            }
+            value = std::move(slots[h & (N - 1)]);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Get the number of elements in the ring.
+         * @return Number of elements, may be stale if called from other threads.
+         */
+        size_t size() const
+        {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+        }
+
+    private:
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;  ///< Next element to remove.
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;  ///< Next element to add.
+        alignas(CACHE_LINE_SIZE) std::array<T, N>    slots; ///< Ring storage.
+};
+
+/**
+ * Bounded, lock-free, multiple producer single consumer ring.
+ * @tparam T Type of the ring elements.
+ * @tparam N Capacity of the ring, must be a power of 2.
+ */
+template<typename T, size_t N>
+class mpsc_ring {
+    static_assert((N > 0) && ((N & (N - 1)) == 0), "Capacity must be a power of 2");
+
+    public:
+        /**
+         * Capacity of the ring.
+         */
+        static constexpr size_t CAPACITY = N;
+
+        /**
+         * Constructor.
+         */
+        mpsc_ring() :
+            head(0),
+            tail(0)
+        {
+            for(size_t i = 0; i < N; ++i){
+                cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        mpsc_ring(const mpsc_ring&) = delete;
+        mpsc_ring& operator=(const mpsc_ring&) = delete;
+
+        /**
+         * Add an element to the ring.
+         * @note May be called from any thread.
+         * @param value Element to add, only moved from if successful.
+         * @return true if successful, false if the ring is full.
+         */
+        bool push(T& value)
+        {
+            size_t t = tail.load(std::memory_order_relaxed);
+            cell* c;
+            while(true){
+                c = &cells[t & (N - 1)];
+                size_t seq = c->sequence.load(std::memory_order_acquire);
+                intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(t);
+                if(diff == 0){
+                    // Cell is free, claim it
+                    if(tail.compare_exchange_weak(t, t + 1, std::memory_order_relaxed)){
+                        break;
+                    }
+                }else if(diff < 0){
+                    return false;
+                }else{
+                    t = tail.load(std::memory_order_relaxed);
+                }
+            }
+            c->value = std::move(value);
+            c->sequence.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Remove an element from the ring.
+         * @note Must only be called from the consumer thread.
+         * @param value Set to the removed element if successful.
+         * @return true if successful, false if the ring is empty.
+         */
+        bool pop(T& value)
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            cell* c = &cells[h & (N - 1)];
+            if(c->sequence.load(std::memory_order_acquire) != h + 1){
+                return false;
+            }
+            value = std::move(c->value);
+            c->sequence.store(h + N, std::memory_order_release);
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * Get the number of elements in the ring.
+         * @return Number of elements, may be stale if called from other threads.
+         */
+        size_t size() const
+        {
+            size_t t = tail.load(std::memory_order_acquire);
+            size_t h = head.load(std::memory_order_acquire);
+            return (t > h) ? (t - h) : 0;
+        }
+
+    private:
+        /**
+         * Ring cell.
+         */
+        struct cell {
+            std::atomic<size_t> sequence; ///< Position of the cell in the ring.
+            T                   value;    ///< Element in the cell.
+        };
+
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> head;  ///< Next element to remove.
+        alignas(CACHE_LINE_SIZE) std::atomic<size_t> tail;  ///< Next element to add.
+        alignas(CACHE_LINE_SIZE) std::array<cell, N> cells; ///< Ring storage.
+};
+
+/**
+ * Idle wait of a consumer thread.
+ * The consumer polls a bounded number of times, then sleeps until a
+ * producer notifies it.  Producers only take the lock when the consumer
+ * is asleep, so notifying a busy consumer costs one atomic operation.
+ */
+class parker {
+    public:
+        /**
+         * Number of empty polls before the consumer sleeps.
+         */
+        static constexpr unsigned SPINS = 128;
+
+        /**
+         * Constructor.
+         */
+        parker() :
+            sleeping(0),
+            polls(0)
+        {}
+
+        parker(const parker&) = delete;
+        parker& operator=(const parker&) = delete;
+
+        /**
+         * Wait after an empty poll of the consumer.
+         * Yields for the first SPINS calls in a row, then sleeps until
+         * ready returns true.
+         * @note Must only be called from the consumer thread.
+         * @param ready Returns true once there is work or the consumer must
+         * stop.
+         */
+        template<typename PREDICATE>
+        void idle(const PREDICATE& ready)
+        {
+            if(++polls < SPINS){
+                std::this_thread::yield();
+                return;
+            }
+            polls = 0;
+            std::unique_lock<std::mutex> guard(lock);
+            // Read-modify-writes of sleeping order it against notify(): the
+            // work published before a notify() that misses the flag is seen
+            // by ready
+            sleeping.exchange(1, std::memory_order_acq_rel);
+            wake.wait(guard, ready);
+            sleeping.store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * Reset the idle count after a poll that found work.
+         * @note Must only be called from the consumer thread.
+         */
+        void busy()
+        {
+            polls = 0;
+        }
+
+        /**
+         * Wake the consumer if it sleeps, after publishing work.
+         * @note May be called from any thread.
+         */
+        void notify()
+        {
+            if(sleeping.fetch_add(0, std::memory_order_acq_rel) != 0){
+                std::lock_guard<std::mutex> guard(lock);
+                wake.notify_one();
+            }
+        }
+
+        /**
+         * Wake the consumer unconditionally, to stop it.
+         */
+        void interrupt()
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            wake.notify_all();
+        }
+
+    private:
+        std::mutex              lock;     ///< Guards sleeping on wake.
+        std::condition_variable wake;     ///< Signalled by producers.
+        std::atomic<unsigned>   sleeping; ///< 1 if the consumer sleeps or is about to.
+        unsigned                polls;    ///< Empty polls in a row.
+};
+
+/**
+ * DU queued for transfer.
+ */
+struct queued_du {
+    std::unique_ptr<const ccsds::base_du> du;   ///< DU to transfer.
+    ccsds::base_service::completion       done; ///< Completion callback.
+};
+
+/**
+ * Asynchronous CCSDS service stage.
+ * DUs transferred to the service are queued without blocking and passed
+ * on to the subnetwork by process(), either called by the user or by a
+ * drain thread started with start().  Completion callbacks of
+ * asynchronous transfers are called by process().
+ * @tparam RING Ring type holding queued_du.
+ */
+template<typename RING>
+class queue_service : public ccsds::base_service {
+    public:
+        /**
+         * Constructor.
+         * @param subnetwork Subnetwork to transmit DUs on.
+         */
+        queue_service(ccsds::base_service* subnetwork) :
+            subnetwork(subnetwork),
+            running(false),
+            failures(0)
+        {}
+
+        /**
+         * Destructor.
+         */
+        virtual ~queue_service()
+        {
+            stop();
+        }
+
+        /**
+         * Queue a DU from another service.
+         * @param du DU to transfer.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_SPACE if the queue is full.
+         */
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override
+        {
+            return transfer_async(std::move(du), nullptr);
+        }
+
+        /**
+         * Queue a DU from another service with a completion callback.
+         * @param du DU to transfer.
+         * @param done Completion callback, called by process() with the
+         * result of the subnetwork transfer.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_SPACE if the queue is full.
+         */
+        virtual ccsds::error transfer_async(std::unique_ptr<const ccsds::base_du> du, completion done) override
+        {
+            queued_du entry = {std::move(du), done};
+            if(!ring.push(entry)){
+                return error(error::code::NO_SPACE);
+            }
+            waiter.notify();
+            return error();
+        }
+
+        /**
+         * Get the number of DUs that can be queued.
+         * @return Free space in the queue, may be stale if called from other threads.
+         */
+        virtual size_t credit() const override
+        {
+            size_t used = ring.size();
+            return (used < RING::CAPACITY) ? (RING::CAPACITY - used) : 0;
+        }
+
+        /**
+         * Pass queued DUs on to the subnetwork.
+         * @note Must only be called from one thread at a time.
+         * @param max Maximum number of DUs to pass on.
+         * @return Number of DUs passed on.
+         */
+        size_t process(size_t max = SIZE_MAX)
+        {
+            size_t count = 0;
+            queued_du entry;
+            while((count < max) && ring.pop(entry)){
+                ccsds::error e = error(error::code::NO_NETWORK);
+                if(subnetwork != nullptr){
+                    e = subnetwork->transfer(std::move(entry.du));
+                }
+                if(e){
+                    failures.fetch_add(1, std::memory_order_relaxed);
+                }
+                if(entry.done){
+                    entry.done(e);
+                }
+                ++count;
+            }
+            return count;
+        }
+
+        /**
+         * Start a thread draining the queue to the subnetwork.
+         * The thread sleeps once the queue has been empty for a while and
+         * is woken by the next transfer.
+         */
+        void start()
+        {
+            if(!running.exchange(true)){
+                drain = std::thread([this]{
+                    auto ready = [this]{
+                        return (ring.size() > 0) || !running.load(std::memory_order_acquire);
+                    };
+                    while(running.load(std::memory_order_acquire)){
+                        if(process() == 0){
+                            waiter.idle(ready);
+                        }else{
+                            waiter.busy();
+                        }
+                    }
+                    process();
+                });
+            }
+        }
+
+        /**
+         * Stop the drain thread after passing on the queued DUs.
+         */
+        void stop()
+        {
+            if(running.exchange(false)){
+                waiter.interrupt();
+                drain.join();
+            }
+        }
+
+        /**
+         * Get the number of queued DUs.
+         * @return Number of queued DUs.
+         */
+        size_t size() const
+        {
+            return ring.size();
+        }
+
+        /**
+         * Get the number of DUs the subnetwork failed to transfer.
+         * @return Number of failed transfers.
+         */
+        size_t errors() const
+        {
+            return failures.load(std::memory_order_relaxed);
+        }
+
+    private:
+        ccsds::base_service* subnetwork; ///< Subnetwork to transmit DUs on.
+        RING                 ring;       ///< Queued DUs.
+        std::thread          drain;      ///< Drain thread.
+        parker               waiter;     ///< Idle wait of the drain thread.
+        std::atomic<bool>    running;    ///< Drain thread is running.
+        std::atomic<size_t>  failures;   ///< Number of failed transfers.
+};
+
+/**
+ * Asynchronous CCSDS service stage for a single producer thread.
+ * @tparam N Capacity of the queue, must be a power of 2.
+ */
+template<size_t N>
+using spsc_queue_service = queue_service<spsc_ring<queued_du, N>>;
+
+/**
+ * Asynchronous CCSDS service stage for multiple producer threads.
+ * @tparam N Capacity of the queue, must be a power of 2.
+ */
+template<size_t N>
+using mpsc_queue_service = queue_service<mpsc_ring<queued_du, N>>;
+
+/** @} */ // group ccsds
+} // namespace ccsds
+
+#endif // CCSDS_QUEUE_H_
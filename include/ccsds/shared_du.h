@@ -0,0 +1,175 @@
+/**
+ * @file ccsds/shared_du.h
+ * Reference counted shared DU payloads
+ */
+
+#ifndef CCSDS_SHARED_DU_H_
+#define CCSDS_SHARED_DU_H_
+
+#include "ccsds/common.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ccsds {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+/**
+ * Immutable DU chain shared by several views.
+ * The chain is kept alive by an intrusive reference count, held by every
+ * shared_du viewing it, and destroyed when the last reference is
+ * released.  Unless the payload is concurrent the count is not atomic,
+ * so every reference must then be released from the same thread.
+ */
+class shared_payload {
+    public:
+        /**
+         * Share a DU chain.
+         * @param du DU chain to share.
+         * @param concurrent References may be released from multiple threads.
+         * @return Payload holding one reference.
+         */
+        static shared_payload* create(std::unique_ptr<const base_du> du, bool concurrent = false);
+
+        shared_payload(const shared_payload&) = delete;
+        shared_payload& operator=(const shared_payload&) = delete;
+
+        /**
+         * Add a reference.
+         */
+        void acquire() const
+        {
+            if(concurrent){
+                refs.fetch_add(1, std::memory_order_relaxed);
+            }else{
+                refs.store(refs.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Release a reference, destroying the payload with the last one.
+         */
+        void release() const
+        {
+            uint32_t count;
+            if(concurrent){
+                count = refs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+            }else{
+                count = refs.load(std::memory_order_relaxed) - 1;
+                refs.store(count, std::memory_order_relaxed);
+            }
+            if(count == 0){
+                delete this;
+            }
+        }
+
+        /**
+         * Get the number of references.
+         * @return Number of references.
+         */
+        uint32_t references() const
+        {
+            return refs.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * Access the shared DU chain.
+         * @return First DU of the chain.
+         */
+        const base_du& chain() const
+        {
+            return *data;
+        }
+
+    private:
+        /**
+         * Constructor.
+         * @param du DU chain to share.
+         * @param concurrent References may be released from multiple threads.
+         */
+        shared_payload(std::unique_ptr<const base_du> du, bool concurrent) :
+            data(std::move(du)),
+            refs(1),
+            concurrent(concurrent)
+        {}
+
+        /**
+         * Destructor.
+         */
+        ~shared_payload() = default;
+
+        std::unique_ptr<const base_du> data;       ///< Shared DU chain.
+        mutable std::atomic<uint32_t>  refs;       ///< Number of references.
+        bool                           concurrent; ///< Reference count is updated atomically.
+};
+
+/**
+ * Zero-copy view into a buffer of a shared payload.
+ * Holds a reference to the payload as long as the view exists, so the
+ * same bytes can appear in the DU chains of several consumers.
+ */
+class shared_du : public base_du {
+    public:
+        /**
+         * Constructor.
+         * @param payload Payload owning the buffer.
+         * @param buf Buffer within the payload.
+         * @param len Length of buf in bytes.
+         */
+        shared_du(const shared_payload& payload, const void* buf, size_t len) :
+            payload(&payload),
+            buffer(buf),
+            buffer_length(len)
+        {
+            payload.acquire();
+        }
+
+        /**
+         * Destructor.
+         */
+        virtual ~shared_du()
+        {
+            payload->release();
+        }
+
+        shared_du(const shared_du&) = delete;
+        shared_du& operator=(const shared_du&) = delete;
+
+        /**
+         * Make a chain of views of every buffer of a payload.
+         * @param payload Payload to view.
+         * @return DU chain with the same contents as the shared chain.
+         */
+        static std::unique_ptr<const base_du> share(const shared_payload& payload);
+
+        /**
+         * Get the size of the buffer in bytes.
+         * @return Buffer size in bytes.
+         */
+        virtual size_t size() const override
+        {
+            return buffer_length;
+        }
+
+        /**
+         * Access the buffer.
+         * @return Pointer to the buffer.
+         */
+        virtual const void* get() const override
+        {
+            return buffer;
+        }
+
+    private:
+        const shared_payload* payload;       ///< Payload owning the buffer.
+        const void*           buffer;        ///< Buffer for the DU.
+        size_t                buffer_length; ///< Length of buffer in bytes.
+};
+
+/** @} */ // group ccsds
+} // namespace ccsds
+
+#endif // CCSDS_SHARED_DU_H_
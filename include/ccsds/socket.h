@@ -0,0 +1,101 @@
+/**
+ * @file ccsds/socket.h
+ * Socket subnetwork
+ */
+
+#ifndef CCSDS_SOCKET_H_
+#define CCSDS_SOCKET_H_
+
+#include "ccsds/common.h"
+
+namespace ccsds {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+/**
+ * Subnetwork transmitting DUs on a connected POSIX socket.
+ * Each DU chain is handed to the socket with scatter-gather I/O, so the
+ * chained buffers are not copied into a staging buffer.  On datagram
+ * sockets (UDP) each DU is sent as one datagram, on stream sockets (TCP)
+ * DUs are written back to back.
+ * @note The caller is responsible for opening and closing the socket.
+ */
+class socket_service : public ccsds::base_service {
+    public:
+        /**
+         * Maximum number of segments written with one system call.
+         */
+        static constexpr size_t MAX_SEGMENTS = 64;
+
+        /**
+         * Constructor.
+         * @param fd Connected socket.
+         */
+        socket_service(int fd);
+
+        /**
+         * Destructor.
+         */
+        virtual ~socket_service() = default;
+
+        /**
+         * Transfer a DU from another service.
+         * @param du DU to transfer.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if the socket is not valid.
+         * @retval error::code::INVALID_ARG if a datagram has more than MAX_SEGMENTS segments.
+         * @retval error::code::NO_SPACE if the socket is non-blocking and
+         * full, no part of the DU was written.
+         * @retval error::code::IO_ERROR if writing to the socket failed.
+         */
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override;
+
+        /**
+         * Transfer a batch of DUs from another service.
+         * On stream sockets the DUs are coalesced into as few writes as possible.
+         * @param dus DUs to transfer, each DU is released once transferred.
+         * @param count Number of DUs in dus.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if the socket is not valid.
+         * @retval error::code::INVALID_ARG if a datagram has more than MAX_SEGMENTS segments.
+         * @retval error::code::NO_SPACE if the socket is non-blocking and
+         * full, the DUs not written remain in dus.
+         * @retval error::code::IO_ERROR if writing to the socket failed.
+         */
+        virtual ccsds::error transfer_batch(std::unique_ptr<const ccsds::base_du> dus[], size_t count) override;
+
+    private:
+        /**
+         * Write a chain of more than MAX_SEGMENTS segments to a stream socket.
+         * @param du DU to write.
+         * @param count Number of segments of du.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_SPACE if the socket is full and nothing was written.
+         * @retval error::code::IO_ERROR if writing to the socket failed.
+         */
+        ccsds::error write(const ccsds::base_du& du, size_t count);
+
+        /**
+         * Write segments to the socket.
+         * Once part of the segments is written to a non-blocking stream
+         * socket, a full socket is polled until the rest is written so
+         * that no partial packet is left on the stream.
+         * @param segments Segments to write.
+         * @param count Number of segments, no more than MAX_SEGMENTS.
+         * @param started Part of the DU has already been written.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_SPACE if the socket is full and nothing was written.
+         * @retval error::code::IO_ERROR if writing to the socket failed.
+         */
+        ccsds::error write(ccsds::segment* segments, size_t count, bool started = false);
+
+        int  fd;     ///< Socket to transmit on.
+        bool stream; ///< Socket is a stream socket.
+};
+
+/** @} */ // group ccsds
+} // namespace ccsds
+
+#endif // CCSDS_SOCKET_H_
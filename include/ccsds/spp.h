@@ -8,8 +8,11 @@
 #define CCSDS_SPP_H_
 
 #include "ccsds/common.h"
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace ccsds {
 namespace spp {
@@ -52,6 +55,17 @@ struct space_packet {
 
 static_assert(sizeof(space_packet) == 6);
 
+/**
+ * Space Packet Error Control field, trailing the packet data field.
+ */
+struct packet_error_control {
+    uint16_t crc; ///< CRC-16-CCITT of the rest of the packet, big endian.
+};
+
+static_assert(sizeof(packet_error_control) == 2);
+
+#pragma pack(pop)
+
 /**
  * Space Packet Protocol Data Unit (PDU).
  * @requirement SPP-14
@@ -75,6 +89,282 @@ enum packet_type : bool {
     TELECOMMAND = 1, ///< Telecommand packet type.
 };
 
+/**
+ * Primary header identification assembly helpers.
+ */
+enum {
+    PACKET_VERSION_1     = 0b000, ///< Packet version number.
+    PACKET_VERSION_SHIFT = 13,    ///< Packet version shift in identification field.
+    PACKET_TYPE_MASK     = 0x1,   ///< Packet type mask in identification field.
+    PACKET_TYPE_SHIFT    = 12,    ///< Packet type shift in identification field.
+    PACKET_SEC_HDR_SHIFT = 11,    ///< Packet secondary header flag shift in identification field.
+    PACKET_APID_MASK     = 0x7FF, ///< APID mask in identification field.
+};
+
+/**
+ * Primary header sequence assembly helpers.
+ */
+enum {
+    SEQUENCE_CONTINUATION = 0b00,   ///< Continuation segment of user data flag.
+    SEQUENCE_FIRST        = 0b01,   ///< First segment of user data flag.
+    SEQUENCE_LAST         = 0b10,   ///< Last segment of user data flag.
+    SEQUENCE_UNSEGMENTED  = 0b11,   ///< Unsegmented user data flag.
+    SEQUENCE_FLAGS_SHIFT  = 14,     ///< Sequence flags shift in sequence_control field.
+    SEQUENCE_COUNT_MASK   = 0x3FFF, ///< Sequence count mask in sequence_control field.
+};
+
+/**
+ * Maximum length of the packet data field in bytes.
+ */
+constexpr size_t MAX_DATA_LENGTH = 65536;
+
+/**
+ * Length of the packet data field stored inline in a packet_du in bytes.
+ */
+constexpr size_t SMALL_DATA_LENGTH = 64;
+
+/**
+ * Space packet with the primary header and packet data field in one buffer.
+ * Packets with a data field of up to SMALL_DATA_LENGTH bytes are a single
+ * DU node without a separate buffer.
+ */
+typedef ccsds::owned_du<sizeof(primary_header) + SMALL_DATA_LENGTH> packet_du;
+
+/**
+ * Encode the identification field of a primary header.
+ * @param id APID of the packet.
+ * @param type Packet type.
+ * @param secondary Secondary header indicator.
+ * @return Identification field in network byte order.
+ */
+constexpr uint16_t identification(apid id, packet_type type, bool secondary)
+{
+    return ccsds::htons(
+            (PACKET_VERSION_1 << PACKET_VERSION_SHIFT)         // packet version number
+            | ((type & PACKET_TYPE_MASK) << PACKET_TYPE_SHIFT) // packet type
+            | ((!!secondary) << PACKET_SEC_HDR_SHIFT)          // secondary header flag
+            | (id & PACKET_APID_MASK));                        // APID
+}
+
+/**
+ * Encode the sequence control field of a primary header.
+ * @param flags Sequence flags.
+ * @param count Packet sequence count or packet name.
+ * @return Sequence control field in network byte order.
+ */
+constexpr uint16_t sequence_control(uint16_t flags, uint16_t count)
+{
+    return ccsds::htons(
+            (flags << SEQUENCE_FLAGS_SHIFT)      // sequence flags
+            | (count & SEQUENCE_COUNT_MASK));    // packet sequence count
+}
+
+/**
+ * Non-owning view of a space packet in an existing buffer.
+ * The primary header is overlaid on the buffer without copying it, so
+ * packets in DMA regions or mapped files can be received without
+ * allocating a PDU.  The buffer must outlive the view.
+ */
+class packet_view {
+    public:
+        /**
+         * Constructor.
+         * @param buf Buffer starting with a space packet.
+         * @param len Length of buf in bytes.
+         */
+        packet_view(const void* buf, size_t len) :
+            buffer(static_cast<const uint8_t*>(buf)),
+            buffer_length(len)
+        {}
+
+        /**
+         * Check the buffer holds a complete version 1 space packet.
+         * @return true if the packet is valid, false otherwise.
+         */
+        bool valid() const
+        {
+            return (buffer_length >= sizeof(primary_header))
+                    && (version() == PACKET_VERSION_1)
+                    && (size() <= buffer_length);
+        }
+
+        /**
+         * Access the primary header.
+         * @warning The buffer must hold at least a primary header.
+         * @return Primary header overlaid on the buffer.
+         */
+        const primary_header& header() const
+        {
+            return *reinterpret_cast<const primary_header*>(buffer);
+        }
+
+        /**
+         * Get the packet version number.
+         * @return Packet version number.
+         */
+        uint16_t version() const
+        {
+            return ccsds::ntohs(header().identification) >> PACKET_VERSION_SHIFT;
+        }
+
+        /**
+         * Get the packet type.
+         * @return Packet type.
+         */
+        packet_type type() const
+        {
+            return static_cast<packet_type>((ccsds::ntohs(header().identification) >> PACKET_TYPE_SHIFT) & PACKET_TYPE_MASK);
+        }
+
+        /**
+         * Get the secondary header flag.
+         * @return true if the packet has a secondary header, false otherwise.
+         */
+        bool secondary() const
+        {
+            return (ccsds::ntohs(header().identification) >> PACKET_SEC_HDR_SHIFT) & 1;
+        }
+
+        /**
+         * Get the APID.
+         * @return APID of the packet.
+         */
+        apid id() const
+        {
+            return static_cast<apid>(ccsds::ntohs(header().identification) & PACKET_APID_MASK);
+        }
+
+        /**
+         * Get the sequence control field.
+         * @return Sequence control field in host byte order.
+         */
+        uint16_t sequence() const
+        {
+            return ccsds::ntohs(header().sequence_control);
+        }
+
+        /**
+         * Get the sequence flags.
+         * @return Sequence flags.
+         */
+        uint16_t flags() const
+        {
+            return sequence() >> SEQUENCE_FLAGS_SHIFT;
+        }
+
+        /**
+         * Get the packet sequence count or packet name.
+         * @return Packet sequence count.
+         */
+        uint16_t count() const
+        {
+            return sequence() & SEQUENCE_COUNT_MASK;
+        }
+
+        /**
+         * Get the length of the packet data field.
+         * @return Length of the packet data field in bytes.
+         */
+        size_t data_length() const
+        {
+            return ccsds::ntohs(header().data_length) + 1;
+        }
+
+        /**
+         * Get the size of the packet.
+         * @return Size of the packet in bytes, including the primary header.
+         */
+        size_t size() const
+        {
+            return sizeof(primary_header) + data_length();
+        }
+
+        /**
+         * Access the packet data field.
+         * @return Pointer to the packet data field.
+         */
+        const uint8_t* data() const
+        {
+            return buffer + sizeof(primary_header);
+        }
+
+        /**
+         * Access the packet.
+         * @return Pointer to the start of the packet.
+         */
+        const void* get() const
+        {
+            return buffer;
+        }
+
+        /**
+         * Get the length of the viewed buffer.
+         * @return Length of the buffer in bytes.
+         */
+        size_t buffer_size() const
+        {
+            return buffer_length;
+        }
+
+    private:
+        const uint8_t* buffer;        ///< Buffer starting with the packet.
+        size_t         buffer_length; ///< Length of buffer in bytes.
+};
+
+class priority_scheduler;
+class statistics;
+
+/**
+ * Packet sequence count tracker of one APID.
+ * Keeps a sliding window of the most recent packet sequence counts as a
+ * bitmap of missing packets behind the latest packet.  Packets arriving
+ * out of order within the reorder tolerance fill their place in the
+ * window, a packet is only counted as lost once it falls out of the
+ * window.  A packet further behind than the tolerance is taken as a
+ * restart of the sequence.  Each update takes constant time.
+ */
+class sequence_tracker {
+    public:
+        /**
+         * Maximum reorder tolerance in packets.
+         */
+        static constexpr uint8_t MAX_TOLERANCE = 63;
+
+        /**
+         * Result of tracking a packet.
+         */
+        struct status {
+            uint16_t missing; ///< Number of packets found lost by this packet.
+            bool     late;    ///< Packet is out of order or a duplicate.
+        };
+
+        /**
+         * Constructor.
+         */
+        sequence_tracker();
+
+        /**
+         * Track a received packet.
+         * The first packet, and the first after reset(), starts the sequence.
+         * @param count Packet sequence count.
+         * @param tolerance Number of packets a packet may arrive behind
+         * its place in the sequence, at most MAX_TOLERANCE.  With a
+         * tolerance of 0 every gap is counted as lost immediately.
+         * @return Status of the packet.
+         */
+        status update(uint16_t count, uint8_t tolerance);
+
+        /**
+         * Forget the sequence.
+         */
+        void reset();
+
+    private:
+        uint64_t missing; ///< Bit n is set if packet latest - n has not been received.
+        uint16_t latest;  ///< Latest packet sequence count.
+        bool     started; ///< A packet has been received.
+};
+
 /**
  * Space Packet Transmit Service.
  */
@@ -93,15 +383,38 @@ class packet_service : public ccsds::base_service {
 
         /**
          * Send a pre-formatted space packet.
+         * With a scheduler the packet is queued in its QoS class and queued
+         * packets are passed on while the subnetwork has credit, otherwise
+         * the packet is transferred immediately.
          * @requirement SPP-10
          * @param pdu PDU to send.
-         * @param qos Quality of Service requirement.
+         * @param qos Quality of Service requirement, 0 is the highest priority.
          * @requirement SPP-5
          * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if a subnetwork has not been configured.
+         * @retval error::code::INVALID_ARG if qos is not a class of the scheduler.
+         * @retval error::code::NO_SPACE if the QoS class is full.
          * @retval other from the subnetwork.
          */
         ccsds::error request(std::unique_ptr<const ccsds::spp::pdu> pdu, int qos = 0);
 
+        /**
+         * Set the scheduler prioritizing requested packets.
+         * SDUs transferred from other services, such as the packets of an
+         * octet service, are queued in the given class.  Services sharing
+         * a scheduler must share the subnetwork.
+         * @param sched Scheduler, or nullptr to transfer packets immediately.
+         * @param qos QoS class of SDUs transferred from other services.
+         */
+        void set_scheduler(priority_scheduler* sched, int qos = 0);
+
+        /**
+         * Pass packets queued by the scheduler on to the subnetwork while it
+         * has credit.  Must be called when the subnetwork regains credit.
+         * @return Number of packets passed on.
+         */
+        size_t process();
+
         /**
          * Callback function for receiving an octet string.
          * @requirement SPP-11
@@ -111,7 +424,7 @@ class packet_service : public ccsds::base_service {
          * @param packet_loss Packet Loss Indicator.
          * @requirement SPP-4
          */
-        typedef void (*indication)(std::unique_ptr<const ccsds::spp::pdu> pdu, apid id, bool packet_loss);
+        typedef ccsds::callback<void(std::unique_ptr<const ccsds::spp::pdu> pdu, apid id, bool packet_loss)> indication;
 
         /**
          * Set the indication callback function.
@@ -121,23 +434,185 @@ class packet_service : public ccsds::base_service {
 
         /**
          * Transfer an SDU from another service.
+         * With a scheduler the SDU is queued in the class set with the
+         * scheduler, as request().
          * @requirement SPP-20
          * @param sdu SDU to transfer.
          * @retval error::code::NO_NETWORK if a subnetwork has not been configured.
+         * @retval error::code::INVALID_ARG if the class is not a class of the scheduler.
+         * @retval error::code::NO_SPACE if the QoS class is full.
          * @retval other from the subnetwork.
          */
         virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override;
 
+        /**
+         * Transfer a batch of SDUs from another service.
+         * With a scheduler the SDUs are queued in order until the class is
+         * full.
+         * @requirement SPP-20
+         * @param sdus SDUs to transfer, each SDU is released once transferred.
+         * @param count Number of SDUs in sdus.
+         * @retval error::code::NO_NETWORK if a subnetwork has not been configured.
+         * @retval error::code::INVALID_ARG if the class is not a class of the scheduler.
+         * @retval error::code::NO_SPACE if the QoS class is full.
+         * @retval other from the subnetwork.
+         */
+        virtual ccsds::error transfer_batch(std::unique_ptr<const ccsds::base_du> sdus[], size_t count) override;
+
+        /**
+         * Transfer an SDU from another service without waiting for the subnetwork.
+         * With a scheduler the SDU is queued in the class set with the
+         * scheduler and the completion is called once it is drained.
+         * @requirement SPP-20
+         * @param sdu SDU to transfer.
+         * @param done Completion callback, may be empty.
+         * @retval error::code::NONE if the SDU was accepted.
+         * @retval error::code::NO_NETWORK if a subnetwork has not been configured.
+         * @retval error::code::INVALID_ARG if the class is not a class of the scheduler.
+         * @retval error::code::NO_SPACE if the QoS class is full.
+         * @retval other from the subnetwork.
+         */
+        virtual ccsds::error transfer_async(std::unique_ptr<const ccsds::base_du> sdu, completion done) override;
+
+        /**
+         * Get the number of SDUs the subnetwork can accept.
+         * @return Credit of the subnetwork, or the free space of the class
+         * set with the scheduler, 0 if a subnetwork has not been configured.
+         */
+        virtual size_t credit() const override;
+
         /**
          * Receive a PDU from the subnetwork.
          * @param pdu PDU to receive.
          */
         void reception(std::unique_ptr<const ccsds::spp::pdu> pdu);
 
+        /**
+         * Callback function for receiving a space packet in place.
+         * @param packet Packet received, only valid until the callback returns.
+         * @param id APID of the packet.
+         * @param packet_loss Packet Loss Indicator.
+         */
+        typedef ccsds::callback<void(const packet_view& packet, apid id, bool packet_loss)> view_indication;
+
+        /**
+         * Set the indication callback function for packets received in place.
+         * @param func Callback function.
+         */
+        void set_view_indication(view_indication func);
+
+        /**
+         * Receive a packet in place from the subnetwork.
+         * @param packet Packet to receive.
+         */
+        void reception(const packet_view& packet);
+
+        /**
+         * Set the statistics to count received packets in.
+         * @param stats Statistics, or nullptr to stop counting.
+         */
+        void set_statistics(statistics* stats);
+
+        /**
+         * Set the number of packets of an APID that may arrive out of
+         * order without being indicated as lost.
+         * Loss is indicated once a missing packet is further behind than
+         * the tolerance, with the packet that moved the window past it.
+         * @param tolerance Reorder tolerance in packets, limited to
+         * sequence_tracker::MAX_TOLERANCE.
+         */
+        void set_reorder_tolerance(uint8_t tolerance);
+
+    private:
+        /**
+         * Check the packet sequence count of a received packet.
+         * @param id APID of the packet.
+         * @param count Packet sequence count.
+         * @param size Size of the packet in bytes.
+         * @return true if packets were lost before this packet, false otherwise.
+         */
+        bool track(apid id, uint16_t count, size_t size);
+
+        /**
+         * Queue a packet in the scheduler and drain it.
+         * @param pdu Packet to queue.
+         * @param qos QoS class of the packet.
+         * @param done Completion callback, may be empty.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if a subnetwork has not been configured.
+         * @retval error::code::INVALID_ARG if qos is not a class of the scheduler.
+         * @retval error::code::NO_SPACE if the QoS class is full.
+         */
+        ccsds::error schedule(std::unique_ptr<const ccsds::base_du> pdu, int qos, completion done);
+
+        ccsds::base_service*                subnetwork;    ///< Subnetwork to transmit packets on.
+        indication                          callback;      ///< Indication callback function.
+        view_indication                     view_callback; ///< Indication callback function for packets received in place.
+        std::unique_ptr<sequence_tracker[]> sequences;     ///< Packet sequence count trackers, by APID.
+        uint8_t                             tolerance;     ///< Reorder tolerance in packets.
+        statistics*                         stats;         ///< Statistics of received packets.
+        priority_scheduler*                 scheduler;     ///< Scheduler of requested packets.
+        int                                 service_qos;   ///< QoS class of SDUs transferred from other services.
+};
+
+/**
+ * Reassembly of segmented user data.
+ * Segments are relinked into a single DU chain without copying the data.
+ */
+class reassembly {
+    public:
+        /**
+         * Constructor.
+         * @param max_length Maximum length of reassembled user data in bytes.
+         * @param timeout Maximum time between the first and last segment.
+         */
+        reassembly(size_t max_length = 16 * MAX_DATA_LENGTH, std::chrono::steady_clock::duration timeout = std::chrono::seconds(10));
+
+        /**
+         * Destructor.
+         */
+        ~reassembly() = default;
+
+        /**
+         * Set the reassembly limits.
+         * @param max_length Maximum length of reassembled user data in bytes.
+         * @param timeout Maximum time between the first and last segment.
+         */
+        void configure(size_t max_length, std::chrono::steady_clock::duration timeout);
+
+        /**
+         * Receive a packet data field.
+         * @param data Packet data field.
+         * @param flags Sequence flags of the packet.
+         * @param loss Packet loss indicator of the packet, set if user data
+         * has been lost since the last complete user data.
+         * @return Complete user data, nullptr if more segments are expected.
+         */
+        std::unique_ptr<const ccsds::base_du> reception(std::unique_ptr<const ccsds::base_du> data, uint16_t flags, bool& loss);
+
+        /**
+         * Discard incomplete user data older than the timeout.
+         * @return true if user data was discarded, false otherwise.
+         */
+        bool expire();
+
+        /**
+         * Check for incomplete user data.
+         * @return true if segments are waiting for the last segment, false otherwise.
+         */
+        bool pending() const;
+
     private:
-        ccsds::base_service* subnetwork; ///< Subnetwork to transmit packets on.
-        indication           callback;   ///< Indication callback function.
-        uint16_t             last_count;  ///< Tracker of last seen count.
+        /**
+         * Discard incomplete user data.
+         */
+        void discard();
+
+        ccsds::du_chain                       segments; ///< Segments of incomplete user data.
+        size_t                                limit;    ///< Maximum length of user data in bytes.
+        std::chrono::steady_clock::duration   timeout;  ///< Maximum time between the first and last segment.
+        std::chrono::steady_clock::time_point start;    ///< Time the first segment was received.
+        bool                                  lost;     ///< User data was lost since the last complete user data.
 };
 
 /**
@@ -150,14 +625,23 @@ class octet_service : public ccsds::base_service {
          * @param id APID of the service.
          * @requirement SPP-7
          * @param subnetwork Subnetwork to transmit packets on.
+         * @param concurrent Allow packets to be requested from multiple threads.
+         * @note In concurrent mode the subnetwork must also accept transfers
+         * from multiple threads.
          */
-        octet_service(apid id, ccsds::base_service* subnetwork);
+        octet_service(apid id, ccsds::base_service* subnetwork, bool concurrent = false);
 
         /**
          * Destructor.
          */
         virtual ~octet_service() = default;
 
+        /**
+         * Get the APID of the service.
+         * @return APID of the service.
+         */
+        apid id() const;
+
         /**
          * Send a space packet using a packet count with the given octet string.
          * @requirement SPP-12
@@ -184,6 +668,100 @@ class octet_service : public ccsds::base_service {
          */
         ccsds::error request(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, uint16_t name);
 
+        /**
+         * Send a space packet using a packet count with a copy of the given octet string.
+         * The primary header and the user data are copied into one
+         * packet_du, so small packets take a single allocation.
+         * @requirement SPP-12
+         * @param buf User data to send.
+         * @param len Length of buf in bytes.
+         * @requirement SPP-6
+         * @param secondary Secondary header indicator.
+         * @requirement SPP-8
+         * @param type Packet type.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if len is 0 or the packet data
+         * field would be longer than MAX_DATA_LENGTH.
+         * @retval other from the subnetwork.
+         */
+        ccsds::error request(const void* buf, size_t len, bool secondary, packet_type type);
+
+        /**
+         * Send a batch of space packets using consecutive packet counts.
+         * The packets are handed to the subnetwork in a single transfer.
+         * @requirement SPP-12
+         * @param sdus SDUs to send, replaced by the assembled PDUs.
+         * @requirement SPP-6
+         * @param count Number of SDUs in sdus.
+         * @param secondary Secondary header indicator.
+         * @requirement SPP-8
+         * @param type Packet type.
+         * @retval error::code::NONE if successful.
+         * @retval other from the subnetwork, PDUs not transferred remain in sdus.
+         */
+        ccsds::error request_batch(std::unique_ptr<const ccsds::base_du> sdus[], size_t count, bool secondary, packet_type type);
+
+        /**
+         * Send user data as segmented space packets using packet counts.
+         * The packets view the user data without copying it, user data that
+         * fits in a single packet is sent unsegmented.
+         * @requirement SPP-12
+         * @param sdu SDU to send.
+         * @requirement SPP-6
+         * @param secondary Secondary header indicator, only set on the first segment.
+         * @requirement SPP-8
+         * @param type Packet type.
+         * @param max_length Maximum length of each packet data field in bytes.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if max_length is 0, greater than MAX_DATA_LENGTH,
+         * or too short to hold the packet error control field.
+         * @retval other from the subnetwork.
+         */
+        ccsds::error request_segmented(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, packet_type type, size_t max_length = MAX_DATA_LENGTH);
+
+        /**
+         * Send a space packet using a packet count without waiting for the subnetwork.
+         * Producers should check credit() to throttle before the subnetwork
+         * rejects packets.
+         * @requirement SPP-12
+         * @param sdu SDU to send.
+         * @requirement SPP-6
+         * @param secondary Secondary header indicator.
+         * @requirement SPP-8
+         * @param type Packet type.
+         * @param done Completion callback, called once the packet has been
+         * transferred unless the packet is not accepted.
+         * @retval error::code::NONE if the packet was accepted.
+         * @retval other from the subnetwork.
+         */
+        ccsds::error request_async(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, packet_type type, completion done);
+
+        /**
+         * Get the number of packets the subnetwork can accept.
+         * @return Credit of the subnetwork, or the free space of the QoS
+         * class with a scheduler.
+         */
+        virtual size_t credit() const override;
+
+        /**
+         * Set the scheduler prioritizing the packets of this service.
+         * Requested packets are queued in the QoS class and passed on with
+         * the other packets of the scheduler while the subnetwork has credit,
+         * a full class rejects requests with error::code::NO_SPACE.  Services
+         * sharing a scheduler must share the subnetwork.
+         * @requirement SPP-5
+         * @param sched Scheduler, or nullptr to transfer packets immediately.
+         * @param qos Quality of Service requirement, 0 is the highest priority.
+         */
+        void set_scheduler(priority_scheduler* sched, int qos = 0);
+
+        /**
+         * Pass packets queued by the scheduler on to the subnetwork while it
+         * has credit.  Must be called when the subnetwork regains credit.
+         * @return Number of packets passed on.
+         */
+        size_t process();
+
         /**
          * Callback function for receiving an octet string.
          * @requirement SPP-13
@@ -193,7 +771,7 @@ class octet_service : public ccsds::base_service {
          * @param data_loss data Loss Indicator.
          * @requirement SPP-9
          */
-        typedef void (*indication)(std::unique_ptr<const ccsds::base_du> sdu, apid id, bool data_loss);
+        typedef ccsds::callback<void(std::unique_ptr<const ccsds::base_du> sdu, apid id, bool data_loss)> indication;
 
         /**
          * Set the indication callback function.
@@ -207,6 +785,62 @@ class octet_service : public ccsds::base_service {
          */
         void reception(std::unique_ptr<ccsds::spp::pdu> pdu);
 
+        /**
+         * Receive a packet in place from the subnetwork.
+         * The SDU passed to the indication views the packet data field
+         * without copying it.
+         * @param packet Packet to receive.
+         * @param owner Owner of the buffer, kept alive by the SDU.  May be
+         * nullptr if the buffer outlives every SDU and segment viewing it.
+         */
+        void reception(const packet_view& packet, std::shared_ptr<const void> owner = nullptr);
+
+        /**
+         * Set the limits for reassembling segmented user data.
+         * @param max_length Maximum length of reassembled user data in bytes.
+         * @param timeout Maximum time between the first and last segment.
+         */
+        void set_reassembly(size_t max_length, std::chrono::steady_clock::duration timeout);
+
+        /**
+         * Discard incomplete user data older than the reassembly timeout.
+         * Otherwise the timeout is only checked when the next segment is
+         * received, call this periodically to free stale segments when
+         * traffic stops.  The next user data received is indicated with
+         * packet loss.
+         * @note Must be called from the thread receiving packets.
+         * @return true if user data was discarded, false otherwise.
+         */
+        bool expire();
+
+        /**
+         * Set the statistics to count received packets in.
+         * @param stats Statistics, or nullptr to stop counting.
+         */
+        void set_statistics(statistics* stats);
+
+        /**
+         * Enable the packet error control field.
+         * Sent packets end with the CRC-16-CCITT of the packet, computed
+         * while assembling the packet.  Received packets with an invalid
+         * CRC are discarded and counted as malformed, the field is removed
+         * from the SDU passed to the indication.
+         * @param enable Use the packet error control field.
+         */
+        void set_error_control(bool enable);
+
+        /**
+         * Set the number of packets that may arrive out of order without
+         * being indicated as lost.
+         * Loss is indicated once a missing packet is further behind than
+         * the tolerance, with the packet that moved the window past it.
+         * Segments arriving out of order still abandon the user data
+         * being reassembled.
+         * @param tolerance Reorder tolerance in packets, limited to
+         * sequence_tracker::MAX_TOLERANCE.
+         */
+        void set_reorder_tolerance(uint8_t tolerance);
+
     private:
         /**
          * Transfer as SDU from another service.
@@ -217,6 +851,24 @@ class octet_service : public ccsds::base_service {
          */
         virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override;
 
+        /**
+         * Transfer as SDU from another service.
+         * @warning The octet service does not allow direct transfers,
+         * @requirement SPP-20
+         * @param sdu SDU to transfer.
+         * @param done Completion callback, not called.
+         * @retval error::code::NO_SUPPORT The octet service does not allow direct transfers,
+         */
+        virtual ccsds::error transfer_async(std::unique_ptr<const ccsds::base_du> sdu, completion done) override;
+
+        /**
+         * Pass the packet data field of a received packet on.
+         * @param sequence Sequence control field in host byte order.
+         * @param size Size of the packet in bytes.
+         * @param data Packet data field.
+         */
+        void receive(uint16_t sequence, size_t size, std::unique_ptr<const ccsds::base_du> data);
+
     protected:
         /**
          * Assemble a space packet with a packet count.
@@ -242,15 +894,86 @@ class octet_service : public ccsds::base_service {
          */
         std::unique_ptr<const ccsds::spp::pdu> assembly(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, uint16_t name);
 
+        /**
+         * Assemble a space packet from encoded header fields.
+         * Appends the packet error control field if it is enabled.
+         * @param sdu Packet to send.
+         * @param identification Identification field in network byte order.
+         * @param sequence_control Sequence control field in network byte order.
+         * @return Newly assembled pace packet.
+         */
+        std::unique_ptr<ccsds::spp::pdu> assemble(std::unique_ptr<const ccsds::base_du> sdu, uint16_t identification, uint16_t sequence_control);
+
+        /**
+         * Reserve packet counts.
+         * @param n Number of packet counts to reserve.
+         * @return First reserved packet count.
+         */
+        uint16_t next_count(uint16_t n = 1);
+
+        packet_service        service;      ///< Underlying packet service
+
     private:
-        packet_service service;      ///< Underlying packet service
-        indication     callback;     ///< Indication callback function.
-        apid           id;           ///< APID for the service.
-        uint16_t       packet_count; ///< Current packet count.
-        uint16_t       last_count;   ///< Tracker of last seen count.
+        indication            callback;     ///< Indication callback function.
+        apid                  service_id;   ///< APID for the service.
+        bool                  concurrent;   ///< Packet counts are reserved atomically.
+        std::atomic<uint16_t> packet_count; ///< Current packet count.
+        sequence_tracker      sequence;     ///< Packet sequence count tracker.
+        uint8_t               tolerance;    ///< Reorder tolerance in packets.
+        reassembly            segments;     ///< Reassembly of segmented user data.
+        statistics*           stats;        ///< Statistics of received packets.
+        bool                  error_control; ///< Packets have a packet error control field.
 };
 
-#pragma pack(pop)
+/**
+ * Space Packet Receive Service with a fixed packet type and secondary
+ * header flag.
+ * The identification field is encoded at compile time, so assembling a
+ * packet only stores the precomputed field and updates the packet count.
+ * @tparam APID APID of the service.
+ * @tparam TYPE Packet type.
+ * @tparam SEC_HDR Secondary header indicator.
+ */
+template<apid APID, packet_type TYPE, bool SEC_HDR>
+class octet_service_t : public octet_service {
+    static_assert(APID <= APID_IDLE, "APID out of range");
+
+    public:
+        /**
+         * Identification field in network byte order.
+         */
+        static constexpr uint16_t IDENTIFICATION = identification(APID, TYPE, SEC_HDR);
+
+        /**
+         * Constructor.
+         * @param subnetwork Subnetwork to transmit packets on.
+         * @param concurrent Allow packets to be requested from multiple threads.
+         */
+        octet_service_t(ccsds::base_service* subnetwork, bool concurrent = false) :
+            octet_service(APID, subnetwork, concurrent)
+        {}
+
+        /**
+         * Destructor.
+         */
+        virtual ~octet_service_t() = default;
+
+        using octet_service::request;
+
+        /**
+         * Send a space packet using a packet count with the given octet string.
+         * @requirement SPP-12
+         * @param sdu SDU to send.
+         * @requirement SPP-6
+         * @retval error::code::NONE if successful.
+         * @retval other from the subnetwork.
+         */
+        ccsds::error request(std::unique_ptr<const ccsds::base_du> sdu)
+        {
+            return service.transfer(assemble(std::move(sdu), IDENTIFICATION,
+                    sequence_control(SEQUENCE_UNSEGMENTED, next_count())));
+        }
+};
 
 /** @} */ // group spp
 } // namespace spp
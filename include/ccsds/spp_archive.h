@@ -0,0 +1,257 @@
+/**
+ * @file ccsds/spp_archive.h
+ * Space Packet archive files
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_ARCHIVE_H_
+#define CCSDS_SPP_ARCHIVE_H_
+
+#include "ccsds/spp.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Space Packet Archive Reader.
+ * Archives are flat files of space packets held back to back.  The file
+ * is memory mapped and packets are handed out as views into the mapping,
+ * so opening an archive does not read it.  The offset of each packet is
+ * kept in an index file next to the archive, named after the archive with
+ * an `.idx` suffix.  The index is built on the first open, and extended
+ * when the archive has grown since.  Only the index is checked on open,
+ * each packet is bounds checked against the archive once it is viewed.
+ * @note Views keep the mapping alive, even after the reader is closed.
+ */
+class archive_reader {
+    public:
+        /**
+         * Constructor.
+         */
+        archive_reader();
+
+        /**
+         * Destructor.
+         */
+        ~archive_reader() = default;
+
+        archive_reader(const archive_reader&) = delete;
+        archive_reader& operator=(const archive_reader&) = delete;
+
+        /**
+         * Open an archive.
+         * @param path Path to the archive.
+         * @param persist Write the index file if it was built or extended.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::IO_ERROR if the archive could not be mapped.
+         */
+        ccsds::error open(const std::string& path, bool persist = true);
+
+        /**
+         * Close the archive.
+         */
+        void close();
+
+        /**
+         * Get the number of complete packets in the archive.
+         * @return Number of packets.
+         */
+        size_t size() const;
+
+        /**
+         * View a packet in the archive.
+         * @param i Index of the packet.
+         * @return Complete space packet, including the primary header, or
+         * nullptr if i is out of range or the packet runs past the end of
+         * the archive.
+         */
+        std::unique_ptr<const ccsds::base_du> view(size_t i) const;
+
+        /**
+         * Get a packet in the archive for packet_service::reception().
+         * The primary header is copied in to the PDU, the packet data field
+         * is a view into the archive.
+         * @param i Index of the packet.
+         * @return Space packet PDU, or nullptr if i is out of range or the
+         * packet runs past the end of the archive.
+         */
+        std::unique_ptr<ccsds::spp::pdu> packet(size_t i) const;
+
+        /**
+         * Get the offset of a packet in the archive.
+         * @param i Index of the packet, less than size().
+         * @return Offset of the packet in bytes.
+         */
+        uint64_t offset(size_t i) const
+        {
+            return (i < count) ? offsets[i] : built[i - count];
+        }
+
+        /**
+         * Access the mapped archive.
+         * @return Start of the archive, nullptr if the archive is empty or not open.
+         */
+        const uint8_t* data() const;
+
+        /**
+         * Get the length of the mapped archive.
+         * @return Length of the archive in bytes.
+         */
+        size_t length() const;
+
+        /**
+         * Get the owner of the mapping, for views into the archive.
+         * @return Owner of the mapping, nullptr if the archive is not open.
+         */
+        std::shared_ptr<const void> owner() const;
+
+    private:
+        struct mapping;
+
+        /**
+         * Map a file.
+         * @param path Path to the file.
+         * @return Mapping of the file, or nullptr if the file could not be mapped.
+         */
+        static std::shared_ptr<const mapping> map(const std::string& path);
+
+        /**
+         * Map the index file if it matches the archive.
+         * The index is only used if it was written for this archive, which
+         * has not changed since other than by growing, its length matches
+         * its count and its offsets leave room for each packet up to the
+         * end of the covered bytes.  The archive itself is not read.
+         * @param path Path to the index file.
+         * @return Number of bytes of the archive covered by the index.
+         */
+        size_t load(const std::string& path);
+
+        /**
+         * Index the packets in the archive after an offset.
+         * @param offset Offset of the first packet to index.
+         * @return Number of bytes of the archive covered by the index.
+         */
+        size_t scan(size_t offset);
+
+        /**
+         * Write the index file.
+         * @param path Path to the index file.
+         * @param covered Number of bytes of the archive covered by the index.
+         */
+        void save(const std::string& path, size_t covered) const;
+
+        /**
+         * Check a packet lies within the archive.
+         * @param i Index of the packet.
+         * @param len Set to the size of the packet in bytes.
+         * @return true if i is in range and the packet lies within the
+         * archive, false otherwise.
+         */
+        bool bounds(size_t i, size_t& len) const;
+
+        /**
+         * Get the size of a packet.
+         * @param offset Offset of the packet in the archive.
+         * @return Packet size in bytes.
+         */
+        size_t packet_size(size_t offset) const;
+
+        std::shared_ptr<const mapping> file;    ///< Mapping of the archive.
+        std::shared_ptr<const mapping> index;   ///< Mapping of a complete index file.
+        const uint64_t*                offsets; ///< Offset of each packet in the mapped index.
+        size_t                         count;   ///< Number of packets in the mapped index.
+        std::vector<uint64_t>          built;   ///< Offsets of the packets following the mapped index.
+};
+
+/**
+ * Space Packet Archive Writer.
+ * DUs transferred to the writer are appended to an archive with
+ * scatter-gather I/O, so the chained buffers are not copied.
+ */
+class archive_writer : public ccsds::base_service {
+    public:
+        /**
+         * Maximum number of segments written with one system call.
+         */
+        static constexpr size_t MAX_SEGMENTS = 1024;
+
+        /**
+         * Constructor.
+         */
+        archive_writer();
+
+        /**
+         * Destructor.
+         */
+        virtual ~archive_writer();
+
+        archive_writer(const archive_writer&) = delete;
+        archive_writer& operator=(const archive_writer&) = delete;
+
+        /**
+         * Open an archive for appending, creating it if necessary.
+         * @param path Path to the archive.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::IO_ERROR if the archive could not be opened.
+         */
+        ccsds::error open(const std::string& path);
+
+        /**
+         * Close the archive.
+         */
+        void close();
+
+        /**
+         * Flush written packets to storage.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if the archive is not open.
+         * @retval error::code::IO_ERROR if flushing failed.
+         */
+        ccsds::error sync();
+
+        /**
+         * Append a DU from another service.
+         * @param du DU to transfer.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if the archive is not open.
+         * @retval error::code::IO_ERROR if writing to the archive failed.
+         */
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override;
+
+        /**
+         * Append a batch of DUs from another service.
+         * The DUs are coalesced into as few writes as possible.
+         * @param dus DUs to transfer, each DU is released once transferred.
+         * @param count Number of DUs in dus.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if the archive is not open.
+         * @retval error::code::IO_ERROR if writing to the archive failed.
+         */
+        virtual ccsds::error transfer_batch(std::unique_ptr<const ccsds::base_du> dus[], size_t count) override;
+
+    private:
+        /**
+         * Write segments to the archive.
+         * @param segments Segments to write.
+         * @param count Number of segments.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::IO_ERROR if writing to the archive failed.
+         */
+        ccsds::error write(ccsds::segment* segments, size_t count);
+
+        int                         fd;       ///< Archive file.
+        std::vector<ccsds::segment> pending;  ///< Segments waiting to be written.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_ARCHIVE_H_
@@ -0,0 +1,69 @@
+/**
+ * @file ccsds/spp_decode.h
+ * Space Packet bulk primary header decoding
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_DECODE_H_
+#define CCSDS_SPP_DECODE_H_
+
+#include "ccsds/spp.h"
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Number of headers from which decode_headers() uses the vector kernels of
+ * the processor, fewer headers are decoded by the portable kernel.
+ */
+constexpr size_t VECTOR_THRESHOLD = 16;
+
+/**
+ * Decoded primary header fields, one array per field.
+ * Each array must hold at least as many elements as headers decoded.
+ */
+struct header_fields {
+    uint16_t* apid;      ///< APID.
+    uint8_t*  type;      ///< Packet type.
+    uint8_t*  secondary; ///< Secondary header flag.
+    uint8_t*  flags;     ///< Sequence flags.
+    uint16_t* count;     ///< Packet sequence count or packet name.
+    uint32_t* length;    ///< Length of the packet data field in bytes.
+};
+
+/**
+ * Decode an array of primary headers.
+ * Decoding stops at the first header with an unsupported packet version
+ * number or a packet data field longer than max_length.
+ * @note Fields of the headers after the last valid header may be overwritten.
+ * @param headers Primary headers to decode.
+ * @param count Number of headers.
+ * @param fields Arrays to decode the headers to.
+ * @param max_length Maximum length of a packet data field in bytes.
+ * @return Number of valid headers decoded.
+ */
+size_t decode_headers(const primary_header headers[], size_t count, const header_fields& fields, size_t max_length = MAX_DATA_LENGTH);
+
+/**
+ * Decode the primary headers of packets held back to back in a buffer.
+ * Decoding stops at the first invalid header, see decode_headers(), or at
+ * a packet extending past the end of the buffer.
+ * @param buf Buffer containing space packets.
+ * @param len Length of buf in bytes.
+ * @param offsets Set to the offset of each decoded packet in buf.
+ * @param count Maximum number of packets to decode.
+ * @param fields Arrays to decode the headers to.
+ * @param max_length Maximum length of a packet data field in bytes.
+ * @return Number of packets decoded.
+ */
+size_t decode_stream(const void* buf, size_t len, size_t offsets[], size_t count, const header_fields& fields, size_t max_length = MAX_DATA_LENGTH);
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_DECODE_H_
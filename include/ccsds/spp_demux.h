@@ -0,0 +1,113 @@
+/**
+ * @file ccsds/spp_demux.h
+ * Space Packet APID demultiplexer
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_DEMUX_H_
+#define CCSDS_SPP_DEMUX_H_
+
+#include "ccsds/spp.h"
+#include <array>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Space Packet APID Demultiplexer.
+ * Routes received packets to the octet service registered for their APID
+ * using a flat table indexed by APID, so the routing cost does not depend
+ * on the number of registered services.
+ */
+class demux_service : public ccsds::base_service {
+    public:
+        /**
+         * Constructor.
+         */
+        demux_service();
+
+        /**
+         * Destructor.
+         */
+        virtual ~demux_service() = default;
+
+        /**
+         * Register an octet service for an APID.
+         * @param id APID to route to the service.
+         * @param service Service to receive packets, nullptr to unregister.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if id is the idle APID, out of
+         * range or not the APID of the service.
+         */
+        ccsds::error attach(apid id, ccsds::spp::octet_service* service);
+
+        /**
+         * Unregister the octet service for an APID.
+         * @param id APID to unregister.
+         */
+        void detach(apid id);
+
+        /**
+         * Callback function for packets without a registered service.
+         * @param pdu PDU received.
+         * @param id APID of the packet.
+         */
+        typedef ccsds::callback<void(std::unique_ptr<const ccsds::spp::pdu> pdu, apid id)> indication;
+
+        /**
+         * Set the indication callback function for idle packets and
+         * packets with an unregistered APID.
+         * @param func Callback function.
+         */
+        void set_indication(indication func);
+
+        /**
+         * Receive a PDU from the subnetwork.
+         * @param pdu PDU to receive.
+         */
+        void reception(std::unique_ptr<ccsds::spp::pdu> pdu);
+
+        /**
+         * Callback function for packets received in place without a registered service.
+         * @param packet Packet received, only valid until the callback returns.
+         * @param id APID of the packet.
+         */
+        typedef ccsds::callback<void(const packet_view& packet, apid id)> view_indication;
+
+        /**
+         * Set the indication callback function for idle packets and
+         * packets with an unregistered APID received in place.
+         * @param func Callback function.
+         */
+        void set_view_indication(view_indication func);
+
+        /**
+         * Receive a packet in place from the subnetwork.
+         * @param packet Packet to receive.
+         * @param owner Owner of the buffer, passed on to the octet service.
+         */
+        void reception(const packet_view& packet, std::shared_ptr<const void> owner = nullptr);
+
+    private:
+        /**
+         * Transfer as SDU from another service.
+         * @warning The demux service does not allow direct transfers,
+         * @param sdu SDU to transfer.
+         * @retval error::code::NO_SUPPORT The demux service does not allow direct transfers,
+         */
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override;
+
+        std::array<ccsds::spp::octet_service*, PACKET_APID_MASK + 1> services;      ///< Services indexed by APID.
+        indication                                                  callback;      ///< Indication callback function.
+        view_indication                                             view_callback; ///< Indication callback function for packets received in place.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_DEMUX_H_
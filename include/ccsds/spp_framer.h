@@ -0,0 +1,91 @@
+/**
+ * @file ccsds/spp_framer.h
+ * Space Packet byte-stream framer
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_FRAMER_H_
+#define CCSDS_SPP_FRAMER_H_
+
+#include "ccsds/spp.h"
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Space Packet Byte-Stream Framer.
+ * Extracts space packets from contiguous receive buffers holding packets
+ * back to back.  Packets contained in a single buffer are passed on as
+ * views into that buffer, only packets that straddle a buffer boundary
+ * are stitched together in an internal buffer.
+ */
+class packet_framer {
+    public:
+        /**
+         * Maximum size of a space packet in bytes.
+         */
+        static constexpr size_t MAX_PACKET_SIZE = sizeof(primary_header) + 65536;
+
+        /**
+         * Constructor.
+         */
+        packet_framer();
+
+        /**
+         * Destructor.
+         */
+        ~packet_framer() = default;
+
+        /**
+         * Callback function for receiving a space packet.
+         * @param packet Complete space packet, including the primary header.
+         * @note The packet is only valid until the callback returns.
+         */
+        typedef ccsds::callback<void(const ccsds::buffered_du& packet)> indication;
+
+        /**
+         * Set the indication callback function.
+         * @param func Callback function.
+         */
+        void set_indication(indication func);
+
+        /**
+         * Receive a buffer from the subnetwork.
+         * @param buf Buffer containing space packets.
+         * @param len Length of buf in bytes.
+         */
+        void reception(void* buf, size_t len);
+
+        /**
+         * Discard any partially received packet.
+         */
+        void reset();
+
+        /**
+         * Get the number of bytes held for a partially received packet.
+         * @return Number of bytes held.
+         */
+        size_t pending() const;
+
+    private:
+        /**
+         * Get the total size of a packet from its primary header.
+         * @param header Start of the primary header.
+         * @return Packet size in bytes.
+         */
+        static size_t packet_size(const uint8_t* header);
+
+        indication                 callback; ///< Indication callback function.
+        std::unique_ptr<uint8_t[]> partial;  ///< Buffer for packets straddling a buffer boundary.
+        size_t                     held;     ///< Number of bytes in partial.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_FRAMER_H_
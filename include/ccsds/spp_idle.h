@@ -0,0 +1,112 @@
+/**
+ * @file ccsds/spp_idle.h
+ * Space Packet idle packet generation
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_IDLE_H_
+#define CCSDS_SPP_IDLE_H_
+
+#include "ccsds/shared_du.h"
+#include "ccsds/spp.h"
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Space Packet Idle Packet Generator.
+ * The idle data is filled once into a shared payload and the data field
+ * of every packet is a shared_du viewing it, held by an intrusive
+ * reference count.  Only the primary header is written per packet, as
+ * each packet has its own sequence count and length; it is stored in the
+ * PDU node, so an idle packet takes two DU nodes from the DU allocator
+ * and no other allocation.  Idle packets are used to top up fixed-rate
+ * links to their frame capacity.
+ */
+class idle_service {
+    public:
+        /**
+         * Minimum size of an idle packet in bytes.
+         */
+        static constexpr size_t MIN_PACKET_SIZE = sizeof(primary_header) + 1;
+
+        /**
+         * Maximum size of an idle packet in bytes.
+         */
+        static constexpr size_t MAX_PACKET_SIZE = sizeof(primary_header) + MAX_DATA_LENGTH;
+
+        /**
+         * Constructor.
+         * @param subnetwork Subnetwork to transmit idle packets on.
+         * @param pattern Octet the idle data is filled with.
+         */
+        idle_service(ccsds::base_service* subnetwork, uint8_t pattern = 0xFF);
+
+        /**
+         * Destructor.
+         * Idle packets still in use keep the idle data alive.
+         */
+        ~idle_service();
+
+        idle_service(const idle_service&) = delete;
+        idle_service& operator=(const idle_service&) = delete;
+
+        /**
+         * Make an idle packet.
+         * @param size Size of the packet in bytes, including the primary header.
+         * @return Idle packet viewing the shared idle data, nullptr if size
+         * is not between MIN_PACKET_SIZE and MAX_PACKET_SIZE.
+         */
+        std::unique_ptr<const ccsds::spp::pdu> packet(size_t size);
+
+        /**
+         * Send an idle packet.
+         * @param size Size of the packet in bytes, including the primary header.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if size is not between MIN_PACKET_SIZE and MAX_PACKET_SIZE.
+         * @retval error::code::NO_NETWORK if a subnetwork has not been configured.
+         * @retval other from the subnetwork.
+         */
+        ccsds::error request(size_t size);
+
+        /**
+         * Fill a buffer with idle packets back to back.
+         * Less than MIN_PACKET_SIZE bytes cannot hold an idle packet and
+         * are left unfilled.
+         * @param buf Buffer to fill, such as the unused end of a frame.
+         * @param len Length of buf in bytes.
+         * @return Number of bytes filled.
+         */
+        size_t fill(void* buf, size_t len);
+
+    private:
+        /**
+         * Encode the primary header of an idle packet.
+         * @param header Header to encode.
+         * @param size Size of the packet in bytes.
+         */
+        void encode(primary_header& header, size_t size);
+
+        /**
+         * Access the idle data.
+         * @return MAX_DATA_LENGTH bytes of idle data.
+         */
+        const uint8_t* data() const
+        {
+            return static_cast<const uint8_t*>(idle_data->chain().get());
+        }
+
+        ccsds::base_service*  subnetwork; ///< Subnetwork to transmit idle packets on.
+        const shared_payload* idle_data;  ///< Idle data shared by every idle packet, holding one reference.
+        uint16_t              count;      ///< Packet sequence count of idle packets.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_IDLE_H_
@@ -0,0 +1,197 @@
+/**
+ * @file ccsds/spp_index.h
+ * Space Packet archive index by APID and time
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_INDEX_H_
+#define CCSDS_SPP_INDEX_H_
+
+#include "ccsds/spp_archive.h"
+#include "ccsds/spp_secondary.h"
+#include <vector>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Space Packet Archive Index.
+ * Records the offset of every packet of each APID, and for every INTERVAL
+ * packets of an APID a checkpoint holding the earliest and latest time of
+ * those packets.  A query only visits the checkpoints of one APID and the
+ * packets of checkpoints overlapping the queried times, and returns views
+ * into the archive without copying the packets.
+ * Building the index can be split across threads, each indexing a
+ * contiguous range of packets.
+ */
+class archive_index {
+    public:
+        /**
+         * Number of packets of an APID covered by each checkpoint.
+         */
+        static constexpr size_t INTERVAL = 64;
+
+        /**
+         * Callback function extracting the time of a packet.
+         * Times are compared as unsigned integers, so they must increase
+         * with time.
+         * @param packet Packet to get the time of.
+         * @param time Set to the time of the packet.
+         * @return true if the packet has a time, false otherwise.
+         */
+        typedef ccsds::callback<bool(const packet_view& packet, uint64_t& time)> time_source;
+
+        /**
+         * Convert a CUC time to an index time.
+         * @param time Time to convert.
+         * @return Seconds in the upper 32 bits, the fraction in the lower 32 bits.
+         */
+        static constexpr uint64_t ticks(const ccsds::timestamp& time)
+        {
+            return (static_cast<uint64_t>(time.seconds) << 32) | time.fraction;
+        }
+
+        /**
+         * Time source for packets with a CUC time code in the secondary header.
+         * Usable as a time_source, packets without a secondary header or too
+         * short to hold the field have no time.
+         * @tparam FIELD Secondary header field holding a ccsds::cuc time code.
+         * @param packet Packet to get the time of.
+         * @param time Set to the time of the packet, see ticks().
+         * @return true if the packet has a time, false otherwise.
+         */
+        template<typename FIELD>
+        static bool secondary_time(const packet_view& packet, uint64_t& time)
+        {
+            if(!packet.secondary() || (packet.data_length() < FIELD::END)){
+                return false;
+            }
+            time = ticks(FIELD::decode(packet));
+            return true;
+        }
+
+        /**
+         * Constructor.
+         * @param time Time source of packets, may be empty to only index by
+         * APID.  It is called from every indexing thread.
+         */
+        archive_index(time_source time = nullptr);
+
+        /**
+         * Destructor.
+         */
+        ~archive_index() = default;
+
+        archive_index(const archive_index&) = delete;
+        archive_index& operator=(const archive_index&) = delete;
+
+        /**
+         * Index the packets of an open archive.
+         * The index keeps the archive mapped, even after the reader is closed.
+         * @param reader Archive to index.
+         * @param threads Number of threads to index with, at least 1.
+         * @return Number of packets indexed.
+         */
+        size_t build(const archive_reader& reader, size_t threads = 1);
+
+        /**
+         * Index the packets of a buffer holding packets back to back.
+         * Indexing stops at the first incomplete packet.
+         * @param owner Owner of the buffer, kept alive by the index and
+         * the views it returns.  May be nullptr if the buffer outlives them.
+         * @param buf Buffer holding the packets.
+         * @param len Length of buf in bytes.
+         * @param threads Number of threads to index with, at least 1.
+         * @return Number of packets indexed.
+         */
+        size_t build(std::shared_ptr<const void> owner, const void* buf, size_t len, size_t threads = 1);
+
+        /**
+         * Discard the index.
+         */
+        void clear();
+
+        /**
+         * Get the number of packets of an APID.
+         * @param id APID.
+         * @return Number of packets indexed.
+         */
+        size_t count(apid id) const;
+
+        /**
+         * View every packet of an APID.
+         * @param id APID.
+         * @param packets Appended with a view of each packet, in archive order.
+         * @return Number of packets appended.
+         */
+        size_t query(apid id, std::vector<std::unique_ptr<const ccsds::base_du>>& packets) const;
+
+        /**
+         * View the packets of an APID with a time in a range.
+         * @param id APID.
+         * @param begin Earliest time, inclusive.
+         * @param end Latest time, exclusive.
+         * @param packets Appended with a view of each packet, in archive order.
+         * @return Number of packets appended.
+         */
+        size_t query(apid id, uint64_t begin, uint64_t end, std::vector<std::unique_ptr<const ccsds::base_du>>& packets) const;
+
+    private:
+        /**
+         * Range of times of INTERVAL packets of an APID.
+         */
+        struct checkpoint {
+            uint64_t first; ///< Earliest time of the packets.
+            uint64_t last;  ///< Latest time of the packets.
+        };
+
+        /**
+         * Packets of an APID.
+         */
+        struct series {
+            std::vector<uint64_t>   offsets;     ///< Offset of each packet.
+            std::vector<checkpoint> checkpoints; ///< Time range of every INTERVAL packets.
+        };
+
+        /**
+         * Packet of an APID found while building the index.
+         */
+        struct entry {
+            uint64_t offset; ///< Offset of the packet.
+            uint64_t time;   ///< Time of the packet, UINT64_MAX if it has none.
+        };
+
+        /**
+         * Index a range of packets.
+         * @tparam OFFSETS Type of a function returning the offset of packet i.
+         * @param offsets Function returning the offset of packet i.
+         * @param total Number of packets.
+         * @param threads Number of threads to index with.
+         * @return Number of packets indexed.
+         */
+        template<typename OFFSETS>
+        size_t index(const OFFSETS& offsets, size_t total, size_t threads);
+
+        /**
+         * Make a view of a packet.
+         * @param offset Offset of the packet.
+         * @return View of the packet.
+         */
+        std::unique_ptr<const ccsds::base_du> view(uint64_t offset) const;
+
+        time_source                 source;  ///< Time source of packets.
+        std::shared_ptr<const void> owner;   ///< Owner of the indexed buffer.
+        const uint8_t*              base;    ///< Start of the indexed buffer.
+        size_t                      length;  ///< Length of the indexed buffer in bytes.
+        std::vector<series>         apids;   ///< Packets of each APID, indexed by APID.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_INDEX_H_
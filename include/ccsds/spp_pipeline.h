@@ -0,0 +1,134 @@
+/**
+ * @file ccsds/spp_pipeline.h
+ * Space Packet sharded receive pipeline
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_PIPELINE_H_
+#define CCSDS_SPP_PIPELINE_H_
+
+#include "ccsds/queue.h"
+#include "ccsds/spp_demux.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Space Packet Sharded Receive Pipeline.
+ * The receive thread only extracts the APID of each packet and queues it
+ * to the shard owning that APID.  Each shard has its own demultiplexer,
+ * drained by its own worker thread, so the octet services attached to a
+ * shard are only ever called from that thread.  Packets of one APID
+ * always go to the same shard, which keeps them in order.
+ */
+class receive_pipeline {
+    public:
+        /**
+         * Number of packets queued to each shard.
+         */
+        static constexpr size_t DEPTH = 1024;
+
+        /**
+         * Constructor.
+         * @param shards Number of shards, at least 1.
+         */
+        receive_pipeline(size_t shards);
+
+        /**
+         * Destructor.
+         */
+        ~receive_pipeline();
+
+        receive_pipeline(const receive_pipeline&) = delete;
+        receive_pipeline& operator=(const receive_pipeline&) = delete;
+
+        /**
+         * Get the number of shards.
+         * @return Number of shards.
+         */
+        size_t shards() const;
+
+        /**
+         * Get the shard owning an APID.
+         * @param id APID.
+         * @return Index of the shard.
+         */
+        size_t shard_of(apid id) const;
+
+        /**
+         * Access the demultiplexer of a shard, to set its indication.
+         * @param i Index of the shard.
+         * @return Demultiplexer of the shard.
+         */
+        demux_service& demux(size_t i);
+
+        /**
+         * Register an octet service for an APID on the shard owning it.
+         * @note Must not be called while the pipeline is running.
+         * @param id APID to route to the service.
+         * @param service Service to receive packets, nullptr to unregister.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if id is the idle APID, out of
+         * range or not the APID of the service.
+         */
+        ccsds::error attach(apid id, ccsds::spp::octet_service* service);
+
+        /**
+         * Receive a PDU from the subnetwork.
+         * @note Must only be called from one thread.
+         * @param pdu PDU to receive.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_SPACE if the queue of the shard is full,
+         * the packet is discarded.
+         */
+        ccsds::error reception(std::unique_ptr<ccsds::spp::pdu> pdu);
+
+        /**
+         * Pass packets queued to a shard on to its demultiplexer.
+         * @note Must not be called while the pipeline is running.
+         * @param i Index of the shard.
+         * @param max Maximum number of packets to pass on.
+         * @return Number of packets passed on.
+         */
+        size_t process(size_t i, size_t max = SIZE_MAX);
+
+        /**
+         * Start a worker thread for each shard.
+         * A worker sleeps once its shard has been empty for a while and is
+         * woken by the next packet queued to it.
+         */
+        void start();
+
+        /**
+         * Stop the worker threads after passing on the queued packets.
+         */
+        void stop();
+
+    private:
+        /**
+         * Shard of the pipeline.
+         */
+        struct shard {
+            spsc_ring<std::unique_ptr<ccsds::spp::pdu>, DEPTH> ring;   ///< Packets queued to the shard.
+            demux_service                                      demux;  ///< Demultiplexer of the shard.
+            std::thread                                        worker; ///< Worker thread.
+            parker                                             waiter; ///< Idle wait of the worker thread.
+        };
+
+        std::vector<std::unique_ptr<shard>> partitions; ///< Shards.
+        std::atomic<bool>                   running;    ///< Worker threads are running.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_PIPELINE_H_
@@ -0,0 +1,133 @@
+/**
+ * @file ccsds/spp_qos.h
+ * Space Packet transmit scheduling
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_QOS_H_
+#define CCSDS_SPP_QOS_H_
+
+#include "ccsds/queue.h"
+#include "ccsds/spp.h"
+#include <array>
+#include <atomic>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Priority scheduler for transmitted packets.
+ * Packets are queued in bounded per-class queues, class 0 has the highest
+ * priority.  Queued packets are passed on to the subnetwork while it has
+ * credit, either in strict priority order or by weighted round robin.
+ * Packets may be queued from any thread, only one thread drains at a time.
+ */
+class priority_scheduler {
+    public:
+        /**
+         * Number of QoS classes.
+         */
+        static constexpr size_t LEVELS = 4;
+
+        /**
+         * Maximum number of packets queued in each class.
+         */
+        static constexpr size_t DEPTH = 256;
+
+        /**
+         * Draining policy.
+         */
+        enum policy {
+            STRICT,   ///< Always drain the highest priority class first.
+            WEIGHTED, ///< Drain up to weight packets from each class per round.
+        };
+
+        /**
+         * Constructor.
+         * @param mode Draining policy.
+         * @param weights Packets drained from each class per round, for WEIGHTED.
+         * @param depths Maximum number of packets queued in each class, up to DEPTH.
+         */
+        priority_scheduler(policy mode, const std::array<unsigned int, LEVELS>& weights, const std::array<size_t, LEVELS>& depths);
+
+        /**
+         * Destructor.
+         */
+        ~priority_scheduler() = default;
+
+        priority_scheduler(const priority_scheduler&) = delete;
+        priority_scheduler& operator=(const priority_scheduler&) = delete;
+
+        /**
+         * Queue a packet.
+         * @param pdu Packet to queue.
+         * @param qos QoS class of the packet.
+         * @param done Completion callback, called by drain() with the result
+         * of the subnetwork transfer.  Not called if queueing fails.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if qos is not a valid class.
+         * @retval error::code::NO_SPACE if the class is full.
+         */
+        ccsds::error enqueue(std::unique_ptr<const ccsds::base_du> pdu, int qos, ccsds::base_service::completion done = nullptr);
+
+        /**
+         * Pass queued packets on to a subnetwork while it has credit.
+         * Returns immediately if another thread is draining.
+         * @param subnetwork Subnetwork to transmit packets on.
+         * @return Number of packets passed on.
+         */
+        size_t drain(ccsds::base_service* subnetwork);
+
+        /**
+         * Get the number of packets queued in a class.
+         * @param qos QoS class.
+         * @return Number of packets, 0 if qos is not a valid class.
+         */
+        size_t size(int qos) const;
+
+        /**
+         * Get the number of packets that can be queued in a class.
+         * @param qos QoS class.
+         * @return Free space in the class, 0 if qos is not a valid class.
+         */
+        size_t credit(int qos) const;
+
+        /**
+         * Get the number of packets the subnetwork failed to transfer.
+         * @return Number of failed transfers.
+         */
+        size_t errors() const;
+
+    private:
+        /**
+         * Take the next packet to transmit.
+         * @param entry Set to the next packet.
+         * @return true if a packet was taken, false if all classes are empty.
+         */
+        bool next(queued_du& entry);
+
+        /**
+         * Check for queued packets.
+         * @return true if any class has queued packets.
+         */
+        bool pending() const;
+
+        std::array<mpsc_ring<queued_du, DEPTH>, LEVELS> queues;   ///< Queued packets of each class.
+        std::array<unsigned int, LEVELS>                weights;  ///< Packets drained from each class per round.
+        std::array<size_t, LEVELS>                      depths;   ///< Maximum packets queued in each class.
+        policy                                          mode;     ///< Draining policy.
+        size_t                                          current;  ///< Class being drained in the round.
+        unsigned int                                    quantum;  ///< Packets left to drain from the current class.
+        std::atomic<bool>                               draining; ///< A thread is draining.
+        std::atomic<size_t>                             failures; ///< Number of failed transfers.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_QOS_H_
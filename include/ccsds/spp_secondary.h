@@ -0,0 +1,140 @@
+/**
+ * @file ccsds/spp_secondary.h
+ * Space Packet secondary header layouts
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_SECONDARY_H_
+#define CCSDS_SPP_SECONDARY_H_
+
+#include "ccsds/spp.h"
+#include "ccsds/time_code.h"
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Field of a packet secondary header.
+ * The position and encoding of the field are fixed at compile time, so
+ * accessing it is a load from a constant offset in the packet data field.
+ * @tparam OFFSET Offset of the field from the start of the secondary header in bytes.
+ * @tparam CODE Codec of the field, such as ccsds::octets, ccsds::cuc or ccsds::cds.
+ */
+template<size_t OFFSET, typename CODE>
+struct secondary_field {
+    /**
+     * Decoded type.
+     */
+    typedef typename CODE::value_type value_type;
+
+    /**
+     * Offset of the field from the start of the secondary header in bytes.
+     */
+    static constexpr size_t BEGIN = OFFSET;
+
+    /**
+     * Offset of the end of the field from the start of the secondary header in bytes.
+     */
+    static constexpr size_t END = OFFSET + CODE::SIZE;
+
+    /**
+     * Decode the field.
+     * @param secondary Start of the secondary header.
+     * @return Decoded field.
+     */
+    static value_type decode(const uint8_t* secondary)
+    {
+        return CODE::decode(secondary + OFFSET);
+    }
+
+    /**
+     * Decode the field of a packet.
+     * @warning The packet must have a secondary header of the layout.
+     * @param packet Packet to decode.
+     * @return Decoded field.
+     */
+    static value_type decode(const packet_view& packet)
+    {
+        return decode(packet.data());
+    }
+
+    /**
+     * Decode the field of a batch of packets.
+     * @param buf Buffer holding the packets.
+     * @param offsets Offset of each packet in buf, such as found by decode_stream().
+     * @param count Number of packets.
+     * @param values Set to the decoded field of each packet.
+     */
+    static void decode(const void* buf, const size_t offsets[], size_t count, value_type values[])
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(buf) + sizeof(primary_header) + OFFSET;
+        for(size_t i = 0; i < count; ++i){
+            values[i] = CODE::decode(p + offsets[i]);
+        }
+    }
+
+    /**
+     * Encode the field.
+     * @param secondary Start of the secondary header.
+     * @param value Value to encode.
+     */
+    static void encode(uint8_t* secondary, const value_type& value)
+    {
+        CODE::encode(secondary + OFFSET, value);
+    }
+};
+
+/**
+ * Layout of a packet secondary header.
+ * For example, a 6 octet CUC time code followed by a 1 octet function code:
+ * @code
+ * typedef secondary_field<0, ccsds::cuc<4, 2>> time_field;
+ * typedef secondary_field<6, ccsds::octets<1>> function_field;
+ * typedef secondary_header<time_field, function_field> telemetry_header;
+ * @endcode
+ * @tparam FIELDS Fields of the secondary header.
+ */
+template<typename... FIELDS>
+struct secondary_header {
+    static_assert(sizeof...(FIELDS) > 0, "Secondary header must have a field");
+
+    /**
+     * Size of the secondary header in bytes.
+     */
+    static constexpr size_t SIZE = []{
+        size_t end = 0;
+        ((end = (FIELDS::END > end) ? FIELDS::END : end), ...);
+        return end;
+    }();
+
+    /**
+     * Check a packet has a secondary header of the layout.
+     * @param packet Packet to check.
+     * @return true if the secondary header flag is set and the data field
+     * can hold the secondary header, false otherwise.
+     */
+    static bool present(const packet_view& packet)
+    {
+        return packet.secondary() && (packet.data_length() >= SIZE);
+    }
+
+    /**
+     * Encode every field of the secondary header.
+     * @param secondary Buffer of at least SIZE bytes for the secondary header.
+     * @param values Value of each field, in the order of FIELDS.
+     */
+    static void encode(uint8_t* secondary, const typename FIELDS::value_type&... values)
+    {
+        (FIELDS::encode(secondary, values), ...);
+    }
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_SECONDARY_H_
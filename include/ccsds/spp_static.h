@@ -0,0 +1,245 @@
+/**
+ * @file ccsds/spp_static.h
+ * Space Packet Protocol with static dispatch
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_STATIC_H_
+#define CCSDS_SPP_STATIC_H_
+
+#include "ccsds/spp.h"
+#include "ccsds/crc.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Compute the CRC-16-CCITT of a buffer without the library.
+ * Gives the same result as ccsds::crc16(), one octet at a time, and can be
+ * evaluated at compile time.
+ * @param buf Buffer.
+ * @param len Length of buf in bytes.
+ * @param crc CRC of the preceding data, CRC16_INIT to start a new CRC.
+ * @return CRC of the preceding data and buf.
+ */
+constexpr uint16_t static_crc16(const uint8_t* buf, size_t len, uint16_t crc = CRC16_INIT)
+{
+    for(size_t i = 0; i < len; ++i){
+        crc = static_cast<uint16_t>((crc << 8) ^ CRC16_TABLE.table[(crc >> 8) ^ buf[i]]);
+    }
+    return crc;
+}
+
+/**
+ * Space Packet Octet Service with static dispatch.
+ * Header-only counterpart of octet_service for targets without a heap,
+ * exceptions or RTTI.  Packets are assembled in a buffer inside the
+ * service and handed to the derived class, which also receives the user
+ * data of received packets, so every call is resolved at compile time.
+ * The packets on the wire are the same as those of octet_service.
+ *
+ * The derived class provides:
+ * - `ccsds::error transmit(const uint8_t* packet, size_t len)` to transmit
+ *   an assembled space packet on the subnetwork.
+ * - `void indication(const uint8_t* data, size_t len, bool loss)` to
+ *   receive the user data of a packet, loss is set if packets were lost
+ *   before it.
+ *
+ * Segmented user data is not reassembled, segmented packets are
+ * discarded.
+ * @tparam Derived Class deriving from the service.
+ * @tparam APID APID of the service.
+ * @tparam TYPE Packet type.
+ * @tparam SEC_HDR Secondary header indicator.
+ * @tparam MAX_DATA Maximum length of user data in bytes.
+ * @tparam ERROR_CONTROL Packets have a packet error control field.
+ */
+template<typename Derived, apid APID, packet_type TYPE, bool SEC_HDR, size_t MAX_DATA = MAX_DATA_LENGTH, bool ERROR_CONTROL = false>
+class static_octet_service {
+    static_assert(APID <= APID_IDLE, "APID out of range");
+
+    public:
+        /**
+         * Identification field in network byte order.
+         */
+        static constexpr uint16_t IDENTIFICATION = identification(APID, TYPE, SEC_HDR);
+
+        /**
+         * Length of the packet error control field in bytes.
+         */
+        static constexpr size_t TRAILER = ERROR_CONTROL ? sizeof(packet_error_control) : 0;
+
+        /**
+         * Maximum size of a packet in bytes.
+         */
+        static constexpr size_t MAX_SIZE = sizeof(primary_header) + MAX_DATA + TRAILER;
+
+        static_assert((MAX_DATA > 0) && (MAX_DATA + TRAILER <= MAX_DATA_LENGTH), "MAX_DATA out of range");
+
+        /**
+         * Send a space packet using a packet count with the given octet string.
+         * @requirement SPP-12
+         * @param buf User data to copy into the packet.
+         * @param len Length of buf in bytes.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if len is 0 or more than MAX_DATA.
+         * @retval other from the subnetwork.
+         */
+        ccsds::error request(const void* buf, size_t len)
+        {
+            if((len == 0) || (len > MAX_DATA)){
+                return error(error::code::INVALID_ARG);
+            }
+            return send(buf, len);
+        }
+
+        /**
+         * Send a space packet using a packet count with user data of a
+         * length known at compile time.
+         * @requirement SPP-12
+         * @tparam LEN Length of the user data in bytes.
+         * @param data User data to copy into the packet.
+         * @retval error::code::NONE if successful.
+         * @retval other from the subnetwork.
+         */
+        template<size_t LEN>
+        ccsds::error request(const uint8_t (&data)[LEN])
+        {
+            static_assert((LEN > 0) && (LEN <= MAX_DATA), "user data length out of range");
+            return send(data, LEN);
+        }
+
+        /**
+         * Receive a space packet from the subnetwork.
+         * Packets of other APIDs are ignored.
+         * @param buf Buffer starting with a space packet.
+         * @param len Length of buf in bytes.
+         */
+        void reception(const void* buf, size_t len)
+        {
+            packet_view packet(buf, len);
+            if((len < sizeof(primary_header)) || (packet.id() != APID)){
+                return;
+            }
+            if(!packet.valid() || (packet.data_length() < TRAILER)
+                    || (ERROR_CONTROL && (static_crc16(static_cast<const uint8_t*>(buf), packet.size()) != 0))){
+                ++invalid;
+                return;
+            }
+
+            bool loss = track(packet.count());
+            if(packet.flags() != SEQUENCE_UNSEGMENTED){
+                ++invalid;
+                return;
+            }
+            derived().indication(packet.data(), packet.data_length() - TRAILER, loss);
+        }
+
+        /**
+         * Get the number of packets found lost.
+         * @return Number of missing packets.
+         */
+        uint32_t missing() const
+        {
+            return lost;
+        }
+
+        /**
+         * Get the number of received packets discarded as malformed, with an
+         * invalid packet error control field, or segmented.
+         * @return Number of discarded packets.
+         */
+        uint32_t malformed() const
+        {
+            return invalid;
+        }
+
+    protected:
+        /**
+         * Constructor.
+         */
+        constexpr static_octet_service() :
+            buffer{},
+            packet_count(0),
+            last_count(0),
+            started(false),
+            lost(0),
+            invalid(0)
+        {}
+
+        /**
+         * Destructor.
+         */
+        ~static_octet_service() = default;
+
+    private:
+        /**
+         * Access the derived class.
+         * @return Derived service.
+         */
+        Derived& derived()
+        {
+            return static_cast<Derived&>(*this);
+        }
+
+        /**
+         * Assemble a space packet and transmit it.
+         * @param buf User data to copy into the packet.
+         * @param len Length of buf in bytes.
+         * @retval error::code::NONE if successful.
+         * @retval other from the subnetwork.
+         */
+        ccsds::error send(const void* buf, size_t len)
+        {
+            primary_header header;
+            header.identification = IDENTIFICATION;
+            header.sequence_control = sequence_control(SEQUENCE_UNSEGMENTED, packet_count++);
+            header.data_length = ccsds::htons(len + TRAILER - 1);
+            memcpy(buffer, &header, sizeof(header));
+            memcpy(buffer + sizeof(header), buf, len);
+
+            if(ERROR_CONTROL){
+                uint16_t crc = ccsds::htons(static_crc16(buffer, sizeof(header) + len));
+                memcpy(buffer + sizeof(header) + len, &crc, sizeof(crc));
+            }
+            return derived().transmit(buffer, sizeof(header) + len + TRAILER);
+        }
+
+        /**
+         * Check the packet sequence count of a received packet, as
+         * sequence_tracker without a reorder tolerance.
+         * @param count Packet sequence count.
+         * @return true if packets were lost before this packet, false otherwise.
+         */
+        bool track(uint16_t count)
+        {
+            uint16_t ahead = (count - last_count) & SEQUENCE_COUNT_MASK;
+            bool loss = started && (ahead > 1) && (ahead <= (SEQUENCE_COUNT_MASK >> 1));
+            if(loss){
+                lost += ahead - 1;
+            }
+            last_count = count;
+            started = true;
+            return loss;
+        }
+
+        uint8_t  buffer[MAX_SIZE]; ///< Buffer packets are assembled in.
+        uint16_t packet_count;     ///< Current packet count.
+        uint16_t last_count;       ///< Packet sequence count of the last received packet.
+        bool     started;          ///< A packet has been received.
+        uint32_t lost;             ///< Number of missing packets.
+        uint32_t invalid;          ///< Number of discarded packets.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_STATIC_H_
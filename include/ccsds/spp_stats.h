@@ -0,0 +1,159 @@
+/**
+ * @file ccsds/spp_stats.h
+ * Space Packet reception statistics
+ * @ingroup spp
+ */
+
+#ifndef CCSDS_SPP_STATS_H_
+#define CCSDS_SPP_STATS_H_
+
+#include "ccsds/spp.h"
+#include <array>
+#include <atomic>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @addtogroup spp
+ * @{
+ */
+
+/**
+ * Snapshot of the reception counters of an APID.
+ */
+struct counters {
+    uint64_t packets;   ///< Number of packets received.
+    uint64_t bytes;     ///< Number of bytes received, including primary headers.
+    uint64_t gaps;      ///< Number of discontinuities in the packet sequence count.
+    uint64_t missing;   ///< Number of packets missing from the packet sequence count.
+    uint64_t idle;      ///< Number of idle packets received.
+    uint64_t malformed; ///< Number of packets discarded for invalid primary headers or error control.
+};
+
+/**
+ * Space Packet Reception Statistics.
+ * Counters are kept per APID, each in its own cache line, so services
+ * receiving different APIDs on different threads do not share cache
+ * lines.  Counting uses relaxed atomics, snapshots may be taken from any
+ * thread.
+ */
+class statistics {
+    public:
+        /**
+         * Number of APIDs with counters.
+         */
+        static constexpr size_t SIZE = PACKET_APID_MASK + 1;
+
+        /**
+         * Constructor.
+         * @param concurrent Allow the counters of one APID to be updated from multiple threads.
+         */
+        statistics(bool concurrent = false);
+
+        /**
+         * Destructor.
+         */
+        ~statistics() = default;
+
+        statistics(const statistics&) = delete;
+        statistics& operator=(const statistics&) = delete;
+
+        /**
+         * Count a received packet.
+         * @param id APID of the packet.
+         * @param bytes Size of the packet in bytes.
+         * @param missing Number of packets missing before this packet.
+         */
+        void packet(apid id, size_t bytes, uint16_t missing)
+        {
+            entry& e = entries[id & PACKET_APID_MASK];
+            if(id == APID_IDLE){
+                add(e.idle, 1);
+            }else{
+                add(e.packets, 1);
+            }
+            add(e.bytes, bytes);
+            if(missing != 0){
+                add(e.gaps, 1);
+                add(e.missing, missing);
+            }
+        }
+
+        /**
+         * Count a discarded packet.
+         * @param id APID of the packet.
+         */
+        void malformed(apid id)
+        {
+            add(entries[id & PACKET_APID_MASK].malformed, 1);
+        }
+
+        /**
+         * Get the counters of an APID.
+         * @param id APID.
+         * @return Snapshot of the counters.
+         */
+        counters snapshot(apid id) const;
+
+        /**
+         * Get the counters of every APID.
+         * @param all Set to the counters of each APID, indexed by APID.
+         */
+        void snapshot(std::array<counters, SIZE>& all) const;
+
+        /**
+         * Get the sum of the counters of every APID.
+         * @return Snapshot of the total counters.
+         */
+        counters total() const;
+
+        /**
+         * Reset all counters.
+         * @note Counts made while resetting may be lost.
+         */
+        void reset();
+
+    private:
+        /**
+         * Counters of an APID.
+         */
+        struct alignas(CACHE_LINE_SIZE) entry {
+            std::atomic<uint64_t> packets;   ///< Number of packets received.
+            std::atomic<uint64_t> bytes;     ///< Number of bytes received.
+            std::atomic<uint64_t> gaps;      ///< Number of sequence count discontinuities.
+            std::atomic<uint64_t> missing;   ///< Number of missing packets.
+            std::atomic<uint64_t> idle;      ///< Number of idle packets received.
+            std::atomic<uint64_t> malformed; ///< Number of discarded packets.
+        };
+
+        /**
+         * Add to a counter.
+         * @param counter Counter to add to.
+         * @param n Value to add.
+         */
+        void add(std::atomic<uint64_t>& counter, uint64_t n)
+        {
+            if(concurrent){
+                counter.fetch_add(n, std::memory_order_relaxed);
+            }else{
+                // A single writer does not need a locked read-modify-write
+                counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+            }
+        }
+
+        /**
+         * Read the counters of an APID.
+         * @param e Counters to read.
+         * @return Snapshot of the counters.
+         */
+        static counters read(const entry& e);
+
+        std::array<entry, SIZE> entries;    ///< Counters of each APID.
+        bool                    concurrent; ///< Counters may be updated from multiple threads.
+};
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
+
+#endif // CCSDS_SPP_STATS_H_
@@ -0,0 +1,76 @@
+/**
+ * @file ccsds/tee.h
+ * Fan-out subnetwork
+ */
+
+#ifndef CCSDS_TEE_H_
+#define CCSDS_TEE_H_
+
+#include "ccsds/common.h"
+#include <vector>
+
+namespace ccsds {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+/**
+ * Subnetwork transferring each DU to several subnetworks.
+ * The DU chain is moved into a shared_payload and every subnetwork gets
+ * its own chain of shared_du views of it, so the bytes are not copied
+ * however many subnetworks there are.  A single subnetwork gets the DU
+ * unchanged.
+ */
+class tee_service : public ccsds::base_service {
+    public:
+        /**
+         * Constructor.
+         * @param concurrent Subnetworks may release DUs from other threads.
+         */
+        tee_service(bool concurrent = false);
+
+        /**
+         * Destructor.
+         */
+        virtual ~tee_service() = default;
+
+        /**
+         * Add a subnetwork.
+         * @param subnetwork Subnetwork to transfer DUs to.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if subnetwork is nullptr.
+         */
+        ccsds::error attach(ccsds::base_service* subnetwork);
+
+        /**
+         * Remove a subnetwork.
+         * @param subnetwork Subnetwork to remove.
+         */
+        void detach(ccsds::base_service* subnetwork);
+
+        /**
+         * Transfer a DU to every subnetwork.
+         * Every subnetwork is given the DU, even if an earlier one fails.
+         * @param du DU to transfer.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if no subnetwork has been attached.
+         * @retval other from the first subnetwork to fail.
+         */
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override;
+
+        /**
+         * Get the number of DUs every subnetwork can accept.
+         * @return Lowest credit of the subnetworks, SIZE_MAX if none is attached.
+         */
+        virtual size_t credit() const override;
+
+    private:
+        std::vector<ccsds::base_service*> subnetworks; ///< Subnetworks to transfer DUs to.
+        bool                              concurrent;  ///< Shared payloads are released atomically.
+};
+
+/** @} */ // group ccsds
+} // namespace ccsds
+
+#endif // CCSDS_TEE_H_
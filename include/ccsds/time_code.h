@@ -0,0 +1,232 @@
+/**
+ * @file ccsds/time_code.h
+ * CCSDS time code formats
+ * @see https://public.ccsds.org/Pubs/301x0b4e1.pdf
+ * @cite ccsds-tcf
+ */
+
+#ifndef CCSDS_TIME_CODE_H_
+#define CCSDS_TIME_CODE_H_
+
+#include "ccsds/common.h"
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ccsds {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+/**
+ * Unsigned big endian integer of a fixed number of octets.
+ * Encoding and decoding is a single load or store and byte swap, without
+ * branching on the width.
+ * @tparam N Number of octets, 1 to 8.
+ */
+template<size_t N>
+struct octets {
+    static_assert((N >= 1) && (N <= 8), "Octet count out of range");
+
+    /**
+     * Size of the field in bytes.
+     */
+    static constexpr size_t SIZE = N;
+
+    /**
+     * Decoded type.
+     */
+    typedef typename std::conditional<(N <= 4), uint32_t, uint64_t>::type value_type;
+
+    /**
+     * Decode an integer.
+     * @param in Encoded integer.
+     * @return Decoded integer.
+     */
+    static value_type decode(const uint8_t* in)
+    {
+        uint64_t x = 0;
+        memcpy(&x, in, N);
+        return static_cast<value_type>(ccsds::ntohll(x) >> (64 - 8 * N));
+    }
+
+    /**
+     * Encode an integer, truncated to N octets.
+     * @param out Buffer to encode to.
+     * @param value Integer to encode.
+     */
+    static void encode(uint8_t* out, value_type value)
+    {
+        uint64_t x = ccsds::htonll(static_cast<uint64_t>(value) << (64 - 8 * N));
+        memcpy(out, &x, N);
+    }
+};
+
+/**
+ * Time since an epoch.
+ */
+struct timestamp {
+    uint32_t seconds;  ///< Whole seconds since the epoch.
+    uint32_t fraction; ///< Fraction of a second in units of 2^-32 seconds.
+};
+
+/**
+ * CCSDS Unsegmented Time Code (CUC) T-field.
+ * @tparam COARSE Number of octets of coarse time, whole seconds, 1 to 4.
+ * @tparam FINE Number of octets of fine time, fractions of a second, 0 to 3.
+ */
+template<size_t COARSE, size_t FINE>
+struct cuc {
+    static_assert((COARSE >= 1) && (COARSE <= 4), "Coarse octet count out of range");
+    static_assert(FINE <= 3, "Fine octet count out of range");
+
+    /**
+     * Size of the T-field in bytes.
+     */
+    static constexpr size_t SIZE = COARSE + FINE;
+
+    /**
+     * P-field for a level 1 time code, using the 1958 January 1 epoch.
+     */
+    static constexpr uint8_t PFIELD = (0b001 << 4) | ((COARSE - 1) << 2) | FINE;
+
+    /**
+     * Decoded type.
+     */
+    typedef timestamp value_type;
+
+    /**
+     * Decode a time code.
+     * @param in Encoded T-field.
+     * @return Decoded time, fine time beyond FINE octets is 0.
+     */
+    static value_type decode(const uint8_t* in)
+    {
+        uint64_t raw = octets<SIZE>::decode(in);
+        value_type time;
+        time.seconds = static_cast<uint32_t>(raw >> (8 * FINE));
+        time.fraction = static_cast<uint32_t>(raw << (32 - 8 * FINE));
+        return time;
+    }
+
+    /**
+     * Encode a time code.
+     * @param out Buffer to encode the T-field to.
+     * @param time Time to encode, seconds are truncated to COARSE octets
+     * and the fraction to FINE octets.
+     */
+    static void encode(uint8_t* out, const value_type& time)
+    {
+        uint64_t raw = (static_cast<uint64_t>(time.seconds) << (8 * FINE))
+                | (static_cast<uint64_t>(time.fraction) >> (32 - 8 * FINE));
+        octets<SIZE>::encode(out, static_cast<typename octets<SIZE>::value_type>(raw));
+    }
+};
+
+/**
+ * Time in CCSDS Day Segmented Time Code fields.
+ */
+struct cds_time {
+    uint32_t days;            ///< Days since the epoch.
+    uint32_t milliseconds;    ///< Milliseconds of the day.
+    uint32_t submilliseconds; ///< Microseconds or picoseconds of the millisecond.
+};
+
+/**
+ * CCSDS Day Segmented Time Code (CDS) T-field.
+ * @tparam DAY Number of octets of the day segment, 2 or 3.
+ * @tparam SUBMS Number of octets of the submillisecond segment, 0, 2 for
+ * microseconds or 4 for picoseconds.
+ */
+template<size_t DAY, size_t SUBMS>
+struct cds {
+    static_assert((DAY == 2) || (DAY == 3), "Day segment must be 2 or 3 octets");
+    static_assert((SUBMS == 0) || (SUBMS == 2) || (SUBMS == 4), "Submillisecond segment must be 0, 2 or 4 octets");
+
+    /**
+     * Size of the T-field in bytes.
+     */
+    static constexpr size_t SIZE = DAY + 4 + SUBMS;
+
+    /**
+     * P-field using the 1958 January 1 epoch.
+     */
+    static constexpr uint8_t PFIELD = (0b100 << 4) | ((DAY == 3) << 2) | (SUBMS / 2);
+
+    /**
+     * Decoded type.
+     */
+    typedef cds_time value_type;
+
+    /**
+     * Decode a time code.
+     * @param in Encoded T-field.
+     * @return Decoded time.
+     */
+    static value_type decode(const uint8_t* in)
+    {
+        value_type time;
+        time.days = octets<DAY>::decode(in);
+        time.milliseconds = octets<4>::decode(in + DAY);
+        if constexpr(SUBMS != 0){
+            time.submilliseconds = octets<SUBMS>::decode(in + DAY + 4);
+        }else{
+            time.submilliseconds = 0;
+        }
+        return time;
+    }
+
+    /**
+     * Encode a time code.
+     * @param out Buffer to encode the T-field to.
+     * @param time Time to encode.
+     */
+    static void encode(uint8_t* out, const value_type& time)
+    {
+        octets<DAY>::encode(out, time.days);
+        octets<4>::encode(out + DAY, time.milliseconds);
+        if constexpr(SUBMS != 0){
+            octets<SUBMS>::encode(out + DAY + 4, time.submilliseconds);
+        }
+    }
+};
+
+/**
+ * Decode a batch of fields.
+ * @tparam CODE Codec of the fields, such as cuc or cds.
+ * @param base Buffer holding the fields.
+ * @param offsets Offset of each field in base.
+ * @param count Number of fields.
+ * @param values Set to the decoded value of each field.
+ */
+template<typename CODE>
+void decode_batch(const void* base, const size_t offsets[], size_t count, typename CODE::value_type values[])
+{
+    const uint8_t* p = static_cast<const uint8_t*>(base);
+    for(size_t i = 0; i < count; ++i){
+        values[i] = CODE::decode(p + offsets[i]);
+    }
+}
+
+/**
+ * Encode a batch of fields.
+ * @tparam CODE Codec of the fields, such as cuc or cds.
+ * @param base Buffer to encode the fields to.
+ * @param offsets Offset of each field in base.
+ * @param count Number of fields.
+ * @param values Value of each field.
+ */
+template<typename CODE>
+void encode_batch(void* base, const size_t offsets[], size_t count, const typename CODE::value_type values[])
+{
+    uint8_t* p = static_cast<uint8_t*>(base);
+    for(size_t i = 0; i < count; ++i){
+        CODE::encode(p + offsets[i], values[i]);
+    }
+}
+
+/** @} */ // group ccsds
+} // namespace ccsds
+
+#endif // CCSDS_TIME_CODE_H_
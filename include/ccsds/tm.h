@@ -0,0 +1,353 @@
+/**
+ * @file ccsds/tm.h
+ * TM Space Data Link Protocol
+ * @ingroup tm
+ */
+
+#ifndef CCSDS_TM_H_
+#define CCSDS_TM_H_
+
+#include "ccsds/spp.h"
+#include "ccsds/spp_framer.h"
+#include "ccsds/spp_idle.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace ccsds {
+namespace tm {
+/**
+ * @ingroup ccsds
+ * @defgroup tm TM Space Data Link Protocol
+ * @{
+ * TM Transfer Frame services carrying space packets
+ * @see https://public.ccsds.org/Pubs/132x0b3.pdf
+ * @cite ccsds-tm
+ */
+
+#pragma pack(push,1)
+
+/**
+ * TM Transfer Frame Primary Header.
+ */
+struct frame_header {
+    uint16_t identification; ///< Transfer frame version number, spacecraft ID, virtual channel ID, OCF flag
+    uint8_t  mc_count;       ///< Master channel frame count
+    uint8_t  vc_count;       ///< Virtual channel frame count
+    uint16_t status;         ///< Frame data field status
+};
+
+static_assert(sizeof(frame_header) == 6);
+
+/**
+ * TM Transfer Frame Error Control field, trailing the frame.
+ */
+struct frame_error_control {
+    uint16_t crc; ///< CRC-16-CCITT of the rest of the frame, big endian.
+};
+
+static_assert(sizeof(frame_error_control) == 2);
+
+#pragma pack(pop)
+
+/**
+ * Primary header identification assembly helpers.
+ */
+enum {
+    FRAME_VERSION_1     = 0b00,  ///< Transfer frame version number.
+    FRAME_VERSION_SHIFT = 14,    ///< Transfer frame version shift in identification field.
+    FRAME_SCID_MASK     = 0x3FF, ///< Spacecraft ID mask in identification field.
+    FRAME_SCID_SHIFT    = 4,     ///< Spacecraft ID shift in identification field.
+    FRAME_VCID_MASK     = 0x7,   ///< Virtual channel ID mask in identification field.
+    FRAME_VCID_SHIFT    = 1,     ///< Virtual channel ID shift in identification field.
+};
+
+/**
+ * Primary header frame data field status assembly helpers.
+ */
+enum {
+    STATUS_UNSEGMENTED = 0b11 << 11, ///< Segment length ID when not synchronized.
+    STATUS_FHP_MASK    = 0x7FF,      ///< First header pointer mask in status field.
+    FHP_NO_PACKET      = 0x7FF,      ///< First header pointer of a frame without a packet start.
+    FHP_IDLE           = 0x7FE,      ///< First header pointer of a frame of only idle data.
+};
+
+/**
+ * Number of virtual channels of a master channel.
+ */
+constexpr size_t VIRTUAL_CHANNELS = FRAME_VCID_MASK + 1;
+
+/**
+ * Maximum length of a transfer frame in bytes.
+ */
+constexpr size_t MAX_FRAME_LENGTH = 2048;
+
+/**
+ * Encode the identification field of a transfer frame primary header.
+ * @param scid Spacecraft ID.
+ * @param vcid Virtual channel ID.
+ * @return Identification field in network byte order.
+ */
+constexpr uint16_t identification(uint16_t scid, uint8_t vcid)
+{
+    return ccsds::htons(
+            (FRAME_VERSION_1 << FRAME_VERSION_SHIFT)          // transfer frame version number
+            | ((scid & FRAME_SCID_MASK) << FRAME_SCID_SHIFT)  // spacecraft ID
+            | ((vcid & FRAME_VCID_MASK) << FRAME_VCID_SHIFT)); // virtual channel ID, no OCF
+}
+
+/**
+ * TM Master Channel Frame Service.
+ * Owns a fixed set of frame buffers, allocated once, that virtual
+ * channels write packets into.  Each completed frame is passed to the
+ * physical channel as a DU viewing its buffer, and the buffer is reused
+ * once the physical channel releases the DU.
+ * @note The master channel and its virtual channels must be used from one
+ * thread, frames may be released from any thread.
+ */
+class frame_service {
+    public:
+        /**
+         * Constructor.
+         * @param scid Spacecraft ID.
+         * @param length Length of each frame in bytes, limited to hold at
+         * least one octet of data and at most MAX_FRAME_LENGTH.
+         * @param subnetwork Physical channel to transmit frames on.
+         * @param frames Number of frame buffers, at least 1.
+         * @param error_control Frames end with a frame error control field.
+         */
+        frame_service(uint16_t scid, size_t length, ccsds::base_service* subnetwork, size_t frames = 8, bool error_control = false);
+
+        /**
+         * Destructor.
+         * @warning Every frame must be released by the physical channel first.
+         */
+        ~frame_service() = default;
+
+        frame_service(const frame_service&) = delete;
+        frame_service& operator=(const frame_service&) = delete;
+
+        /**
+         * Get the length of each frame.
+         * @return Frame length in bytes.
+         */
+        size_t length() const;
+
+        /**
+         * Get the length of the frame data field of each frame.
+         * @return Data field length in bytes.
+         */
+        size_t data_length() const;
+
+        /**
+         * Get the number of frame buffers not in use.
+         * @return Number of free frame buffers.
+         */
+        size_t available() const;
+
+    private:
+        friend class virtual_channel;
+
+        /**
+         * DU viewing a frame buffer, freeing the buffer when released.
+         */
+        class frame_du;
+
+        /**
+         * Take a free frame buffer.
+         * @return Frame buffer, nullptr if every buffer is in use.
+         */
+        uint8_t* acquire();
+
+        /**
+         * Return a frame buffer.
+         * @param index Index of the frame buffer.
+         */
+        void release(size_t index);
+
+        /**
+         * Complete a frame and transmit it on the physical channel.
+         * @param frame Frame buffer with the rest of the primary header encoded.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_NETWORK if a subnetwork has not been configured.
+         * @retval other from the subnetwork.
+         */
+        ccsds::error transmit(uint8_t* frame);
+
+        ccsds::base_service*                 subnetwork;    ///< Physical channel.
+        uint16_t                             scid;          ///< Spacecraft ID.
+        size_t                               frame_length;  ///< Length of each frame in bytes.
+        size_t                               frames;        ///< Number of frame buffers.
+        bool                                 error_control; ///< Frames have a frame error control field.
+        uint8_t                              count;         ///< Master channel frame count.
+        size_t                               cursor;        ///< Next frame buffer to try.
+        std::unique_ptr<uint8_t[]>           buffers;       ///< Frame buffers.
+        std::unique_ptr<std::atomic<bool>[]> busy;          ///< Frame buffers in use.
+        std::atomic<size_t>                  unused;        ///< Number of free frame buffers.
+};
+
+/**
+ * TM Virtual Channel Packet Service.
+ * Used as the subnetwork of packet services, multiplexing their packets
+ * into the frames of one virtual channel.  Packets are copied from their
+ * DU chain straight into the frame buffers, spanning frames as needed,
+ * and the first header pointer of each frame locates the first packet
+ * starting in it.
+ */
+class virtual_channel : public ccsds::base_service {
+    public:
+        /**
+         * Constructor.
+         * @param master Master channel to transmit frames on.
+         * @param vcid Virtual channel ID.
+         * @param pattern Octet the idle data is filled with.
+         */
+        virtual_channel(frame_service& master, uint8_t vcid, uint8_t pattern = 0xFF);
+
+        /**
+         * Destructor.
+         * A partially filled frame is discarded.
+         */
+        virtual ~virtual_channel();
+
+        virtual_channel(const virtual_channel&) = delete;
+        virtual_channel& operator=(const virtual_channel&) = delete;
+
+        /**
+         * Get the virtual channel ID.
+         * @return Virtual channel ID.
+         */
+        uint8_t id() const;
+
+        /**
+         * Transfer a space packet from a packet service.
+         * Frames are transmitted as soon as they are full.
+         * @param du Space packet to transfer.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if du is shorter than a primary header.
+         * @retval error::code::NO_SPACE if there are not enough free frame
+         * buffers for the packet, the packet is discarded.
+         * @retval other from the master channel, the packet is still
+         * written to the frames that follow.
+         */
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override;
+
+        /**
+         * Complete the partially filled frame with idle packets and
+         * transmit it.  An idle packet too long for the frame continues in
+         * the next frame.
+         * @retval error::code::NONE if successful, or there was no partially filled frame.
+         * @retval error::code::NO_SPACE if an idle packet continuing in the
+         * next frame does not have a free frame buffer.
+         * @retval other from the master channel.
+         */
+        ccsds::error flush();
+
+        /**
+         * Get the number of bytes written to the partially filled frame.
+         * @return Number of bytes in the frame data field.
+         */
+        size_t pending() const;
+
+    private:
+        /**
+         * Copy a space packet into the frames.
+         * @param du Space packet to copy.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::NO_SPACE if there are not enough free frame buffers.
+         * @retval other from the master channel.
+         */
+        ccsds::error write(const ccsds::base_du& du);
+
+        /**
+         * Transmit the current frame.
+         * @retval error::code::NONE if successful.
+         * @retval other from the master channel.
+         */
+        ccsds::error emit();
+
+        frame_service&           master;       ///< Master channel.
+        uint8_t                  vcid;         ///< Virtual channel ID.
+        uint8_t                  count;        ///< Virtual channel frame count.
+        uint8_t*                 frame;        ///< Frame being filled, nullptr if none.
+        size_t                   offset;       ///< Bytes written to the frame data field.
+        uint16_t                 first_header; ///< First header pointer of the frame.
+        ccsds::spp::idle_service idle;         ///< Idle packets for completing frames.
+};
+
+/**
+ * TM Virtual Channel Demultiplexer.
+ * Extracts the space packets of each virtual channel from received frames
+ * and passes them on to the packet service attached to the channel.
+ * Packets carried in one frame are passed on in place, only packets
+ * spanning frames are stitched together.  After a missing frame the
+ * channel resynchronizes on the first header pointer, and idle packets
+ * are discarded.
+ */
+class frame_demux {
+    public:
+        /**
+         * Constructor.
+         * @param scid Spacecraft ID of frames to accept.
+         * @param length Length of each frame in bytes.
+         * @param error_control Frames end with a frame error control field.
+         */
+        frame_demux(uint16_t scid, size_t length, bool error_control = false);
+
+        /**
+         * Destructor.
+         */
+        ~frame_demux() = default;
+
+        frame_demux(const frame_demux&) = delete;
+        frame_demux& operator=(const frame_demux&) = delete;
+
+        /**
+         * Attach a packet service to a virtual channel.
+         * @param vcid Virtual channel ID.
+         * @param service Service to receive packets, nullptr to detach.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if vcid is out of range.
+         */
+        ccsds::error attach(uint8_t vcid, ccsds::spp::packet_service* service);
+
+        /**
+         * Receive a frame from the physical channel.
+         * Frames of virtual channels without a packet service are discarded.
+         * @param frame Frame buffer.
+         * @param len Length of frame in bytes.
+         * @retval error::code::NONE if successful.
+         * @retval error::code::INVALID_ARG if the frame length, version,
+         * spacecraft ID or first header pointer is invalid.
+         * @retval error::code::IO_ERROR if the frame error control field is invalid.
+         */
+        ccsds::error reception(void* frame, size_t len);
+
+    private:
+        /**
+         * Reception state of a virtual channel.
+         */
+        struct channel {
+            ccsds::spp::packet_framer   framer;  ///< Packets spanning frames.
+            ccsds::spp::packet_service* service; ///< Service receiving packets.
+            uint8_t                     count;   ///< Last virtual channel frame count.
+            bool                        sync;    ///< Packet boundaries are known.
+
+            /**
+             * Pass a packet on to the service.
+             * @param packet Space packet.
+             */
+            void packet(const ccsds::buffered_du& packet);
+        };
+
+        uint16_t                 scid;                       ///< Spacecraft ID.
+        size_t                   frame_length;               ///< Length of each frame in bytes.
+        bool                     error_control;              ///< Frames have a frame error control field.
+        std::unique_ptr<channel> channels[VIRTUAL_CHANNELS]; ///< Virtual channels, by ID.
+};
+
+/** @} */ // group tm
+} // namespace tm
+} // namespace ccsds
+
+#endif // CCSDS_TM_H_
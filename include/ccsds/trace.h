@@ -0,0 +1,178 @@
+/**
+ * @file ccsds/trace.h
+ * Tracing of the packet paths
+ */
+
+#ifndef CCSDS_TRACE_H_
+#define CCSDS_TRACE_H_
+
+#include "ccsds/common.h"
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace ccsds {
+namespace trace {
+/**
+ * @addtogroup ccsds
+ * @{
+ */
+
+/**
+ * Instrumentation points along the packet paths.
+ */
+enum class point : uint8_t {
+    OCTET_REQUEST,    ///< Octet service request, including assembly and transfer.
+    ASSEMBLY,         ///< Octet service packet assembly.
+    PACKET_TRANSFER,  ///< Packet service transfer, including the subnetwork.
+    SUBNETWORK,       ///< Subnetwork transfer of a packet.
+    PACKET_RECEPTION, ///< Packet service reception, including the indication.
+    OCTET_RECEPTION,  ///< Octet service reception, including reassembly and the indication.
+    INDICATION,       ///< Indication callback of a received packet.
+};
+
+/**
+ * Number of instrumentation points.
+ */
+constexpr size_t POINTS = static_cast<size_t>(point::INDICATION) + 1;
+
+/**
+ * Packet sequence count of events where it is not known.
+ */
+constexpr uint16_t NO_COUNT = 0xFFFF;
+
+/**
+ * Number of events each thread can hold before they are drained.
+ */
+constexpr size_t RING_SIZE = 4096;
+
+/**
+ * Traced interval at an instrumentation point.
+ */
+struct event {
+    uint64_t begin;  ///< Time entering the point, in nanoseconds of the steady clock.
+    uint64_t end;    ///< Time leaving the point, in nanoseconds of the steady clock.
+    uint32_t size;   ///< Size of the packet or user data in bytes.
+    uint32_t thread; ///< Number of the thread, in order of its first event.
+    uint16_t apid;   ///< APID of the packet.
+    uint16_t count;  ///< Packet sequence count, NO_COUNT if not known.
+    point    where;  ///< Instrumentation point.
+};
+
+/**
+ * Get the current time of events.
+ * @return Time in nanoseconds of the steady clock.
+ */
+inline uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Get the name of an instrumentation point.
+ * @param where Instrumentation point.
+ * @return Name of the point.
+ */
+const char* name(point where);
+
+/**
+ * Record an event in the ring of the calling thread.
+ * The ring is lock-free and written only by its thread, an event is
+ * dropped if the ring is full.
+ * @param e Event to record, the thread is filled in.
+ */
+void record(const event& e);
+
+/**
+ * Take the recorded events of every thread.
+ * May run on any thread while events are being recorded.
+ * @param events Buffer for events.
+ * @param max Size of events.
+ * @return Number of events taken.
+ */
+size_t drain(event* events, size_t max);
+
+/**
+ * Get the number of events dropped because a ring was full.
+ * @return Number of dropped events.
+ */
+uint64_t dropped();
+
+/**
+ * Take the recorded events of every thread and write them in the Chrome
+ * trace event format, readable by Perfetto and chrome://tracing.
+ * @param out File to write to.
+ * @retval error::code::NONE if successful.
+ * @retval error::code::IO_ERROR if writing failed.
+ */
+ccsds::error dump(std::FILE* out);
+
+/**
+ * Event recorded for the lifetime of a scope.
+ */
+class scope {
+    public:
+        /**
+         * Constructor, entering the point.
+         * @param where Instrumentation point.
+         * @param apid APID of the packet.
+         * @param count Packet sequence count, NO_COUNT if not known.
+         * @param size Size of the packet or user data in bytes.
+         */
+        scope(point where, uint16_t apid, uint16_t count, size_t size) :
+            e{now(), 0, static_cast<uint32_t>(size), 0, apid, count, where}
+        {}
+
+        /**
+         * Constructor, entering the point with a space packet.
+         * @param where Instrumentation point.
+         * @param packet Space packet starting with its primary header.
+         */
+        scope(point where, const ccsds::base_du& packet) :
+            e{now(), 0, static_cast<uint32_t>(packet.totalSize()), 0, 0, NO_COUNT, where}
+        {
+            const uint8_t* header = static_cast<const uint8_t*>(packet.get());
+            if(packet.size() >= 4){
+                e.apid = ((header[0] & 0x07) << 8) | header[1];
+                e.count = ((header[2] & 0x3F) << 8) | header[3];
+            }
+        }
+
+        /**
+         * Destructor, leaving the point.
+         */
+        ~scope()
+        {
+            e.end = now();
+            record(e);
+        }
+
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+
+    private:
+        event e; ///< Event being traced.
+};
+
+/** @} */ // group ccsds
+} // namespace trace
+} // namespace ccsds
+
+#define CCSDS_TRACE_JOIN_(a, b) a##b
+#define CCSDS_TRACE_NAME_(line) CCSDS_TRACE_JOIN_(ccsds_trace_scope_, line)
+
+#ifdef CCSDS_TRACE
+/**
+ * Trace the rest of the enclosing scope at an instrumentation point.
+ * Takes the point, followed by either the APID, packet sequence count and
+ * size, or a DU starting with a primary header.  Without CCSDS_TRACE
+ * defined the hook and its arguments compile away.
+ */
+#define CCSDS_TRACE_SCOPE(where, ...) \
+    ccsds::trace::scope CCSDS_TRACE_NAME_(__LINE__)(ccsds::trace::point::where, __VA_ARGS__)
+#else
+#define CCSDS_TRACE_SCOPE(where, ...)
+#endif
+
+#endif // CCSDS_TRACE_H_
@@ -0,0 +1,462 @@
+/**
+ * @file loadtest/spp_loadtest.cpp
+ * End-to-end load test of the octet service.
+ */
+
+#include "ccsds/spp.h"
+#include "ccsds/spp_stats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @defgroup loadtest Load Test
+ * @{
+ * Producer threads request packets through octet services looped back to
+ * receiving octet services, recording the latency from each request to
+ * its indication.
+ */
+
+/**
+ * Number of heap allocations made by the calling thread.
+ */
+static thread_local uint64_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    void* p = std::malloc(size ? size : 1);
+    if(p == nullptr){
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+/**
+ * Histogram of latencies with logarithmic buckets, in the style of an HDR
+ * histogram.  Each power of two is split into SUB_BUCKETS / 2 linear
+ * buckets, so values are recorded with under 2 % error.
+ */
+class histogram {
+    public:
+        /**
+         * Bits of linear buckets below the first power of two.
+         */
+        static constexpr unsigned SUB_BITS = 7;
+
+        /**
+         * Number of linear buckets below the first power of two.
+         */
+        static constexpr uint64_t SUB_BUCKETS = uint64_t(1) << SUB_BITS;
+
+        /**
+         * Largest recordable value, larger values are clamped.
+         */
+        static constexpr uint64_t MAX_VALUE = (uint64_t(1) << 40) - 1;
+
+        histogram() :
+            counts(index(MAX_VALUE) + 1, 0),
+            total(0),
+            sum(0),
+            largest(0)
+        {}
+
+        /**
+         * Record a value.
+         * @param value Value to record.
+         */
+        void record(uint64_t value)
+        {
+            value = std::min(value, MAX_VALUE);
+            ++counts[index(value)];
+            ++total;
+            sum += value;
+            largest = std::max(largest, value);
+        }
+
+        /**
+         * Add the values of another histogram.
+         * @param other Histogram to add.
+         */
+        void merge(const histogram& other)
+        {
+            for(size_t i = 0; i < counts.size(); ++i){
+                counts[i] += other.counts[i];
+            }
+            total += other.total;
+            sum += other.sum;
+            largest = std::max(largest, other.largest);
+        }
+
+        /**
+         * Get the value at a percentile.
+         * @param percent Percentile, from 0 to 100.
+         * @return Highest value of the bucket holding the percentile.
+         */
+        uint64_t percentile(double percent) const
+        {
+            uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(percent / 100.0 * total + 0.5));
+            uint64_t seen = 0;
+            for(size_t i = 0; i < counts.size(); ++i){
+                seen += counts[i];
+                if(seen >= target){
+                    return std::min(highest(i), largest);
+                }
+            }
+            return largest;
+        }
+
+        /**
+         * Get the number of recorded values.
+         * @return Number of values.
+         */
+        uint64_t count() const
+        {
+            return total;
+        }
+
+        /**
+         * Get the mean of the recorded values.
+         * @return Mean value, 0 if there are none.
+         */
+        double mean() const
+        {
+            return total ? static_cast<double>(sum) / total : 0.0;
+        }
+
+        /**
+         * Get the largest recorded value.
+         * @return Largest value.
+         */
+        uint64_t max() const
+        {
+            return largest;
+        }
+
+    private:
+        /**
+         * Get the bucket of a value.
+         * @param value Value.
+         * @return Index of the bucket.
+         */
+        static size_t index(uint64_t value)
+        {
+            if(value < SUB_BUCKETS){
+                return value;
+            }
+            unsigned shift = 64 - __builtin_clzll(value) - SUB_BITS;
+            return SUB_BUCKETS + (shift - 1) * (SUB_BUCKETS / 2) + ((value >> shift) - SUB_BUCKETS / 2);
+        }
+
+        /**
+         * Get the highest value of a bucket.
+         * @param i Index of the bucket.
+         * @return Highest value recorded in the bucket.
+         */
+        static uint64_t highest(size_t i)
+        {
+            if(i < SUB_BUCKETS){
+                return i;
+            }
+            unsigned shift = (i - SUB_BUCKETS) / (SUB_BUCKETS / 2) + 1;
+            uint64_t top = (i - SUB_BUCKETS) % (SUB_BUCKETS / 2) + SUB_BUCKETS / 2;
+            return ((top + 1) << shift) - 1;
+        }
+
+        std::vector<uint64_t> counts;  ///< Number of values in each bucket.
+        uint64_t              total;   ///< Number of values.
+        uint64_t              sum;     ///< Sum of the values.
+        uint64_t              largest; ///< Largest value.
+};
+
+/**
+ * Load test configuration.
+ */
+struct options {
+    unsigned            threads = 1;                   ///< Number of producer threads.
+    unsigned            apids   = 4;                   ///< Number of APIDs of each thread.
+    uint64_t            packets = 1000000;             ///< Number of packets of each thread.
+    uint64_t            rate    = 0;                   ///< Packets per second of each thread, 0 for no limit.
+    uint64_t            budget  = 0;                   ///< Required packets per second in total, 0 for none.
+    bool                copy    = false;               ///< Request copies of user data instead of DUs.
+    bool                crc     = false;               ///< Packets have a packet error control field.
+    std::vector<size_t> sizes   = {16, 64, 256, 1024}; ///< User data lengths, used in turn.
+};
+
+/**
+ * Get the current time.
+ * @return Time in nanoseconds of the steady clock.
+ */
+static uint64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Loopback CCSDS service flattening each packet into a buffer and
+ * receiving it in place.
+ */
+class loadtest_loopback : public ccsds::base_service {
+    public:
+        loadtest_loopback() :
+            first(static_cast<ccsds::spp::apid>(0)),
+            buffer(sizeof(ccsds::spp::primary_header) + ccsds::spp::MAX_DATA_LENGTH)
+        {}
+
+        virtual ~loadtest_loopback() = default;
+
+        std::vector<ccsds::spp::octet_service*> services; ///< Services receiving packets, by APID offset.
+        ccsds::spp::apid                        first;    ///< APID of the first service.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override
+        {
+            ccsds::segment segments[8];
+            size_t count = sdu->gather(segments, 8);
+            size_t offset = 0;
+            for(size_t i = 0; i < count; ++i){
+                memcpy(buffer.data() + offset, segments[i].base, segments[i].len);
+                offset += segments[i].len;
+            }
+            ccsds::spp::packet_view packet(buffer.data(), offset);
+            services[packet.id() - first]->reception(packet, nullptr);
+            return ccsds::error();
+        }
+
+        std::vector<uint8_t> buffer; ///< Flattened packet.
+};
+
+/**
+ * Producer thread and the services it drives.
+ */
+class producer {
+    public:
+        /**
+         * Constructor.
+         * @param opts Load test configuration.
+         * @param first APID of the first service.
+         * @param stats Statistics of received packets.
+         */
+        producer(const options& opts, ccsds::spp::apid first, ccsds::spp::statistics& stats) :
+            received(0),
+            allocated(0),
+            elapsed(0),
+            opts(opts)
+        {
+            loopback.first = first;
+            for(unsigned i = 0; i < opts.apids; ++i){
+                ccsds::spp::apid id = static_cast<ccsds::spp::apid>(first + i);
+                transmit.push_back(std::make_unique<ccsds::spp::octet_service>(id, &loopback));
+                receive.push_back(std::make_unique<ccsds::spp::octet_service>(id, nullptr));
+                transmit.back()->set_error_control(opts.crc);
+                receive.back()->set_error_control(opts.crc);
+                receive.back()->set_statistics(&stats);
+                receive.back()->set_indication(ccsds::spp::octet_service::indication::bind<&producer::indication>(this));
+                loopback.services.push_back(receive.back().get());
+            }
+        }
+
+        /**
+         * Request every packet.
+         */
+        void run()
+        {
+            size_t largest = *std::max_element(opts.sizes.begin(), opts.sizes.end());
+            std::vector<uint8_t> data(largest, 0x5A);
+            uint64_t interval = opts.rate ? 1000000000 / opts.rate : 0;
+            uint64_t start = now();
+            uint64_t before = allocations;
+
+            for(uint64_t i = 0; i < opts.packets; ++i){
+                if(interval){
+                    while(now() < start + i * interval){
+                        std::this_thread::yield();
+                    }
+                }
+
+                // The request time travels in the user data
+                size_t len = opts.sizes[i % opts.sizes.size()];
+                uint64_t t = now();
+                memcpy(data.data(), &t, sizeof(t));
+                ccsds::spp::octet_service& service = *transmit[i % transmit.size()];
+                if(opts.copy){
+                    service.request(data.data(), len, false, ccsds::spp::TELEMETRY);
+                }else{
+                    service.request(std::make_unique<ccsds::buffered_du>(data.data(), len), false, ccsds::spp::TELEMETRY);
+                }
+            }
+
+            elapsed = now() - start;
+            allocated = allocations - before;
+        }
+
+        histogram latency;   ///< Latency from request to indication in nanoseconds.
+        uint64_t  received;  ///< Number of indications.
+        uint64_t  allocated; ///< Number of heap allocations while requesting.
+        uint64_t  elapsed;   ///< Time requesting every packet in nanoseconds.
+
+    private:
+        /**
+         * Receive user data.
+         * @param sdu User data.
+         * @param id APID of the packet.
+         * @param loss Packets were lost before the user data.
+         */
+        void indication(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool loss)
+        {
+            (void)id;
+            (void)loss;
+            uint64_t t;
+            memcpy(&t, sdu->get(), sizeof(t));
+            latency.record(now() - t);
+            ++received;
+        }
+
+        const options&                                          opts;     ///< Load test configuration.
+        loadtest_loopback                                       loopback; ///< Subnetwork of the transmitting services.
+        std::vector<std::unique_ptr<ccsds::spp::octet_service>> transmit; ///< Services requesting packets.
+        std::vector<std::unique_ptr<ccsds::spp::octet_service>> receive;  ///< Services receiving packets.
+};
+
+/**
+ * Print the usage.
+ * @param name Name of the program.
+ */
+static void usage(const char* name)
+{
+    std::printf("Usage: %s [options]\n"
+            "  --threads N    producer threads (1)\n"
+            "  --apids N      APIDs of each thread (4)\n"
+            "  --packets N    packets of each thread (1000000)\n"
+            "  --sizes A,B,.. user data lengths used in turn (16,64,256,1024)\n"
+            "  --rate N       packets per second of each thread, 0 for no limit (0)\n"
+            "  --budget N     required packets per second in total, fail below it (0)\n"
+            "  --copy         request copies of user data instead of DUs\n"
+            "  --crc          add the packet error control field\n", name);
+}
+
+/**
+ * Parse the command line.
+ * @param argc Number of arguments.
+ * @param argv Arguments.
+ * @param opts Load test configuration to fill.
+ * @return true if the command line is valid, false otherwise.
+ */
+static bool parse(int argc, char* argv[], options& opts)
+{
+    for(int i = 1; i < argc; ++i){
+        std::string arg = argv[i];
+        bool value = (i + 1 < argc);
+        if(arg == "--copy"){
+            opts.copy = true;
+        }else if(arg == "--crc"){
+            opts.crc = true;
+        }else if(value && (arg == "--threads")){
+            opts.threads = std::strtoul(argv[++i], nullptr, 0);
+        }else if(value && (arg == "--apids")){
+            opts.apids = std::strtoul(argv[++i], nullptr, 0);
+        }else if(value && (arg == "--packets")){
+            opts.packets = std::strtoull(argv[++i], nullptr, 0);
+        }else if(value && (arg == "--rate")){
+            opts.rate = std::strtoull(argv[++i], nullptr, 0);
+        }else if(value && (arg == "--budget")){
+            opts.budget = std::strtoull(argv[++i], nullptr, 0);
+        }else if(value && (arg == "--sizes")){
+            opts.sizes.clear();
+            for(char* p = argv[++i]; *p != '\0';){
+                opts.sizes.push_back(std::strtoul(p, &p, 0));
+                if(*p == ','){
+                    ++p;
+                }else if(*p != '\0'){
+                    return false;
+                }
+            }
+        }else{
+            return false;
+        }
+    }
+
+    size_t trailer = opts.crc ? sizeof(ccsds::spp::packet_error_control) : 0;
+    for(size_t len : opts.sizes){
+        if((len < sizeof(uint64_t)) || (len + trailer > ccsds::spp::MAX_DATA_LENGTH)){
+            return false;
+        }
+    }
+    return (opts.threads > 0) && (opts.apids > 0) && !opts.sizes.empty()
+            && (opts.threads * opts.apids < ccsds::spp::APID_IDLE);
+}
+
+int main(int argc, char* argv[])
+{
+    options opts;
+    if(!parse(argc, argv, opts)){
+        usage(argv[0]);
+        return 2;
+    }
+
+    ccsds::spp::statistics stats;
+    std::vector<std::unique_ptr<producer>> producers;
+    for(unsigned t = 0; t < opts.threads; ++t){
+        producers.push_back(std::make_unique<producer>(opts, static_cast<ccsds::spp::apid>(1 + t * opts.apids), stats));
+    }
+
+    std::vector<std::thread> threads;
+    uint64_t start = now();
+    for(auto& p : producers){
+        threads.emplace_back(&producer::run, p.get());
+    }
+    for(auto& t : threads){
+        t.join();
+    }
+    uint64_t elapsed = now() - start;
+
+    histogram latency;
+    uint64_t received = 0;
+    uint64_t allocated = 0;
+    for(auto& p : producers){
+        latency.merge(p->latency);
+        received += p->received;
+        allocated += p->allocated;
+    }
+    uint64_t sent = opts.packets * opts.threads;
+    ccsds::spp::counters c = stats.total();
+    double rate = sent * 1e9 / elapsed;
+
+    std::printf("threads %u, APIDs %u, %s requests%s\n", opts.threads, opts.threads * opts.apids,
+            opts.copy ? "copy" : "DU", opts.crc ? " with error control" : "");
+    std::printf("packets     sent %llu, received %llu, missing %llu, malformed %llu\n",
+            static_cast<unsigned long long>(sent), static_cast<unsigned long long>(received),
+            static_cast<unsigned long long>(c.missing), static_cast<unsigned long long>(c.malformed));
+    std::printf("throughput  %.0f packets/s, %.1f MB/s\n", rate, c.bytes * 1e3 / elapsed);
+    std::printf("latency us  p50 %.3f, p99 %.3f, p99.9 %.3f, max %.3f, mean %.3f\n",
+            latency.percentile(50) / 1e3, latency.percentile(99) / 1e3, latency.percentile(99.9) / 1e3,
+            latency.max() / 1e3, latency.mean() / 1e3);
+    std::printf("allocations %.2f per packet\n", static_cast<double>(allocated) / sent);
+
+    bool lost = (received != sent) || (c.missing != 0);
+    if(opts.budget){
+        std::printf("budget      %llu packets/s %s\n", static_cast<unsigned long long>(opts.budget),
+                (rate >= opts.budget) ? "met" : "NOT met");
+    }
+    return (lost || (rate < opts.budget)) ? 1 : 0;
+}
+
+/** @} */ // group loadtest
@@ -0,0 +1,56 @@
+/**
+ * @file base_du.cpp
+ */
+
+#include "ccsds/common.h"
+#include <atomic>
+#include <new>
+
+/**
+ * @ingroup ccsds
+ * @{
+ */
+namespace ccsds {
+
+/**
+ * Allocator used for all DU nodes, nullptr for the heap.
+ */
+static std::atomic<du_allocator*> node_allocator(nullptr);
+
+void base_du::set_allocator(du_allocator* alloc)
+{
+    node_allocator.store(alloc, std::memory_order_release);
+}
+
+void* base_du::allocate(size_t size)
+{
+    du_allocator* alloc = node_allocator.load(std::memory_order_acquire);
+    if(alloc != nullptr){
+        void* p = alloc->allocate(size);
+        if(p != nullptr){
+            return p;
+        }
+    }
+    return ::operator new(size);
+}
+
+void base_du::deallocate(void* p, size_t size)
+{
+    du_allocator* alloc = node_allocator.load(std::memory_order_acquire);
+    if((alloc == nullptr) || !alloc->deallocate(p, size)){
+        ::operator delete(p);
+    }
+}
+
+void* base_du::operator new(size_t size)
+{
+    return allocate(size);
+}
+
+void base_du::operator delete(void* p, size_t size)
+{
+    deallocate(p, size);
+}
+
+} // namespace ccsds
+/**@} ccsds*/
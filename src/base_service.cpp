@@ -10,6 +10,30 @@
  */
 namespace ccsds {
 
+ccsds::error base_service::transfer_batch(std::unique_ptr<const base_du> dus[], size_t count)
+{
+    for(size_t i = 0; i < count; ++i){
+        ccsds::error e = transfer(std::move(dus[i]));
+        if(e){
+            return e;
+        }
+    }
+    return error();
+}
+
+ccsds::error base_service::transfer_async(std::unique_ptr<const base_du> du, completion done)
+{
+    ccsds::error e = transfer(std::move(du));
+    if(done){
+        done(e);
+    }
+    return error();
+}
+
+size_t base_service::credit() const
+{
+    return SIZE_MAX;
+}
 
 } // namespace ccsds
 /**@} ccsds*/
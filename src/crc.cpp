@@ -0,0 +1,269 @@
+/**
+ * @file crc.cpp
+ */
+
+#include "ccsds/crc.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CCSDS_CRC_X86
+#elif defined(__aarch64__) && (defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_AES))
+#include <arm_neon.h>
+#define CCSDS_CRC_PMULL
+#endif
+
+namespace ccsds {
+/**
+ * @ingroup ccsds
+ * @{
+ */
+
+/**
+ * Slice-by-8 lookup tables, table k holds the CRC of each octet followed
+ * by k zero octets.
+ */
+struct crc16_tables {
+    uint16_t table[8][256]; ///< Lookup tables.
+};
+
+/**
+ * Build the slice-by-8 lookup tables from CRC16_TABLE.
+ * @return Lookup tables.
+ */
+static constexpr crc16_tables make_tables()
+{
+    crc16_tables t = {};
+    for(uint32_t v = 0; v < 256; ++v){
+        t.table[0][v] = CRC16_TABLE.table[v];
+    }
+    for(size_t k = 1; k < 8; ++k){
+        for(uint32_t v = 0; v < 256; ++v){
+            uint16_t prev = t.table[k - 1][v];
+            t.table[k][v] = static_cast<uint16_t>((prev << 8) ^ t.table[0][prev >> 8]);
+        }
+    }
+    return t;
+}
+
+static constexpr crc16_tables TABLES = make_tables();
+
+static uint16_t crc16_table(const uint8_t* p, size_t len, uint16_t crc)
+{
+    const auto& t = TABLES.table;
+    for(; len >= 8; len -= 8, p += 8){
+        crc = t[7][p[0] ^ (crc >> 8)] ^ t[6][p[1] ^ (crc & 0xFF)]
+                ^ t[5][p[2]] ^ t[4][p[3]] ^ t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+    }
+    for(; len > 0; --len, ++p){
+        crc = static_cast<uint16_t>((crc << 8) ^ t[0][(crc >> 8) ^ *p]);
+    }
+    return crc;
+}
+
+#if defined(CCSDS_CRC_X86) || defined(CCSDS_CRC_PMULL)
+
+/**
+ * Compute x^n modulo the CRC polynomial.
+ * @param n Exponent.
+ * @return Remainder.
+ */
+static constexpr uint64_t xpow(size_t n)
+{
+    uint32_t r = 1;
+    for(size_t i = 0; i < n; ++i){
+        r <<= 1;
+        r = (r & 0x10000) ? (r ^ CRC16_POLY) : r;
+    }
+    return r;
+}
+
+/**
+ * Minimum length folded with carry-less multiplication, in bytes.
+ */
+static constexpr size_t FOLD_MIN = 64;
+
+#endif
+
+#ifdef CCSDS_CRC_X86
+
+/**
+ * Load 16 bytes, reversed so the first octet is the most significant.
+ * @param p Bytes to load.
+ * @return Loaded value.
+ */
+__attribute__((target("ssse3")))
+static inline __m128i crc16_load(const uint8_t* p)
+{
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), reverse);
+}
+
+/**
+ * Fold 128 bits forward by the distance encoded in k.
+ * @param x Value to fold, high half x^64 times more significant.
+ * @param k x^(d+64) and x^d modulo the polynomial, high and low.
+ * @return Folded value, congruent to x times x^d.
+ */
+__attribute__((target("pclmul,ssse3")))
+static inline __m128i crc16_fold(__m128i x, __m128i k)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x11), _mm_clmulepi64_si128(x, k, 0x00));
+}
+
+__attribute__((target("pclmul,ssse3")))
+static uint16_t crc16_clmul(const uint8_t* p, size_t len, uint16_t crc)
+{
+    const __m128i k4 = _mm_set_epi64x(xpow(512 + 64), xpow(512));
+    const __m128i k1 = _mm_set_epi64x(xpow(128 + 64), xpow(128));
+
+    // The initial CRC is added to the first 16 bits of the data
+    __m128i x0 = _mm_xor_si128(crc16_load(p), _mm_set_epi64x(static_cast<uint64_t>(crc) << 48, 0));
+    __m128i x1 = crc16_load(p + 16);
+    __m128i x2 = crc16_load(p + 32);
+    __m128i x3 = crc16_load(p + 48);
+    p += 64;
+    len -= 64;
+
+    // Fold four independent lanes 512 bits forward
+    for(; len >= 64; len -= 64, p += 64){
+        x0 = _mm_xor_si128(crc16_fold(x0, k4), crc16_load(p));
+        x1 = _mm_xor_si128(crc16_fold(x1, k4), crc16_load(p + 16));
+        x2 = _mm_xor_si128(crc16_fold(x2, k4), crc16_load(p + 32));
+        x3 = _mm_xor_si128(crc16_fold(x3, k4), crc16_load(p + 48));
+    }
+
+    // Combine the lanes and fold the remaining blocks 128 bits forward
+    x1 = _mm_xor_si128(crc16_fold(x0, k1), x1);
+    x2 = _mm_xor_si128(crc16_fold(x1, k1), x2);
+    x3 = _mm_xor_si128(crc16_fold(x2, k1), x3);
+    for(; len >= 16; len -= 16, p += 16){
+        x3 = _mm_xor_si128(crc16_fold(x3, k1), crc16_load(p));
+    }
+
+    // The CRC of the folded 128 bits is the CRC of the data folded so far
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    alignas(16) uint8_t folded[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(folded), _mm_shuffle_epi8(x3, reverse));
+    crc = crc16_table(folded, sizeof(folded), 0);
+    return crc16_table(p, len, crc);
+}
+
+#endif // CCSDS_CRC_X86
+
+#ifdef CCSDS_CRC_PMULL
+
+/**
+ * Load 16 bytes, reversed so the first octet is the most significant.
+ * @param p Bytes to load.
+ * @return Loaded value.
+ */
+static inline uint8x16_t crc16_load(const uint8_t* p)
+{
+    uint8x16_t x = vrev64q_u8(vld1q_u8(p));
+    return vextq_u8(x, x, 8);
+}
+
+/**
+ * Fold 128 bits forward by the distance encoded in k.
+ * @param x Value to fold, high half x^64 times more significant.
+ * @param k x^d and x^(d+64) modulo the polynomial, low and high.
+ * @return Folded value, congruent to x times x^d.
+ */
+static inline uint8x16_t crc16_fold(uint8x16_t x, poly64x2_t k)
+{
+    poly64x2_t v = vreinterpretq_p64_u8(x);
+    poly128_t high = vmull_high_p64(v, k);
+    poly128_t low = vmull_p64(vgetq_lane_p64(v, 0), vgetq_lane_p64(k, 0));
+    return veorq_u8(vreinterpretq_u8_p128(high), vreinterpretq_u8_p128(low));
+}
+
+static uint16_t crc16_clmul(const uint8_t* p, size_t len, uint16_t crc)
+{
+    const poly64x2_t k4 = vcombine_p64(vcreate_p64(xpow(512)), vcreate_p64(xpow(512 + 64)));
+    const poly64x2_t k1 = vcombine_p64(vcreate_p64(xpow(128)), vcreate_p64(xpow(128 + 64)));
+
+    // The initial CRC is added to the first 16 bits of the data
+    uint8x16_t init = vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(0), vcreate_u64(static_cast<uint64_t>(crc) << 48)));
+    uint8x16_t x0 = veorq_u8(crc16_load(p), init);
+    uint8x16_t x1 = crc16_load(p + 16);
+    uint8x16_t x2 = crc16_load(p + 32);
+    uint8x16_t x3 = crc16_load(p + 48);
+    p += 64;
+    len -= 64;
+
+    // Fold four independent lanes 512 bits forward
+    for(; len >= 64; len -= 64, p += 64){
+        x0 = veorq_u8(crc16_fold(x0, k4), crc16_load(p));
+        x1 = veorq_u8(crc16_fold(x1, k4), crc16_load(p + 16));
+        x2 = veorq_u8(crc16_fold(x2, k4), crc16_load(p + 32));
+        x3 = veorq_u8(crc16_fold(x3, k4), crc16_load(p + 48));
+    }
+
+    // Combine the lanes and fold the remaining blocks 128 bits forward
+    x1 = veorq_u8(crc16_fold(x0, k1), x1);
+    x2 = veorq_u8(crc16_fold(x1, k1), x2);
+    x3 = veorq_u8(crc16_fold(x2, k1), x3);
+    for(; len >= 16; len -= 16, p += 16){
+        x3 = veorq_u8(crc16_fold(x3, k1), crc16_load(p));
+    }
+
+    // The CRC of the folded 128 bits is the CRC of the data folded so far
+    uint8_t folded[16];
+    uint8x16_t r = vrev64q_u8(x3);
+    vst1q_u8(folded, vextq_u8(r, r, 8));
+    crc = crc16_table(folded, sizeof(folded), 0);
+    return crc16_table(p, len, crc);
+}
+
+#endif // CCSDS_CRC_PMULL
+
+/**
+ * CRC kernel.
+ * @param p Buffer.
+ * @param len Length of p in bytes.
+ * @param crc CRC of the preceding data.
+ * @return CRC of the preceding data and p.
+ */
+typedef uint16_t (*crc_kernel)(const uint8_t* p, size_t len, uint16_t crc);
+
+/**
+ * Select the fastest CRC kernel supported by the processor for large buffers.
+ * @return CRC kernel.
+ */
+static crc_kernel select_kernel()
+{
+#if defined(CCSDS_CRC_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3")){
+        return &crc16_clmul;
+    }
+#elif defined(CCSDS_CRC_PMULL)
+    return &crc16_clmul;
+#endif
+    return &crc16_table;
+}
+
+uint16_t crc16(const void* buf, size_t len, uint16_t crc)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(buf);
+#if defined(CCSDS_CRC_X86) || defined(CCSDS_CRC_PMULL)
+    static const crc_kernel kernel = select_kernel();
+    if(len >= FOLD_MIN){
+        return kernel(p, len, crc);
+    }
+#endif
+    return crc16_table(p, len, crc);
+}
+
+uint16_t crc16(const base_du& du, uint16_t crc)
+{
+    for(const base_du* node = &du; ; node = &node->next()){
+        crc = crc16(node->get(), node->size(), crc);
+        if(node->length() == 1){
+            return crc;
+        }
+    }
+}
+
+/** @} */ // group ccsds
+} // namespace ccsds
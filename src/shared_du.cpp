@@ -0,0 +1,37 @@
+/**
+ * @file shared_du.cpp
+ */
+
+#include "ccsds/shared_du.h"
+
+/**
+ * @ingroup ccsds
+ * @{
+ */
+namespace ccsds {
+
+shared_payload* shared_payload::create(std::unique_ptr<const base_du> du, bool concurrent)
+{
+    return new shared_payload(std::move(du), concurrent);
+}
+
+std::unique_ptr<const base_du> shared_du::share(const shared_payload& payload)
+{
+    // Views are linked at the end of the chain without walking it
+    du_chain chain;
+    for(const base_du* node = &payload.chain(); ; node = &node->next()){
+        if(node->size() > 0){
+            chain.append(std::make_unique<shared_du>(payload, node->get(), node->size()));
+        }
+        if(node->length() == 1){
+            break;
+        }
+    }
+    if(chain.empty()){
+        chain.append(std::make_unique<shared_du>(payload, nullptr, 0));
+    }
+    return chain.take();
+}
+
+} // namespace ccsds
+/**@} ccsds*/
@@ -0,0 +1,169 @@
+/**
+ * @file socket_service.cpp
+ */
+
+#include "ccsds/socket.h"
+#include <cerrno>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <vector>
+
+static_assert(sizeof(ccsds::segment) == sizeof(struct iovec));
+
+/**
+ * @ingroup ccsds
+ * @{
+ */
+namespace ccsds {
+
+socket_service::socket_service(int fd) :
+    fd(fd),
+    stream(false)
+{
+    int type = 0;
+    socklen_t len = sizeof(type);
+    if((fd >= 0) && (getsockopt(fd, SOL_SOCKET, SO_TYPE, &type, &len) == 0)){
+        stream = (type == SOCK_STREAM);
+    }
+}
+
+ccsds::error socket_service::transfer(std::unique_ptr<const ccsds::base_du> du)
+{
+    if(fd < 0){
+        return error(error::code::NO_NETWORK);
+    }
+
+    ccsds::segment segments[MAX_SEGMENTS];
+    size_t count = du->gather(segments, MAX_SEGMENTS);
+    if(count <= MAX_SEGMENTS){
+        return write(segments, count);
+    }else if(!stream){
+        // A datagram must be sent with a single system call
+        return error(error::code::INVALID_ARG);
+    }
+
+    return write(*du, count);
+}
+
+ccsds::error socket_service::transfer_batch(std::unique_ptr<const ccsds::base_du> dus[], size_t count)
+{
+    if(!stream){
+        // Each datagram must be sent on its own
+        return base_service::transfer_batch(dus, count);
+    }else if(fd < 0){
+        return error(error::code::NO_NETWORK);
+    }
+
+    ccsds::segment segments[MAX_SEGMENTS];
+    size_t used = 0;  // Segments waiting to be written.
+    size_t first = 0; // First DU waiting to be written.
+    for(size_t i = 0; i < count; ++i){
+        size_t n = dus[i]->gather(&segments[used], MAX_SEGMENTS - used);
+        if(used + n <= MAX_SEGMENTS){
+            used += n;
+            continue;
+        }
+
+        // Flush the DUs before this one to make room
+        if(used > 0){
+            ccsds::error e = write(segments, used);
+            if(e){
+                return e;
+            }
+            for(; first < i; ++first){
+                dus[first].reset();
+            }
+            used = 0;
+        }
+
+        n = dus[i]->gather(segments, MAX_SEGMENTS);
+        if(n <= MAX_SEGMENTS){
+            used = n;
+        }else{
+            ccsds::error e = write(*dus[i], n);
+            if(e){
+                return e;
+            }
+            dus[i].reset();
+            first = i + 1;
+        }
+    }
+
+    if(used > 0){
+        ccsds::error e = write(segments, used);
+        if(e){
+            return e;
+        }
+    }
+    for(; first < count; ++first){
+        dus[first].reset();
+    }
+    return error();
+}
+
+ccsds::error socket_service::write(const ccsds::base_du& du, size_t count)
+{
+    // Long chains on a stream socket are written in several calls
+    std::vector<ccsds::segment> all(count);
+    du.gather(all.data(), count);
+    for(size_t i = 0; i < count; i += MAX_SEGMENTS){
+        size_t n = (count - i < MAX_SEGMENTS) ? (count - i) : MAX_SEGMENTS;
+        ccsds::error e = write(&all[i], n, i > 0);
+        if(e){
+            return e;
+        }
+    }
+    return error();
+}
+
+ccsds::error socket_service::write(ccsds::segment* segments, size_t count, bool started)
+{
+    struct iovec iov[MAX_SEGMENTS];
+    for(size_t i = 0; i < count; ++i){
+        iov[i].iov_base = const_cast<void*>(segments[i].base);
+        iov[i].iov_len = segments[i].len;
+    }
+
+    struct msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    while(msg.msg_iovlen > 0){
+        ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if(sent < 0){
+            if(errno == EINTR){
+                continue;
+            }else if((errno != EAGAIN) && (errno != EWOULDBLOCK)){
+                return error(error::code::IO_ERROR);
+            }else if(!started){
+                return error(error::code::NO_SPACE);
+            }
+
+            // Part of the DU is on the wire, wait until the rest fits
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            if((poll(&pfd, 1, -1) < 0) && (errno != EINTR)){
+                return error(error::code::IO_ERROR);
+            }
+            continue;
+        }else if(!stream){
+            return error();
+        }
+
+        // Skip over the segments written by a partial write
+        started = true;
+        size_t written = sent;
+        while((msg.msg_iovlen > 0) && (written >= msg.msg_iov->iov_len)){
+            written -= msg.msg_iov->iov_len;
+            ++msg.msg_iov;
+            --msg.msg_iovlen;
+        }
+        if(msg.msg_iovlen > 0){
+            msg.msg_iov->iov_base = static_cast<uint8_t*>(msg.msg_iov->iov_base) + written;
+            msg.msg_iov->iov_len -= written;
+        }
+    }
+    return error();
+}
+
+} // namespace ccsds
+/**@} ccsds*/
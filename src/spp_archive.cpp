@@ -0,0 +1,406 @@
+/**
+ * @file spp_archive.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_archive.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+/**
+ * Read-only memory mapping of a file.
+ */
+struct archive_reader::mapping {
+    /**
+     * Constructor.
+     * @param base Start of the mapping.
+     * @param len Length of the mapping in bytes.
+     * @param st Status of the mapped file.
+     */
+    mapping(const void* base, size_t len, const struct stat& st) :
+        base(static_cast<const uint8_t*>(base)),
+        len(len),
+        inode(st.st_ino),
+        mtime((static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000) + st.st_mtim.tv_nsec)
+    {}
+
+    /**
+     * Destructor.
+     */
+    ~mapping()
+    {
+        if(base != nullptr){
+            munmap(const_cast<uint8_t*>(base), len);
+        }
+    }
+
+    const uint8_t* base;  ///< Start of the mapping.
+    size_t         len;   ///< Length of the mapping in bytes.
+    uint64_t       inode; ///< Inode number of the file.
+    uint64_t       mtime; ///< Modification time of the file in nanoseconds.
+};
+
+/**
+ * Index file header, followed by the offset of each packet.
+ * The archive is identified by its inode, size and modification time when
+ * the index was written, so a stale or foreign index is found without
+ * reading the archive.
+ * @note Index files are in host byte order.
+ */
+struct index_header {
+    char     magic[8]; ///< INDEX_MAGIC.
+    uint64_t covered;  ///< Number of bytes of the archive covered by the index.
+    uint64_t count;    ///< Number of packets in the index.
+    uint64_t last;     ///< Size of the last packet in bytes.
+    uint64_t size;     ///< Size of the archive in bytes.
+    uint64_t mtime;    ///< Modification time of the archive in nanoseconds.
+    uint64_t inode;    ///< Inode number of the archive.
+};
+
+static constexpr char INDEX_MAGIC[8] = {'C', 'C', 'S', 'D', 'S', 'I', 'D', 'X'};
+
+std::shared_ptr<const archive_reader::mapping> archive_reader::map(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0){
+        return nullptr;
+    }
+
+    std::shared_ptr<const mapping> mapped;
+    struct stat st;
+    if(fstat(fd, &st) == 0){
+        if(st.st_size == 0){
+            mapped = std::make_shared<const mapping>(nullptr, 0, st);
+        }else{
+            void* base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if(base != MAP_FAILED){
+                mapped = std::make_shared<const mapping>(base, st.st_size, st);
+            }
+        }
+    }
+    ::close(fd);
+    return mapped;
+}
+
+archive_reader::archive_reader() :
+    offsets(nullptr),
+    count(0)
+{
+
+}
+
+ccsds::error archive_reader::open(const std::string& path, bool persist)
+{
+    close();
+    file = map(path);
+    if(file == nullptr){
+        return error(error::code::IO_ERROR);
+    }
+
+    // Only index the packets added since the index file was written, the
+    // mapped index is kept and the new packets follow it
+    std::string index_path = path + ".idx";
+    size_t covered = scan(load(index_path));
+    if(!built.empty() && persist){
+        save(index_path, covered);
+    }
+    return error();
+}
+
+void archive_reader::close()
+{
+    file.reset();
+    index.reset();
+    offsets = nullptr;
+    count = 0;
+    std::vector<uint64_t>().swap(built);
+}
+
+size_t archive_reader::size() const
+{
+    return count + built.size();
+}
+
+std::unique_ptr<const ccsds::base_du> archive_reader::view(size_t i) const
+{
+    size_t len;
+    if(!bounds(i, len)){
+        return nullptr;
+    }
+    size_t offset = this->offset(i);
+    return std::make_unique<ccsds::view_du>(file, &file->base[offset], len);
+}
+
+std::unique_ptr<ccsds::spp::pdu> archive_reader::packet(size_t i) const
+{
+    size_t len;
+    if(!bounds(i, len)){
+        return nullptr;
+    }
+    size_t offset = this->offset(i);
+    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+    std::memcpy(&(*pdu)->header, &file->base[offset], sizeof(primary_header));
+    pdu->append(std::make_unique<ccsds::view_du>(file,
+            &file->base[offset + sizeof(primary_header)],
+            len - sizeof(primary_header)));
+    return pdu;
+}
+
+const uint8_t* archive_reader::data() const
+{
+    return (file != nullptr) ? file->base : nullptr;
+}
+
+size_t archive_reader::length() const
+{
+    return (file != nullptr) ? file->len : 0;
+}
+
+std::shared_ptr<const void> archive_reader::owner() const
+{
+    return file;
+}
+
+size_t archive_reader::load(const std::string& path)
+{
+    std::shared_ptr<const mapping> mapped = map(path);
+    if((mapped == nullptr) || (mapped->len < sizeof(index_header))){
+        return 0;
+    }
+
+    // The index must belong to this archive, which may only have grown
+    // since, and the entries are counted without multiplying so a corrupt
+    // count can not overflow
+    const index_header* header = reinterpret_cast<const index_header*>(mapped->base);
+    const uint64_t* entries = reinterpret_cast<const uint64_t*>(header + 1);
+    size_t entries_len = mapped->len - sizeof(index_header);
+    if((std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+            || ((entries_len % sizeof(uint64_t)) != 0)
+            || (header->count != entries_len / sizeof(uint64_t))
+            || (header->inode != file->inode)
+            || (header->size > file->len)
+            || ((header->size == file->len) && (header->mtime != file->mtime))
+            || (header->covered > header->size)){
+        return 0;
+    }
+
+    // Only the index itself is checked, so opening an archive does not
+    // read it.  Offsets must start at the beginning of the archive and
+    // increase by at least the smallest packet, and the last packet must
+    // end at the covered bytes.  Packets are bounds checked once viewed.
+    if(header->count == 0){
+        if(header->covered != 0){
+            return 0;
+        }
+    }else{
+        if((entries[0] != 0) || (header->last <= sizeof(primary_header))
+                || (header->covered - entries[header->count - 1] != header->last)){
+            return 0;
+        }
+        for(size_t i = 1; i < header->count; ++i){
+            if((entries[i] <= entries[i - 1]) || (entries[i] - entries[i - 1] <= sizeof(primary_header))){
+                return 0;
+            }
+        }
+    }
+
+    index = mapped;
+    offsets = entries;
+    count = header->count;
+    return header->covered;
+}
+
+size_t archive_reader::scan(size_t offset)
+{
+    while(file->len - offset >= sizeof(primary_header)){
+        size_t size = packet_size(offset);
+        if(file->len - offset < size){
+            // The last packet is incomplete
+            break;
+        }
+        built.push_back(offset);
+        offset += size;
+    }
+    return offset;
+}
+
+void archive_reader::save(const std::string& path, size_t covered) const
+{
+    // Replace the index atomically, failing to write it is not an error
+    std::string temp = path + ".tmp";
+    FILE* f = std::fopen(temp.c_str(), "wb");
+    if(f == nullptr){
+        return;
+    }
+    index_header header;
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header.covered = covered;
+    header.count = size();
+    header.last = (size() > 0) ? covered - offset(size() - 1) : 0;
+    header.size = file->len;
+    header.mtime = file->mtime;
+    header.inode = file->inode;
+    bool ok = (std::fwrite(&header, sizeof(header), 1, f) == 1)
+            && ((count == 0) || (std::fwrite(offsets, sizeof(uint64_t), count, f) == count))
+            && (built.empty() || (std::fwrite(built.data(), sizeof(uint64_t), built.size(), f) == built.size()));
+    ok = (std::fclose(f) == 0) && ok;
+    if(!ok || (std::rename(temp.c_str(), path.c_str()) != 0)){
+        std::remove(temp.c_str());
+    }
+}
+
+bool archive_reader::bounds(size_t i, size_t& len) const
+{
+    if(i >= size()){
+        return false;
+    }
+    size_t offset = this->offset(i);
+    if(file->len - offset < sizeof(primary_header)){
+        return false;
+    }
+    len = packet_size(offset);
+    return file->len - offset >= len;
+}
+
+size_t archive_reader::packet_size(size_t offset) const
+{
+    // The data length field is big endian and holds the data length - 1
+    const uint8_t* header = &file->base[offset];
+    size_t data_length = (static_cast<size_t>(header[4]) << 8) | header[5];
+    return sizeof(primary_header) + data_length + 1;
+}
+
+archive_writer::archive_writer() :
+    fd(-1)
+{
+
+}
+
+archive_writer::~archive_writer()
+{
+    close();
+}
+
+ccsds::error archive_writer::open(const std::string& path)
+{
+    close();
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if(fd < 0){
+        return error(error::code::IO_ERROR);
+    }
+    return error();
+}
+
+void archive_writer::close()
+{
+    if(fd >= 0){
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+ccsds::error archive_writer::sync()
+{
+    if(fd < 0){
+        return error(error::code::NO_NETWORK);
+    }else if(fdatasync(fd) != 0){
+        return error(error::code::IO_ERROR);
+    }
+    return error();
+}
+
+ccsds::error archive_writer::transfer(std::unique_ptr<const ccsds::base_du> du)
+{
+    if(fd < 0){
+        return error(error::code::NO_NETWORK);
+    }
+
+    size_t n = du->gather(nullptr, 0);
+    pending.resize(n);
+    du->gather(pending.data(), n);
+    return write(pending.data(), n);
+}
+
+ccsds::error archive_writer::transfer_batch(std::unique_ptr<const ccsds::base_du> dus[], size_t count)
+{
+    if(fd < 0){
+        return error(error::code::NO_NETWORK);
+    }
+
+    size_t used = 0;  // Segments waiting to be written.
+    size_t first = 0; // First DU waiting to be written.
+    for(size_t i = 0; i < count; ++i){
+        size_t n = dus[i]->gather(nullptr, 0);
+        pending.resize(used + n);
+        dus[i]->gather(&pending[used], n);
+        used += n;
+        if((used < MAX_SEGMENTS) && (i + 1 < count)){
+            continue;
+        }
+
+        ccsds::error e = write(pending.data(), used);
+        if(e){
+            return e;
+        }
+        for(; first <= i; ++first){
+            dus[first].reset();
+        }
+        used = 0;
+    }
+    return error();
+}
+
+ccsds::error archive_writer::write(ccsds::segment* segments, size_t count)
+{
+    struct iovec iov[MAX_SEGMENTS];
+    while(count > 0){
+        size_t n = (count < MAX_SEGMENTS) ? count : MAX_SEGMENTS;
+        for(size_t i = 0; i < n; ++i){
+            iov[i].iov_base = const_cast<void*>(segments[i].base);
+            iov[i].iov_len = segments[i].len;
+        }
+        segments += n;
+        count -= n;
+
+        struct iovec* next = iov;
+        while(n > 0){
+            ssize_t written = writev(fd, next, n);
+            if(written < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+                return error(error::code::IO_ERROR);
+            }
+
+            // Skip over the segments written by a partial write
+            size_t done = written;
+            while((n > 0) && (done >= next->iov_len)){
+                done -= next->iov_len;
+                ++next;
+                --n;
+            }
+            if(n > 0){
+                next->iov_base = static_cast<uint8_t*>(next->iov_base) + done;
+                next->iov_len -= done;
+            }
+        }
+    }
+    return error();
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
@@ -0,0 +1,343 @@
+/**
+ * @file spp_decode.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_decode.h"
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CCSDS_DECODE_X86
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CCSDS_DECODE_NEON
+#endif
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+/**
+ * Header decoding kernel.
+ * @param headers Primary headers to decode.
+ * @param i Index of the first header to decode.
+ * @param count Number of headers.
+ * @param fields Arrays to decode the headers to.
+ * @param limit Maximum value of the data length field.
+ * @return Index of the first header not decoded.
+ */
+typedef size_t (*decoder)(const primary_header* headers, size_t i, size_t count, const header_fields& fields, uint16_t limit);
+
+static size_t decode_scalar(const primary_header* headers, size_t i, size_t count, const header_fields& fields, uint16_t limit)
+{
+    for(; i < count; ++i){
+        uint16_t ident = ccsds::ntohs(headers[i].identification);
+        uint16_t sequence = ccsds::ntohs(headers[i].sequence_control);
+        uint16_t length = ccsds::ntohs(headers[i].data_length);
+        if(((ident >> PACKET_VERSION_SHIFT) != PACKET_VERSION_1) || (length > limit)){
+            break;
+        }
+        fields.apid[i] = ident & PACKET_APID_MASK;
+        fields.type[i] = (ident >> PACKET_TYPE_SHIFT) & PACKET_TYPE_MASK;
+        fields.secondary[i] = (ident >> PACKET_SEC_HDR_SHIFT) & 1;
+        fields.flags[i] = sequence >> SEQUENCE_FLAGS_SHIFT;
+        fields.count[i] = sequence & SEQUENCE_COUNT_MASK;
+        fields.length[i] = static_cast<uint32_t>(length) + 1;
+    }
+    return i;
+}
+
+#ifdef CCSDS_DECODE_X86
+
+/**
+ * Byte shuffles gathering one field of eight headers from one 16 byte
+ * part of the headers, swapping each field to host byte order.  Built at
+ * compile time, each shuffle is repeated in both 128-bit lanes so the
+ * AVX2 kernel loads it directly and the SSSE3 kernel loads the low lane.
+ */
+struct shuffle_table {
+    alignas(32) int8_t mask[3][3][32]; ///< Shuffle by field and part of the headers.
+
+    /**
+     * Constructor, builds the shuffles.
+     */
+    constexpr shuffle_table() :
+        mask{}
+    {
+        for(size_t field = 0; field < 3; ++field){
+            for(size_t part = 0; part < 3; ++part){
+                for(size_t k = 0; k < 16; ++k){
+                    size_t hi = (6 * (k / 2)) + (2 * field) + ((k % 2 == 0) ? 1 : 0);
+                    int8_t index = (hi / 16 == part) ? static_cast<int8_t>(hi % 16) : -1;
+                    mask[field][part][k] = index;
+                    mask[field][part][k + 16] = index;
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Shuffles of the x86 kernels.
+ */
+static constexpr shuffle_table SHUFFLES{};
+
+__attribute__((target("ssse3")))
+static size_t decode_ssse3(const primary_header* headers, size_t i, size_t count, const header_fields& fields, uint16_t limit)
+{
+    if(count - i < 8){
+        return decode_scalar(headers, i, count, fields, limit);
+    }
+
+    __m128i masks[3][3];
+    for(size_t f = 0; f < 3; ++f){
+        for(size_t p = 0; p < 3; ++p){
+            masks[f][p] = _mm_load_si128(reinterpret_cast<const __m128i*>(SHUFFLES.mask[f][p]));
+        }
+    }
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one16 = _mm_set1_epi16(1);
+    const __m128i one32 = _mm_set1_epi32(1);
+    const __m128i maximum = _mm_set1_epi16(static_cast<int16_t>(limit));
+
+    size_t end = count;
+    while(i < end){
+        // The last headers are decoded in a block overlapping the previous
+        // one, headers decoded twice are valid and decode the same
+        if(i + 8 > end){
+            i = end - 8;
+        }
+
+        // Eight headers are held in three registers
+        const __m128i* src = reinterpret_cast<const __m128i*>(&headers[i]);
+        __m128i part[3] = {_mm_loadu_si128(src), _mm_loadu_si128(src + 1), _mm_loadu_si128(src + 2)};
+        __m128i field[3];
+        for(size_t f = 0; f < 3; ++f){
+            field[f] = _mm_or_si128(_mm_or_si128(
+                    _mm_shuffle_epi8(part[0], masks[f][0]),
+                    _mm_shuffle_epi8(part[1], masks[f][1])),
+                    _mm_shuffle_epi8(part[2], masks[f][2]));
+        }
+        __m128i ident = field[0];
+        __m128i sequence = field[1];
+        __m128i length = field[2];
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&fields.apid[i]), _mm_and_si128(ident, _mm_set1_epi16(PACKET_APID_MASK)));
+        __m128i type = _mm_and_si128(_mm_srli_epi16(ident, PACKET_TYPE_SHIFT), one16);
+        __m128i secondary = _mm_and_si128(_mm_srli_epi16(ident, PACKET_SEC_HDR_SHIFT), one16);
+        __m128i flags = _mm_srli_epi16(sequence, SEQUENCE_FLAGS_SHIFT);
+        __m128i bytes = _mm_packus_epi16(type, secondary);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&fields.type[i]), bytes);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&fields.secondary[i]), _mm_srli_si128(bytes, 8));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(&fields.flags[i]), _mm_packus_epi16(flags, flags));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&fields.count[i]), _mm_and_si128(sequence, _mm_set1_epi16(SEQUENCE_COUNT_MASK)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&fields.length[i]), _mm_add_epi32(_mm_unpacklo_epi16(length, zero), one32));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&fields.length[i + 4]), _mm_add_epi32(_mm_unpackhi_epi16(length, zero), one32));
+
+        // Check the version number and the data length of each header
+        __m128i valid = _mm_and_si128(
+                _mm_cmpeq_epi16(_mm_srli_epi16(ident, PACKET_VERSION_SHIFT), _mm_set1_epi16(PACKET_VERSION_1)),
+                _mm_cmpeq_epi16(_mm_subs_epu16(length, maximum), zero));
+        unsigned int mask = _mm_movemask_epi8(valid);
+        if(mask != 0xFFFF){
+            return i + (__builtin_ctz(~mask) / 2);
+        }
+        i += 8;
+    }
+    return end;
+}
+
+__attribute__((target("avx2")))
+static size_t decode_avx2(const primary_header* headers, size_t i, size_t count, const header_fields& fields, uint16_t limit)
+{
+    if(count - i < 16){
+        return decode_scalar(headers, i, count, fields, limit);
+    }
+
+    // Each 128-bit lane decodes eight headers using the same shuffles
+    __m256i masks[3][3];
+    for(size_t f = 0; f < 3; ++f){
+        for(size_t p = 0; p < 3; ++p){
+            masks[f][p] = _mm256_load_si256(reinterpret_cast<const __m256i*>(SHUFFLES.mask[f][p]));
+        }
+    }
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one16 = _mm256_set1_epi16(1);
+    const __m256i one32 = _mm256_set1_epi32(1);
+    const __m256i maximum = _mm256_set1_epi16(static_cast<int16_t>(limit));
+
+    size_t end = count;
+    while(i < end){
+        // The last headers are decoded in a block overlapping the previous
+        // one, headers decoded twice are valid and decode the same
+        if(i + 16 > end){
+            i = end - 16;
+        }
+
+        const __m128i* src = reinterpret_cast<const __m128i*>(&headers[i]);
+        __m256i part[3];
+        for(size_t p = 0; p < 3; ++p){
+            part[p] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(src + p)), _mm_loadu_si128(src + p + 3), 1);
+        }
+        __m256i field[3];
+        for(size_t f = 0; f < 3; ++f){
+            field[f] = _mm256_or_si256(_mm256_or_si256(
+                    _mm256_shuffle_epi8(part[0], masks[f][0]),
+                    _mm256_shuffle_epi8(part[1], masks[f][1])),
+                    _mm256_shuffle_epi8(part[2], masks[f][2]));
+        }
+        __m256i ident = field[0];
+        __m256i sequence = field[1];
+        __m256i length = field[2];
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&fields.apid[i]), _mm256_and_si256(ident, _mm256_set1_epi16(PACKET_APID_MASK)));
+        __m256i type = _mm256_and_si256(_mm256_srli_epi16(ident, PACKET_TYPE_SHIFT), one16);
+        __m256i secondary = _mm256_and_si256(_mm256_srli_epi16(ident, PACKET_SEC_HDR_SHIFT), one16);
+        __m256i flags = _mm256_srli_epi16(sequence, SEQUENCE_FLAGS_SHIFT);
+        // Packing interleaves the lanes, restore the header order
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(type, secondary), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&fields.type[i]), _mm256_castsi256_si128(bytes));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&fields.secondary[i]), _mm256_extracti128_si256(bytes, 1));
+        bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(flags, flags), 0xD8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&fields.flags[i]), _mm256_castsi256_si128(bytes));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&fields.count[i]), _mm256_and_si256(sequence, _mm256_set1_epi16(SEQUENCE_COUNT_MASK)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&fields.length[i]), _mm256_add_epi32(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(length)), one32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(&fields.length[i + 8]), _mm256_add_epi32(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(length, 1)), one32));
+
+        __m256i valid = _mm256_and_si256(
+                _mm256_cmpeq_epi16(_mm256_srli_epi16(ident, PACKET_VERSION_SHIFT), _mm256_set1_epi16(PACKET_VERSION_1)),
+                _mm256_cmpeq_epi16(_mm256_subs_epu16(length, maximum), zero));
+        unsigned int mask = _mm256_movemask_epi8(valid);
+        if(mask != 0xFFFFFFFF){
+            return i + (__builtin_ctz(~mask) / 2);
+        }
+        i += 16;
+    }
+    return end;
+}
+
+#endif // CCSDS_DECODE_X86
+
+#ifdef CCSDS_DECODE_NEON
+
+static size_t decode_neon(const primary_header* headers, size_t i, size_t count, const header_fields& fields, uint16_t limit)
+{
+    const uint16x8_t one = vdupq_n_u16(1);
+    const uint16x8_t maximum = vdupq_n_u16(limit);
+
+    for(; i + 8 <= count; i += 8){
+        // De-interleave the three fields of eight headers and swap to host byte order
+        uint16x8x3_t field = vld3q_u16(reinterpret_cast<const uint16_t*>(&headers[i]));
+        uint16x8_t ident = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(field.val[0])));
+        uint16x8_t sequence = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(field.val[1])));
+        uint16x8_t length = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(field.val[2])));
+
+        vst1q_u16(&fields.apid[i], vandq_u16(ident, vdupq_n_u16(PACKET_APID_MASK)));
+        vst1_u8(&fields.type[i], vmovn_u16(vandq_u16(vshrq_n_u16(ident, PACKET_TYPE_SHIFT), one)));
+        vst1_u8(&fields.secondary[i], vmovn_u16(vandq_u16(vshrq_n_u16(ident, PACKET_SEC_HDR_SHIFT), one)));
+        vst1_u8(&fields.flags[i], vmovn_u16(vshrq_n_u16(sequence, SEQUENCE_FLAGS_SHIFT)));
+        vst1q_u16(&fields.count[i], vandq_u16(sequence, vdupq_n_u16(SEQUENCE_COUNT_MASK)));
+        vst1q_u32(&fields.length[i], vaddw_u16(vdupq_n_u32(1), vget_low_u16(length)));
+        vst1q_u32(&fields.length[i + 4], vaddw_u16(vdupq_n_u32(1), vget_high_u16(length)));
+
+        uint16x8_t valid = vandq_u16(
+                vceqq_u16(vshrq_n_u16(ident, PACKET_VERSION_SHIFT), vdupq_n_u16(PACKET_VERSION_1)),
+                vcleq_u16(length, maximum));
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vmovn_u16(valid)), 0);
+        if(mask != UINT64_MAX){
+            return i + (__builtin_ctzll(~mask) / 8);
+        }
+    }
+    return decode_scalar(headers, i, count, fields, limit);
+}
+
+#endif // CCSDS_DECODE_NEON
+
+/**
+ * Select the fastest decoding kernel supported by the processor.
+ * @return Decoding kernel.
+ */
+static decoder select_decoder()
+{
+#if defined(CCSDS_DECODE_X86)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return &decode_avx2;
+    }else if(__builtin_cpu_supports("ssse3")){
+        return &decode_ssse3;
+    }
+#elif defined(CCSDS_DECODE_NEON)
+    return &decode_neon;
+#endif
+    return &decode_scalar;
+}
+
+size_t decode_headers(const primary_header headers[], size_t count, const header_fields& fields, size_t max_length)
+{
+    static const decoder kernel = select_decoder();
+
+    if(max_length == 0){
+        return 0;
+    }else if(max_length > MAX_DATA_LENGTH){
+        max_length = MAX_DATA_LENGTH;
+    }
+    uint16_t limit = static_cast<uint16_t>(max_length - 1);
+    // Below VECTOR_THRESHOLD headers the vector kernels are no faster, see
+    // the header_decode and header_decode_scalar benchmarks
+    if(count < VECTOR_THRESHOLD){
+        return decode_scalar(headers, 0, count, fields, limit);
+    }
+    return kernel(headers, 0, count, fields, limit);
+}
+
+size_t decode_stream(const void* buf, size_t len, size_t offsets[], size_t count, const header_fields& fields, size_t max_length)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(buf);
+
+    // Headers are gathered into blocks large enough for the setup of the
+    // vector kernels to be amortized, the block stays within the L1 cache
+    constexpr size_t BLOCK = 256;
+    primary_header block[BLOCK];
+
+    size_t offset = 0;
+    size_t decoded = 0;
+    while(decoded < count){
+        size_t n = 0;
+        while((n < BLOCK) && (decoded + n < count) && (len - offset >= sizeof(primary_header))){
+            std::memcpy(&block[n], &bytes[offset], sizeof(primary_header));
+            size_t size = sizeof(primary_header) + ccsds::ntohs(block[n].data_length) + 1;
+            if(len - offset < size){
+                break;
+            }
+            offsets[decoded + n] = offset;
+            offset += size;
+            ++n;
+        }
+        if(n == 0){
+            break;
+        }
+
+        header_fields part = {
+            &fields.apid[decoded],
+            &fields.type[decoded],
+            &fields.secondary[decoded],
+            &fields.flags[decoded],
+            &fields.count[decoded],
+            &fields.length[decoded],
+        };
+        size_t valid = decode_headers(block, n, part, max_length);
+        decoded += valid;
+        if(valid < n){
+            break;
+        }
+    }
+    return decoded;
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
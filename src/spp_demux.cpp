@@ -0,0 +1,86 @@
+/**
+ * @file spp_demux.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_demux.h"
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+demux_service::demux_service() :
+    callback(nullptr),
+    view_callback(nullptr)
+{
+    services.fill(nullptr);
+}
+
+ccsds::error demux_service::attach(apid id, ccsds::spp::octet_service* service)
+{
+    if((id > APID_MAX) || ((service != nullptr) && (service->id() != id))){
+        return error(error::code::INVALID_ARG);
+    }
+
+    services[id] = service;
+    return error();
+}
+
+void demux_service::detach(apid id)
+{
+    if(id <= APID_MAX){
+        services[id] = nullptr;
+    }
+}
+
+void demux_service::set_indication(indication func)
+{
+    callback = func;
+}
+
+void demux_service::reception(std::unique_ptr<ccsds::spp::pdu> pdu)
+{
+    const primary_header* header = &(*pdu)->header;
+
+    // Extract APID, the idle APID entry is never registered
+    apid id = static_cast<apid>(ccsds::ntohs(header->identification) & PACKET_APID_MASK);
+    ccsds::spp::octet_service* service = services[id];
+    if(service != nullptr){
+        service->reception(std::move(pdu));
+    }else if(callback != nullptr){
+        callback(std::move(pdu), id);
+    }
+}
+
+void demux_service::set_view_indication(view_indication func)
+{
+    view_callback = func;
+}
+
+void demux_service::reception(const packet_view& packet, std::shared_ptr<const void> owner)
+{
+    if(packet.buffer_size() < sizeof(primary_header)){
+        return;
+    }
+
+    apid id = packet.id();
+    ccsds::spp::octet_service* service = services[id];
+    if(service != nullptr){
+        service->reception(packet, std::move(owner));
+    }else if(view_callback != nullptr){
+        view_callback(packet, id);
+    }
+}
+
+ccsds::error demux_service::transfer(std::unique_ptr<const ccsds::base_du> sdu)
+{
+    (void)sdu;
+    return error(error::code::NO_SUPPORT);
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
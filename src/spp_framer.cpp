@@ -0,0 +1,108 @@
+/**
+ * @file spp_framer.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_framer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+packet_framer::packet_framer() :
+    callback(nullptr),
+    partial(std::make_unique<uint8_t[]>(MAX_PACKET_SIZE)),
+    held(0)
+{
+
+}
+
+void packet_framer::set_indication(indication func)
+{
+    callback = func;
+}
+
+size_t packet_framer::packet_size(const uint8_t* header)
+{
+    // The data length field is big endian and holds the data length - 1
+    size_t data_length = (static_cast<size_t>(header[4]) << 8) | header[5];
+    return sizeof(primary_header) + data_length + 1;
+}
+
+void packet_framer::reception(void* buf, size_t len)
+{
+    uint8_t* bytes = static_cast<uint8_t*>(buf);
+
+    // Complete a packet left over from the previous buffer
+    if(held > 0){
+        size_t needed = sizeof(primary_header);
+        if(held >= sizeof(primary_header)){
+            needed = packet_size(partial.get());
+        }
+        size_t copy = std::min(needed - held, len);
+        std::memcpy(&partial[held], bytes, copy);
+        held += copy;
+        bytes += copy;
+        len -= copy;
+
+        if((held == sizeof(primary_header)) && (len > 0)){
+            // Header is complete, continue with the data field
+            needed = packet_size(partial.get());
+            copy = std::min(needed - held, len);
+            std::memcpy(&partial[held], bytes, copy);
+            held += copy;
+            bytes += copy;
+            len -= copy;
+        }
+
+        if((held < sizeof(primary_header)) || (held < packet_size(partial.get()))){
+            return;
+        }
+
+        ccsds::buffered_du packet(partial.get(), held);
+        held = 0;
+        if(callback != nullptr){
+            callback(packet);
+        }
+    }
+
+    // Pass complete packets on directly from the buffer
+    while(len >= sizeof(primary_header)){
+        size_t size = packet_size(bytes);
+        if(size > len){
+            break;
+        }
+
+        if(callback != nullptr){
+            ccsds::buffered_du packet(bytes, size);
+            callback(packet);
+        }
+        bytes += size;
+        len -= size;
+    }
+
+    // Hold on to the start of a packet that continues in the next buffer
+    if(len > 0){
+        std::memcpy(partial.get(), bytes, len);
+        held = len;
+    }
+}
+
+void packet_framer::reset()
+{
+    held = 0;
+}
+
+size_t packet_framer::pending() const
+{
+    return held;
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
@@ -0,0 +1,86 @@
+/**
+ * @file spp_idle.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_idle.h"
+#include <array>
+#include <cstring>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+idle_service::idle_service(ccsds::base_service* subnetwork, uint8_t pattern) :
+    subnetwork(subnetwork),
+    idle_data(nullptr),
+    count(0)
+{
+    // Idle packets may be released by other threads, such as a queue drain
+    auto data = std::make_unique<ccsds::du<std::array<uint8_t, MAX_DATA_LENGTH>>>();
+    (*data)->fill(pattern);
+    idle_data = shared_payload::create(std::move(data), true);
+}
+
+idle_service::~idle_service()
+{
+    idle_data->release();
+}
+
+std::unique_ptr<const ccsds::spp::pdu> idle_service::packet(size_t size)
+{
+    if((size < MIN_PACKET_SIZE) || (size > MAX_PACKET_SIZE)){
+        return nullptr;
+    }
+
+    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+    encode((*pdu)->header, size);
+    pdu->append(std::make_unique<ccsds::shared_du>(*idle_data, data(), size - sizeof(primary_header)));
+    return pdu;
+}
+
+ccsds::error idle_service::request(size_t size)
+{
+    std::unique_ptr<const ccsds::spp::pdu> pdu = packet(size);
+    if(pdu == nullptr){
+        return error(error::code::INVALID_ARG);
+    }else if(subnetwork == nullptr){
+        return error(error::code::NO_NETWORK);
+    }
+    return subnetwork->transfer(std::move(pdu));
+}
+
+size_t idle_service::fill(void* buf, size_t len)
+{
+    uint8_t* p = static_cast<uint8_t*>(buf);
+    size_t remaining = len;
+    while(remaining >= MIN_PACKET_SIZE){
+        size_t size = (remaining < MAX_PACKET_SIZE) ? remaining : MAX_PACKET_SIZE;
+        if((remaining - size != 0) && (remaining - size < MIN_PACKET_SIZE)){
+            // Leave enough for a final packet
+            size = remaining - MIN_PACKET_SIZE;
+        }
+
+        primary_header header;
+        encode(header, size);
+        memcpy(p, &header, sizeof(header));
+        memcpy(p + sizeof(header), data(), size - sizeof(header));
+        p += size;
+        remaining -= size;
+    }
+    return len - remaining;
+}
+
+void idle_service::encode(primary_header& header, size_t size)
+{
+    header.identification = identification(APID_IDLE, TELEMETRY, false);
+    header.sequence_control = sequence_control(SEQUENCE_UNSEGMENTED, count++);
+    header.data_length = ccsds::htons(size - sizeof(primary_header) - 1);
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
@@ -0,0 +1,205 @@
+/**
+ * @file spp_index.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_index.h"
+#include <thread>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+/**
+ * Time of packets without a time.
+ */
+static constexpr uint64_t NO_TIME = UINT64_MAX;
+
+/**
+ * Run a function on several threads, including the calling thread.
+ * @tparam F Type of the function.
+ * @param threads Number of threads.
+ * @param func Function called with the index of each thread.
+ */
+template<typename F>
+static void parallel(size_t threads, const F& func)
+{
+    std::vector<std::thread> workers;
+    for(size_t t = 1; t < threads; ++t){
+        workers.emplace_back(func, t);
+    }
+    func(0);
+    for(auto& worker : workers){
+        worker.join();
+    }
+}
+
+archive_index::archive_index(time_source time) :
+    source(time),
+    base(nullptr),
+    length(0),
+    apids(PACKET_APID_MASK + 1)
+{
+
+}
+
+size_t archive_index::build(const archive_reader& reader, size_t threads)
+{
+    clear();
+    owner = reader.owner();
+    base = reader.data();
+    length = reader.length();
+    return index([&reader](size_t i){ return reader.offset(i); }, reader.size(), threads);
+}
+
+size_t archive_index::build(std::shared_ptr<const void> owner, const void* buf, size_t len, size_t threads)
+{
+    clear();
+    this->owner = std::move(owner);
+    base = static_cast<const uint8_t*>(buf);
+    length = len;
+
+    // Packet boundaries are only found by following the data lengths
+    std::vector<uint64_t> offsets;
+    size_t offset = 0;
+    while(len - offset >= sizeof(primary_header)){
+        size_t size = packet_view(base + offset, len - offset).size();
+        if(len - offset < size){
+            break;
+        }
+        offsets.push_back(offset);
+        offset += size;
+    }
+    return index([&offsets](size_t i){ return offsets[i]; }, offsets.size(), threads);
+}
+
+template<typename OFFSETS>
+size_t archive_index::index(const OFFSETS& offsets, size_t total, size_t threads)
+{
+    if(total == 0){
+        return 0;
+    }
+    if(threads == 0){
+        threads = 1;
+    }else if(threads > total){
+        threads = total;
+    }
+
+    // Each thread sorts a contiguous range of packets by APID
+    std::vector<std::vector<std::vector<entry>>> parts(threads);
+    parallel(threads, [&](size_t t){
+        std::vector<std::vector<entry>>& part = parts[t];
+        part.resize(PACKET_APID_MASK + 1);
+        size_t end = total * (t + 1) / threads;
+        for(size_t i = total * t / threads; i < end; ++i){
+            uint64_t offset = offsets(i);
+            packet_view packet(base + offset, length - offset);
+            uint64_t time;
+            if((source == nullptr) || !source(packet, time)){
+                time = NO_TIME;
+            }
+            part[packet.id()].push_back({offset, time});
+        }
+    });
+
+    // Each thread merges the ranges of some APIDs, in archive order
+    parallel(threads, [&](size_t t){
+        size_t end = apids.size() * (t + 1) / threads;
+        for(size_t id = apids.size() * t / threads; id < end; ++id){
+            series& s = apids[id];
+            size_t n = 0;
+            for(auto& part : parts){
+                n += part[id].size();
+            }
+            s.offsets.reserve(n);
+            s.checkpoints.reserve((n + INTERVAL - 1) / INTERVAL);
+
+            for(auto& part : parts){
+                for(const entry& e : part[id]){
+                    if(s.offsets.size() % INTERVAL == 0){
+                        s.checkpoints.push_back({NO_TIME, 0});
+                    }
+                    s.offsets.push_back(e.offset);
+                    if(e.time != NO_TIME){
+                        checkpoint& c = s.checkpoints.back();
+                        c.first = (e.time < c.first) ? e.time : c.first;
+                        c.last = (e.time > c.last) ? e.time : c.last;
+                    }
+                }
+                std::vector<entry>().swap(part[id]);
+            }
+        }
+    });
+    return total;
+}
+
+void archive_index::clear()
+{
+    owner.reset();
+    base = nullptr;
+    length = 0;
+    for(auto& s : apids){
+        std::vector<uint64_t>().swap(s.offsets);
+        std::vector<checkpoint>().swap(s.checkpoints);
+    }
+}
+
+size_t archive_index::count(apid id) const
+{
+    if(id > APID_IDLE){
+        return 0;
+    }
+    return apids[id].offsets.size();
+}
+
+size_t archive_index::query(apid id, std::vector<std::unique_ptr<const ccsds::base_du>>& packets) const
+{
+    if(id > APID_IDLE){
+        return 0;
+    }
+    const series& s = apids[id];
+    packets.reserve(packets.size() + s.offsets.size());
+    for(uint64_t offset : s.offsets){
+        packets.push_back(view(offset));
+    }
+    return s.offsets.size();
+}
+
+size_t archive_index::query(apid id, uint64_t begin, uint64_t end, std::vector<std::unique_ptr<const ccsds::base_du>>& packets) const
+{
+    if((id > APID_IDLE) || (source == nullptr)){
+        return 0;
+    }
+
+    const series& s = apids[id];
+    size_t found = 0;
+    for(size_t c = 0; c < s.checkpoints.size(); ++c){
+        // Only packets of overlapping checkpoints are decoded
+        if((s.checkpoints[c].first >= end) || (s.checkpoints[c].last < begin)){
+            continue;
+        }
+        size_t last = ((c + 1) * INTERVAL < s.offsets.size()) ? (c + 1) * INTERVAL : s.offsets.size();
+        for(size_t i = c * INTERVAL; i < last; ++i){
+            uint64_t offset = s.offsets[i];
+            uint64_t time;
+            if(source(packet_view(base + offset, length - offset), time) && (time >= begin) && (time < end)){
+                packets.push_back(view(offset));
+                ++found;
+            }
+        }
+    }
+    return found;
+}
+
+std::unique_ptr<const ccsds::base_du> archive_index::view(uint64_t offset) const
+{
+    return std::make_unique<ccsds::view_du>(owner, base + offset,
+            packet_view(base + offset, length - offset).size());
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
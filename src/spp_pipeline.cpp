@@ -0,0 +1,109 @@
+/**
+ * @file spp_pipeline.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_pipeline.h"
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+receive_pipeline::receive_pipeline(size_t shards) :
+    running(false)
+{
+    if(shards == 0){
+        shards = 1;
+    }
+    for(size_t i = 0; i < shards; ++i){
+        partitions.push_back(std::make_unique<shard>());
+    }
+}
+
+receive_pipeline::~receive_pipeline()
+{
+    stop();
+}
+
+size_t receive_pipeline::shards() const
+{
+    return partitions.size();
+}
+
+size_t receive_pipeline::shard_of(apid id) const
+{
+    return (id & PACKET_APID_MASK) % partitions.size();
+}
+
+demux_service& receive_pipeline::demux(size_t i)
+{
+    return partitions[i]->demux;
+}
+
+ccsds::error receive_pipeline::attach(apid id, ccsds::spp::octet_service* service)
+{
+    return partitions[shard_of(id)]->demux.attach(id, service);
+}
+
+ccsds::error receive_pipeline::reception(std::unique_ptr<ccsds::spp::pdu> pdu)
+{
+    // Only the APID is decoded here, the shard handles the rest of the header
+    apid id = static_cast<apid>(ccsds::ntohs((*pdu)->header.identification) & PACKET_APID_MASK);
+    shard& s = *partitions[shard_of(id)];
+    if(!s.ring.push(pdu)){
+        return error(error::code::NO_SPACE);
+    }
+    s.waiter.notify();
+    return error();
+}
+
+size_t receive_pipeline::process(size_t i, size_t max)
+{
+    shard& s = *partitions[i];
+    size_t count = 0;
+    std::unique_ptr<ccsds::spp::pdu> pdu;
+    while((count < max) && s.ring.pop(pdu)){
+        s.demux.reception(std::move(pdu));
+        ++count;
+    }
+    return count;
+}
+
+void receive_pipeline::start()
+{
+    if(!running.exchange(true)){
+        for(size_t i = 0; i < partitions.size(); ++i){
+            partitions[i]->worker = std::thread([this, i]{
+                shard& s = *partitions[i];
+                auto ready = [this, &s]{
+                    return (s.ring.size() > 0) || !running.load(std::memory_order_acquire);
+                };
+                while(running.load(std::memory_order_acquire)){
+                    if(process(i) == 0){
+                        s.waiter.idle(ready);
+                    }else{
+                        s.waiter.busy();
+                    }
+                }
+                process(i);
+            });
+        }
+    }
+}
+
+void receive_pipeline::stop()
+{
+    if(running.exchange(false)){
+        for(auto& s : partitions){
+            s->waiter.interrupt();
+            s->worker.join();
+        }
+    }
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
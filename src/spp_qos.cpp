@@ -0,0 +1,139 @@
+/**
+ * @file spp_qos.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_qos.h"
+#include "ccsds/trace.h"
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+priority_scheduler::priority_scheduler(policy mode, const std::array<unsigned int, LEVELS>& weights, const std::array<size_t, LEVELS>& depths) :
+    weights(weights),
+    depths(depths),
+    mode(mode),
+    current(0),
+    quantum(0),
+    draining(false),
+    failures(0)
+{
+    for(size_t i = 0; i < LEVELS; ++i){
+        // Every class is drained in each round
+        if(this->weights[i] == 0){
+            this->weights[i] = 1;
+        }
+        if(this->depths[i] > DEPTH){
+            this->depths[i] = DEPTH;
+        }
+    }
+    quantum = this->weights[0];
+}
+
+ccsds::error priority_scheduler::enqueue(std::unique_ptr<const ccsds::base_du> pdu, int qos, ccsds::base_service::completion done)
+{
+    if((qos < 0) || (static_cast<size_t>(qos) >= LEVELS)){
+        return error(error::code::INVALID_ARG);
+    }
+
+    // Concurrent producers may briefly exceed the depth, but never DEPTH
+    queued_du entry = {std::move(pdu), done};
+    if((queues[qos].size() >= depths[qos]) || !queues[qos].push(entry)){
+        return error(error::code::NO_SPACE);
+    }
+    return error();
+}
+
+size_t priority_scheduler::drain(ccsds::base_service* subnetwork)
+{
+    size_t count = 0;
+    do{
+        bool expected = false;
+        if(!draining.compare_exchange_strong(expected, true, std::memory_order_acquire)){
+            break;
+        }
+
+        queued_du entry;
+        while((subnetwork->credit() > 0) && next(entry)){
+            ccsds::error e;
+            {
+                CCSDS_TRACE_SCOPE(SUBNETWORK, *entry.du);
+                e = subnetwork->transfer(std::move(entry.du));
+            }
+            if(e){
+                failures.fetch_add(1, std::memory_order_relaxed);
+            }
+            if(entry.done){
+                entry.done(e);
+            }
+            ++count;
+        }
+        draining.store(false, std::memory_order_release);
+
+        // Packets queued while finishing would otherwise wait for the next drain
+    }while(pending() && (subnetwork->credit() > 0));
+    return count;
+}
+
+size_t priority_scheduler::size(int qos) const
+{
+    if((qos < 0) || (static_cast<size_t>(qos) >= LEVELS)){
+        return 0;
+    }
+    return queues[qos].size();
+}
+
+size_t priority_scheduler::credit(int qos) const
+{
+    if((qos < 0) || (static_cast<size_t>(qos) >= LEVELS)){
+        return 0;
+    }
+    size_t used = queues[qos].size();
+    return (used < depths[qos]) ? (depths[qos] - used) : 0;
+}
+
+size_t priority_scheduler::errors() const
+{
+    return failures.load(std::memory_order_relaxed);
+}
+
+bool priority_scheduler::next(queued_du& entry)
+{
+    if(mode == STRICT){
+        for(auto& queue : queues){
+            if(queue.pop(entry)){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Weighted round robin, skipping empty classes
+    for(size_t i = 0; i <= LEVELS; ++i){
+        if((quantum > 0) && queues[current].pop(entry)){
+            --quantum;
+            return true;
+        }
+        current = (current + 1) % LEVELS;
+        quantum = weights[current];
+    }
+    return false;
+}
+
+bool priority_scheduler::pending() const
+{
+    for(const auto& queue : queues){
+        if(queue.size() > 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
@@ -0,0 +1,163 @@
+/**
+ * @file spp_segment.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp.h"
+#include <algorithm>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+reassembly::reassembly(size_t max_length, std::chrono::steady_clock::duration timeout) :
+    limit(max_length),
+    timeout(timeout),
+    lost(false)
+{
+
+}
+
+void reassembly::configure(size_t max_length, std::chrono::steady_clock::duration timeout)
+{
+    limit = max_length;
+    this->timeout = timeout;
+}
+
+std::unique_ptr<const ccsds::base_du> reassembly::reception(std::unique_ptr<const ccsds::base_du> data, uint16_t flags, bool& loss)
+{
+    lost |= loss;
+
+    // Incomplete user data can not be completed after a lost packet
+    if(!segments.empty()){
+        if(loss || (flags == SEQUENCE_FIRST) || (flags == SEQUENCE_UNSEGMENTED)){
+            discard();
+        }else{
+            expire();
+        }
+    }
+
+    if(flags == SEQUENCE_UNSEGMENTED){
+        loss = lost;
+        lost = false;
+        return data;
+    }else if(flags == SEQUENCE_FIRST){
+        start = std::chrono::steady_clock::now();
+    }else if(segments.empty()){
+        // The first segment was lost
+        lost = true;
+        return nullptr;
+    }
+
+    size_t len = (data != nullptr) ? data->totalSize() : 0;
+    if(segments.size() + len > limit){
+        discard();
+        return nullptr;
+    }
+
+    // Segments from the subnetwork are relinked in place, only each
+    // segment's own chain is walked
+    segments.append(std::move(data));
+    if(flags != SEQUENCE_LAST){
+        return nullptr;
+    }
+
+    loss = lost;
+    lost = false;
+    return segments.take();
+}
+
+bool reassembly::expire()
+{
+    if(!segments.empty() && (std::chrono::steady_clock::now() - start > timeout)){
+        discard();
+        return true;
+    }
+    return false;
+}
+
+bool reassembly::pending() const
+{
+    return !segments.empty();
+}
+
+void reassembly::discard()
+{
+    segments.clear();
+    lost = true;
+}
+
+ccsds::error octet_service::request_segmented(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, packet_type type, size_t max_length)
+{
+    if((max_length == 0) || (max_length > MAX_DATA_LENGTH)){
+        return error(error::code::INVALID_ARG);
+    }
+    if(error_control){
+        // Leave room for the packet error control field in each packet
+        if(max_length <= sizeof(packet_error_control)){
+            return error(error::code::INVALID_ARG);
+        }
+        max_length -= sizeof(packet_error_control);
+    }
+
+    size_t total = sdu->totalSize();
+    if(total <= max_length){
+        return request(std::move(sdu), secondary, type);
+    }
+
+    // The user data lives until the last packet viewing it is released
+    std::shared_ptr<const ccsds::base_du> owner(std::move(sdu));
+    const ccsds::base_du* node = owner.get();
+    size_t offset = 0;
+
+    std::vector<ccsds::segment> pieces;
+    uint16_t flags = SEQUENCE_FIRST;
+    size_t sent = 0;
+    while(sent < total){
+        // Find the parts of the user data in this segment
+        size_t len = std::min(max_length, total - sent);
+        size_t needed = len;
+        pieces.clear();
+        while(needed > 0){
+            size_t available = node->size() - offset;
+            if(available == 0){
+                node = &node->next();
+                offset = 0;
+                continue;
+            }
+            size_t take = std::min(available, needed);
+            pieces.push_back({static_cast<const uint8_t*>(node->get()) + offset, take});
+            offset += take;
+            needed -= take;
+        }
+
+        // Build the views back to front so the chain sizes are cached correctly
+        std::unique_ptr<const ccsds::base_du> data;
+        for(size_t i = pieces.size(); i-- > 0;){
+            std::unique_ptr<ccsds::view_du> view = std::make_unique<ccsds::view_du>(owner, pieces[i].base, pieces[i].len);
+            view->append(std::move(data));
+            data = std::move(view);
+        }
+
+        sent += len;
+        if(sent == total){
+            flags = SEQUENCE_LAST;
+        }
+        ccsds::error e = service.transfer(assemble(std::move(data),
+                identification(service_id, type, secondary && (flags == SEQUENCE_FIRST)),
+                sequence_control(flags, next_count())));
+        if(e){
+            return e;
+        }
+        flags = SEQUENCE_CONTINUATION;
+    }
+
+    return error();
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
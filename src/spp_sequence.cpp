@@ -0,0 +1,101 @@
+/**
+ * @file spp_sequence.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp.h"
+#include <algorithm>
+#include <bitset>
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+/**
+ * Get a mask of the low bits of a window.
+ * @param bits Number of bits, at most 64.
+ * @return Mask with the low bits set.
+ */
+static uint64_t low_bits(unsigned bits)
+{
+    return (bits >= 64) ? ~uint64_t(0) : ((uint64_t(1) << bits) - 1);
+}
+
+/**
+ * Count the packets marked missing in a window.
+ * @param bits Bitmap of missing packets.
+ * @return Number of missing packets.
+ */
+static uint16_t popcount(uint64_t bits)
+{
+    return static_cast<uint16_t>(std::bitset<64>(bits).count());
+}
+
+sequence_tracker::sequence_tracker() :
+    missing(0),
+    latest(0),
+    started(false)
+{
+
+}
+
+void sequence_tracker::reset()
+{
+    missing = 0;
+    latest = 0;
+    started = false;
+}
+
+sequence_tracker::status sequence_tracker::update(uint16_t count, uint8_t tolerance)
+{
+    count &= SEQUENCE_COUNT_MASK;
+    if(!started){
+        started = true;
+        latest = count;
+        missing = 0;
+        return {0, false};
+    }
+
+    // Bit 0 of the window is the latest packet, bit n the packet n behind it
+    unsigned width = std::min(tolerance, MAX_TOLERANCE);
+    uint64_t window = low_bits(width + 1);
+    uint16_t ahead = (count - latest) & SEQUENCE_COUNT_MASK;
+    if(ahead == 0){
+        // Duplicate of the latest packet
+        return {0, true};
+    }
+
+    if(ahead <= (SEQUENCE_COUNT_MASK >> 1)){
+        // Packets moved out of the window are lost, as is any gap beyond it
+        unsigned evict = (ahead <= width) ? width + 1 - ahead : 0;
+        uint16_t lost = popcount(missing & window & ~low_bits(evict));
+        if(ahead > width + 1){
+            lost += ahead - 1 - width;
+        }
+
+        uint64_t gap = low_bits(std::min<unsigned>(ahead, width + 1)) & ~uint64_t(1);
+        missing = (((ahead <= width) ? (missing << ahead) : 0) | gap) & window;
+        latest = count;
+        return {lost, false};
+    }
+
+    uint16_t behind = (latest - count) & SEQUENCE_COUNT_MASK;
+    if(behind <= width){
+        // Late packet filling its place in the window
+        missing &= ~(uint64_t(1) << behind);
+        return {0, true};
+    }
+
+    // Too far behind to be reordered, the sequence restarted
+    uint16_t lost = popcount(missing & window);
+    latest = count;
+    missing = 0;
+    return {lost, true};
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
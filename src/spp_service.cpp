@@ -4,6 +4,12 @@
  */
 
 #include "ccsds/spp.h"
+#include "ccsds/crc.h"
+#include "ccsds/spp_qos.h"
+#include "ccsds/spp_stats.h"
+#include "ccsds/trace.h"
+#include <algorithm>
+#include <cstring>
 
 namespace ccsds {
 namespace spp {
@@ -15,173 +21,511 @@ namespace spp {
 packet_service::packet_service(ccsds::base_service* subnetwork) :
     subnetwork(subnetwork),
     callback(nullptr),
-    last_count(-1)
+    view_callback(nullptr),
+    tolerance(0),
+    stats(nullptr),
+    scheduler(nullptr),
+    service_qos(0)
 {
 
 }
 
-octet_service::octet_service(apid id, ccsds::base_service* subnetwork) :
+octet_service::octet_service(apid id, ccsds::base_service* subnetwork, bool concurrent) :
     service(subnetwork),
     callback(nullptr),
-    id(id),
+    service_id(id),
+    concurrent(concurrent),
     packet_count(0),
-    last_count(-1)
+    tolerance(0),
+    stats(nullptr),
+    error_control(false)
 {
 
 }
 
 ccsds::error packet_service::request(std::unique_ptr<const ccsds::spp::pdu> pdu, int qos)
 {
-    (void)qos;
+    if(scheduler == nullptr){
+        return transfer(std::move(pdu));
+    }
+    return schedule(std::move(pdu), qos, nullptr);
+}
+
+ccsds::error packet_service::schedule(std::unique_ptr<const ccsds::base_du> pdu, int qos, completion done)
+{
+    if(subnetwork == nullptr){
+        return error(error::code::NO_NETWORK);
+    }
 
-    return transfer(std::move(pdu));
+    ccsds::error e = scheduler->enqueue(std::move(pdu), qos, done);
+    if(e){
+        return e;
+    }
+    scheduler->drain(subnetwork);
+    return error();
+}
+
+void packet_service::set_scheduler(priority_scheduler* sched, int qos)
+{
+    scheduler = sched;
+    service_qos = qos;
+}
+
+size_t packet_service::process()
+{
+    if((scheduler == nullptr) || (subnetwork == nullptr)){
+        return 0;
+    }
+    return scheduler->drain(subnetwork);
+}
+
+apid octet_service::id() const
+{
+    return service_id;
 }
 
 ccsds::error octet_service::request(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, packet_type type)
 {
+    CCSDS_TRACE_SCOPE(OCTET_REQUEST, service_id, ccsds::trace::NO_COUNT, sdu->totalSize());
     auto pdu = assembly(std::move(sdu), secondary, type);
     return service.transfer(std::move(pdu));
 }
 
 ccsds::error octet_service::request(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, uint16_t name)
 {
+    CCSDS_TRACE_SCOPE(OCTET_REQUEST, service_id, name & SEQUENCE_COUNT_MASK, sdu->totalSize());
     auto pdu = assembly(std::move(sdu), secondary, name);
     return service.transfer(std::move(pdu));
 }
 
-/**
- * Primary header identification assembly helpers.
- */
-enum {
-    PACKET_VERSION_1     = 0b000, ///< Packet version number.
-    PACKET_VERSION_SHIFT = 13,    ///< Packet version shift in identification field.
-    PACKET_TYPE_MASK     = 0x1,   ///< Packet type mask in identification field.
-    PACKET_TYPE_SHIFT    = 12,    ///< Packet type shift in identification field.
-    PACKET_SEC_HDR_SHIFT = 11,    ///< Packet secondary header flag shift in identification field.
-    PACKET_APID_MASK     = 0x7FF, ///< APID mask in identification field.
-};
+ccsds::error octet_service::request(const void* buf, size_t len, bool secondary, packet_type type)
+{
+    CCSDS_TRACE_SCOPE(OCTET_REQUEST, service_id, ccsds::trace::NO_COUNT, len);
+    size_t trailer = error_control ? sizeof(packet_error_control) : 0;
+    if((len == 0) || (len + trailer > MAX_DATA_LENGTH)){
+        return error(error::code::INVALID_ARG);
+    }
 
-/**
- * Primary header sequence assembly helpers.
- */
-enum {
-    SEQUENCE_UNSEGMENTED = 0b11,   ///< Unsegmented user data flag.
-    SEQUENCE_FLAGS_SHIFT = 14,     ///< Sequence flags shift in sequence_control field.
-    SEQUENCE_COUNT_MASK  = 0x3FFF, ///< Sequence count mask in sequence_control field.
-};
+    auto packet = std::make_unique<packet_du>(sizeof(primary_header) + len + trailer);
+    uint8_t* p = packet->data();
+    primary_header header;
+    header.identification = identification(service_id, type, secondary);
+    header.sequence_control = sequence_control(SEQUENCE_UNSEGMENTED, next_count());
+    header.data_length = ccsds::htons(len + trailer - 1);
+    memcpy(p, &header, sizeof(header));
+    memcpy(p + sizeof(header), buf, len);
+
+    if(error_control){
+        uint16_t crc = ccsds::htons(ccsds::crc16(p, sizeof(header) + len));
+        memcpy(p + sizeof(header) + len, &crc, sizeof(crc));
+    }
+    return service.transfer(std::move(packet));
+}
 
-std::unique_ptr<const ccsds::spp::pdu> octet_service::assembly(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, packet_type type)
+ccsds::error octet_service::request_batch(std::unique_ptr<const ccsds::base_du> sdus[], size_t count, bool secondary, packet_type type)
 {
-    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
-    primary_header* header = &(*pdu)->header;
+    uint16_t ident = identification(service_id, type, secondary);
+    uint16_t first = next_count(count);
 
-    header->identification = ccsds::htons(
-            (PACKET_VERSION_1 << PACKET_VERSION_SHIFT)         // packet version number
-            | ((type & PACKET_TYPE_MASK) << PACKET_TYPE_SHIFT) // packet type
-            | ((!!secondary) << PACKET_SEC_HDR_SHIFT)          // secondary header flag
-            | (id & PACKET_APID_MASK));                        // APID
+    for(size_t i = 0; i < count; ++i){
+        sdus[i] = assemble(std::move(sdus[i]), ident, sequence_control(SEQUENCE_UNSEGMENTED, first + i));
+    }
+    return service.transfer_batch(sdus, count);
+}
 
-    header->sequence_control = ccsds::htons(
-            (SEQUENCE_UNSEGMENTED << SEQUENCE_FLAGS_SHIFT) // sequence flags
-            | (packet_count++ & SEQUENCE_COUNT_MASK));     // packet sequence count
+ccsds::error octet_service::request_async(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, packet_type type, completion done)
+{
+    CCSDS_TRACE_SCOPE(OCTET_REQUEST, service_id, ccsds::trace::NO_COUNT, sdu->totalSize());
+    auto pdu = assembly(std::move(sdu), secondary, type);
+    return service.transfer_async(std::move(pdu), done);
+}
 
-    header->data_length = ccsds::htons(sdu->totalSize() - 1);
+size_t octet_service::credit() const
+{
+    return service.credit();
+}
 
-    // Attach the header to the packet
-    pdu->append(std::move(sdu));
+void octet_service::set_scheduler(priority_scheduler* sched, int qos)
+{
+    service.set_scheduler(sched, qos);
+}
 
-    return pdu;
+size_t octet_service::process()
+{
+    return service.process();
 }
 
-std::unique_ptr<const ccsds::spp::pdu> octet_service::assembly(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, uint16_t name)
+uint16_t octet_service::next_count(uint16_t n)
 {
+    if(concurrent){
+        // The count wraps at a multiple of the 14-bit sequence count
+        return packet_count.fetch_add(n, std::memory_order_relaxed);
+    }else{
+        uint16_t count = packet_count.load(std::memory_order_relaxed);
+        packet_count.store(count + n, std::memory_order_relaxed);
+        return count;
+    }
+}
+
+std::unique_ptr<ccsds::spp::pdu> octet_service::assemble(std::unique_ptr<const ccsds::base_du> sdu, uint16_t identification, uint16_t sequence_control)
+{
+    CCSDS_TRACE_SCOPE(ASSEMBLY, service_id, ccsds::ntohs(sequence_control) & SEQUENCE_COUNT_MASK, sdu->totalSize());
     std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
     primary_header* header = &(*pdu)->header;
 
-    header->identification = ccsds::htons(
-            (PACKET_VERSION_1 << PACKET_VERSION_SHIFT)         // packet version number
-            | ((TELECOMMAND & PACKET_TYPE_MASK) << PACKET_TYPE_SHIFT) // packet type
-            | ((!!secondary) << PACKET_SEC_HDR_SHIFT)          // secondary header flag
-            | (id & PACKET_APID_MASK));                        // APID
-
-    header->sequence_control = ccsds::htons(
-            (SEQUENCE_UNSEGMENTED << SEQUENCE_FLAGS_SHIFT) // sequence flags
-            | (name & SEQUENCE_COUNT_MASK));     // packet sequence count
-
-    header->data_length = ccsds::htons(sdu->totalSize() - 1);
+    size_t trailer = error_control ? sizeof(packet_error_control) : 0;
+    header->identification = identification;
+    header->sequence_control = sequence_control;
+    header->data_length = ccsds::htons(sdu->totalSize() + trailer - 1);
 
     // Attach the header to the packet
     pdu->append(std::move(sdu));
 
+    if(error_control){
+        auto field = std::make_unique<ccsds::du<packet_error_control>>();
+        (*field)->crc = ccsds::htons(ccsds::crc16(*pdu));
+        pdu->extend(std::move(field));
+    }
+
     return pdu;
 }
 
+std::unique_ptr<const ccsds::spp::pdu> octet_service::assembly(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, packet_type type)
+{
+    return assemble(std::move(sdu),
+            identification(service_id, type, secondary),
+            sequence_control(SEQUENCE_UNSEGMENTED, next_count()));
+}
+
+std::unique_ptr<const ccsds::spp::pdu> octet_service::assembly(std::unique_ptr<const ccsds::base_du> sdu, bool secondary, uint16_t name)
+{
+    return assemble(std::move(sdu),
+            identification(service_id, TELECOMMAND, secondary),
+            sequence_control(SEQUENCE_UNSEGMENTED, name));
+}
+
 ccsds::error packet_service::transfer(std::unique_ptr<const ccsds::base_du> sdu)
 {
-    if(subnetwork != nullptr){
+    CCSDS_TRACE_SCOPE(PACKET_TRANSFER, *sdu);
+    if(scheduler != nullptr){
+        return schedule(std::move(sdu), service_qos, nullptr);
+    }else if(subnetwork != nullptr){
+        CCSDS_TRACE_SCOPE(SUBNETWORK, *sdu);
         return subnetwork->transfer(std::move(sdu));
     }else{
         return error(error::code::NO_NETWORK);
     }
 }
 
+ccsds::error packet_service::transfer_batch(std::unique_ptr<const ccsds::base_du> sdus[], size_t count)
+{
+    if(subnetwork == nullptr){
+        return error(error::code::NO_NETWORK);
+    }else if(scheduler == nullptr){
+        return subnetwork->transfer_batch(sdus, count);
+    }
+
+    // Queue the whole batch before draining so it keeps its order
+    for(size_t i = 0; i < count; ++i){
+        ccsds::error e = scheduler->enqueue(std::move(sdus[i]), service_qos);
+        if(e){
+            scheduler->drain(subnetwork);
+            return e;
+        }
+    }
+    scheduler->drain(subnetwork);
+    return error();
+}
+
+ccsds::error packet_service::transfer_async(std::unique_ptr<const ccsds::base_du> sdu, completion done)
+{
+    CCSDS_TRACE_SCOPE(PACKET_TRANSFER, *sdu);
+    if(scheduler != nullptr){
+        return schedule(std::move(sdu), service_qos, done);
+    }else if(subnetwork != nullptr){
+        CCSDS_TRACE_SCOPE(SUBNETWORK, *sdu);
+        return subnetwork->transfer_async(std::move(sdu), done);
+    }else{
+        return error(error::code::NO_NETWORK);
+    }
+}
+
+size_t packet_service::credit() const
+{
+    if(subnetwork == nullptr){
+        return 0;
+    }else if(scheduler != nullptr){
+        return scheduler->credit(service_qos);
+    }else{
+        return subnetwork->credit();
+    }
+}
+
 ccsds::error octet_service::transfer(std::unique_ptr<const ccsds::base_du> sdu)
 {
     (void)sdu;
     return error(error::code::NO_SUPPORT);
 }
 
+ccsds::error octet_service::transfer_async(std::unique_ptr<const ccsds::base_du> sdu, completion done)
+{
+    (void)sdu;
+    (void)done;
+    return error(error::code::NO_SUPPORT);
+}
+
 void packet_service::set_indication(indication func)
 {
     callback = func;
 }
 
+/**
+ * Check the primary header of a received packet.
+ * @param pdu Received packet.
+ * @return true if the version number or the data length is invalid, false otherwise.
+ */
+static bool malformed(const ccsds::spp::pdu& pdu)
+{
+    const primary_header* header = &pdu->header;
+    return ((ccsds::ntohs(header->identification) >> PACKET_VERSION_SHIFT) != PACKET_VERSION_1)
+            || (sizeof(primary_header) + ccsds::ntohs(header->data_length) + 1 != pdu.totalSize());
+}
+
+bool packet_service::track(apid id, uint16_t count, size_t size)
+{
+    // Check for possible packet loss, each APID has its own sequence
+    if(!sequences){
+        sequences = std::make_unique<sequence_tracker[]>(PACKET_APID_MASK + 1);
+    }
+    sequence_tracker::status status = sequences[id & PACKET_APID_MASK].update(count, tolerance);
+
+    if(stats != nullptr){
+        stats->packet(id, size, status.missing);
+    }
+    return status.missing != 0;
+}
+
 void packet_service::reception(std::unique_ptr<const ccsds::spp::pdu> pdu)
 {
+    CCSDS_TRACE_SCOPE(PACKET_RECEPTION, *pdu);
     const primary_header* header = &(*pdu)->header;
 
-    // Check for possible packet loss
-    uint16_t count = header->sequence_control & SEQUENCE_COUNT_MASK;
-    bool loss = true;
-    if(count == ((last_count + 1) & SEQUENCE_COUNT_MASK)){
-        loss = false;
+    // Extract APID
+    apid id = static_cast<apid>(ccsds::ntohs(header->identification) & PACKET_APID_MASK);
+    if(malformed(*pdu)){
+        if(stats != nullptr){
+            stats->malformed(id);
+        }
+        return;
     }
-    last_count = count;
 
+    bool loss = track(id, ccsds::ntohs(header->sequence_control) & SEQUENCE_COUNT_MASK, pdu->totalSize());
     if(callback != nullptr){
-        // Extract APID
-        apid id = static_cast<apid>(header->identification & PACKET_APID_MASK);
-
+        CCSDS_TRACE_SCOPE(INDICATION, *pdu);
         callback(std::move(pdu), id, loss);
     }
 }
 
+void packet_service::set_view_indication(view_indication func)
+{
+    view_callback = func;
+}
+
+void packet_service::reception(const packet_view& packet)
+{
+    if(packet.buffer_size() < sizeof(primary_header)){
+        return;
+    }
+    CCSDS_TRACE_SCOPE(PACKET_RECEPTION, packet.id(), packet.count(), packet.size());
+
+    apid id = packet.id();
+    if(!packet.valid()){
+        if(stats != nullptr){
+            stats->malformed(id);
+        }
+        return;
+    }
+
+    bool loss = track(id, packet.count(), packet.size());
+    if(view_callback != nullptr){
+        CCSDS_TRACE_SCOPE(INDICATION, id, packet.count(), packet.size());
+        view_callback(packet, id, loss);
+    }
+}
+
+void packet_service::set_reorder_tolerance(uint8_t tolerance)
+{
+    this->tolerance = std::min(tolerance, sequence_tracker::MAX_TOLERANCE);
+}
+
+void packet_service::set_statistics(statistics* stats)
+{
+    this->stats = stats;
+}
+
 void octet_service::set_indication(indication func)
 {
     callback = func;
 }
 
+/**
+ * View of the start of a DU, owning the DU.
+ */
+class prefix_du : public ccsds::base_du {
+    public:
+        /**
+         * Constructor.
+         * @param du DU to view, with any DUs after it.
+         * @param len Number of bytes of du to view, at most du->size().
+         */
+        prefix_du(std::unique_ptr<const ccsds::base_du> du, size_t len) :
+            du(std::move(du)),
+            len(len)
+        {}
+
+        /**
+         * Get the size of the buffer in bytes.
+         * @return Buffer size in bytes.
+         */
+        virtual size_t size() const override
+        {
+            return len;
+        }
+
+        /**
+         * Access the buffer.
+         * @return Pointer to the buffer.
+         */
+        virtual const void* get() const override
+        {
+            return du->get();
+        }
+
+    private:
+        std::unique_ptr<const ccsds::base_du> du;  ///< Viewed DU.
+        size_t                                len; ///< Number of bytes viewed.
+};
+
+/**
+ * Remove the packet error control field from a received packet.
+ * The DUs before the field are kept as they are, only a DU holding part of
+ * the field as well as user data is replaced by a view of its user data.
+ * @param pdu Received packet, its total size at least the primary header
+ * and the field.
+ * @return Packet data field without the packet error control field.
+ */
+static std::unique_ptr<const ccsds::base_du> trim(ccsds::spp::pdu& pdu)
+{
+    size_t len = pdu.totalSize() - sizeof(packet_error_control);
+    std::unique_ptr<const ccsds::base_du> rest = pdu.split(len);
+    size_t partial = len - pdu.totalSize();
+    if(partial > 0){
+        pdu.extend(std::make_unique<prefix_du>(std::move(rest), partial));
+    }
+
+    std::unique_ptr<const ccsds::base_du> data = pdu.pop();
+    if(!data){
+        data = std::make_unique<ccsds::buffered_du>(nullptr, 0);
+    }
+    return data;
+}
+
 void octet_service::reception(std::unique_ptr<ccsds::spp::pdu> pdu)
 {
+    CCSDS_TRACE_SCOPE(OCTET_RECEPTION, *pdu);
     const primary_header* header = &(*pdu)->header;
 
     // Extract APID
     apid pdu_id = static_cast<apid>(ccsds::ntohs(header->identification) & PACKET_APID_MASK);
-    if(pdu_id == id){
-        // Check for possible packet loss
-        uint16_t count = ccsds::ntohs(header->sequence_control) & SEQUENCE_COUNT_MASK;
-        bool loss = true;
-        if(count == ((last_count + 1) & SEQUENCE_COUNT_MASK)){
-            loss = false;
+    if(pdu_id == service_id){
+        if(malformed(*pdu)){
+            if(stats != nullptr){
+                stats->malformed(service_id);
+            }
+            return;
         }
-        last_count = count;
 
-        if(callback != nullptr){
-            callback(std::move(pdu->pop()), id, loss);
+        size_t size = pdu->totalSize();
+        if(error_control && ((size < sizeof(primary_header) + sizeof(packet_error_control)) || (ccsds::crc16(*pdu) != 0))){
+            if(stats != nullptr){
+                stats->malformed(service_id);
+            }
+            return;
         }
+
+        uint16_t sequence = ccsds::ntohs(header->sequence_control);
+        std::unique_ptr<const ccsds::base_du> data = error_control ? trim(*pdu) : pdu->pop();
+        receive(sequence, size, std::move(data));
     }
 }
 
+void octet_service::reception(const packet_view& packet, std::shared_ptr<const void> owner)
+{
+    if((packet.buffer_size() < sizeof(primary_header)) || (packet.id() != service_id)){
+        return;
+    }
+    CCSDS_TRACE_SCOPE(OCTET_RECEPTION, service_id, packet.count(), packet.size());
+    size_t trailer = error_control ? sizeof(packet_error_control) : 0;
+    if(!packet.valid() || (packet.data_length() < trailer)
+            || (error_control && (ccsds::crc16(packet.get(), packet.size()) != 0))){
+        if(stats != nullptr){
+            stats->malformed(service_id);
+        }
+        return;
+    }
+
+    receive(packet.sequence(), packet.size(),
+            std::make_unique<ccsds::view_du>(std::move(owner), packet.data(), packet.data_length() - trailer));
+}
+
+void octet_service::receive(uint16_t sequence, size_t size, std::unique_ptr<const ccsds::base_du> data)
+{
+    // Check for possible packet loss
+    sequence_tracker::status status = this->sequence.update(sequence & SEQUENCE_COUNT_MASK, tolerance);
+    bool loss = (status.missing != 0);
+    if(stats != nullptr){
+        stats->packet(service_id, size, status.missing);
+    }
+
+    // Reassemble segmented user data, segments must arrive in order
+    std::unique_ptr<const ccsds::base_du> sdu = std::move(data);
+    uint16_t flags = sequence >> SEQUENCE_FLAGS_SHIFT;
+    if((flags != SEQUENCE_UNSEGMENTED) || segments.pending()){
+        loss |= status.late;
+        sdu = segments.reception(std::move(sdu), flags, loss);
+    }
+
+    if((sdu != nullptr) && (callback != nullptr)){
+        CCSDS_TRACE_SCOPE(INDICATION, service_id, sequence & SEQUENCE_COUNT_MASK, sdu->totalSize());
+        callback(std::move(sdu), service_id, loss);
+    }
+}
+
+void octet_service::set_reassembly(size_t max_length, std::chrono::steady_clock::duration timeout)
+{
+    segments.configure(max_length, timeout);
+}
+
+bool octet_service::expire()
+{
+    return segments.expire();
+}
+
+void octet_service::set_statistics(statistics* stats)
+{
+    this->stats = stats;
+}
+
+void octet_service::set_reorder_tolerance(uint8_t tolerance)
+{
+    this->tolerance = std::min(tolerance, sequence_tracker::MAX_TOLERANCE);
+}
+
+void octet_service::set_error_control(bool enable)
+{
+    error_control = enable;
+}
+
 /** @} */ // group spp
 } // namespace spp
 } // namespace ccsds
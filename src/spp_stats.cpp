@@ -0,0 +1,74 @@
+/**
+ * @file spp_stats.cpp
+ * @ingroup spp
+ */
+
+#include "ccsds/spp_stats.h"
+
+namespace ccsds {
+namespace spp {
+/**
+ * @ingroup spp
+ * @{
+ */
+
+statistics::statistics(bool concurrent) :
+    concurrent(concurrent)
+{
+    reset();
+}
+
+counters statistics::snapshot(apid id) const
+{
+    return read(entries[id & PACKET_APID_MASK]);
+}
+
+void statistics::snapshot(std::array<counters, SIZE>& all) const
+{
+    for(size_t i = 0; i < SIZE; ++i){
+        all[i] = read(entries[i]);
+    }
+}
+
+counters statistics::total() const
+{
+    counters sum = {};
+    for(const entry& e : entries){
+        counters c = read(e);
+        sum.packets += c.packets;
+        sum.bytes += c.bytes;
+        sum.gaps += c.gaps;
+        sum.missing += c.missing;
+        sum.idle += c.idle;
+        sum.malformed += c.malformed;
+    }
+    return sum;
+}
+
+void statistics::reset()
+{
+    for(entry& e : entries){
+        e.packets.store(0, std::memory_order_relaxed);
+        e.bytes.store(0, std::memory_order_relaxed);
+        e.gaps.store(0, std::memory_order_relaxed);
+        e.missing.store(0, std::memory_order_relaxed);
+        e.idle.store(0, std::memory_order_relaxed);
+        e.malformed.store(0, std::memory_order_relaxed);
+    }
+}
+
+counters statistics::read(const entry& e)
+{
+    return {
+        e.packets.load(std::memory_order_relaxed),
+        e.bytes.load(std::memory_order_relaxed),
+        e.gaps.load(std::memory_order_relaxed),
+        e.missing.load(std::memory_order_relaxed),
+        e.idle.load(std::memory_order_relaxed),
+        e.malformed.load(std::memory_order_relaxed),
+    };
+}
+
+/** @} */ // group spp
+} // namespace spp
+} // namespace ccsds
@@ -0,0 +1,66 @@
+/**
+ * @file tee_service.cpp
+ */
+
+#include "ccsds/tee.h"
+#include "ccsds/shared_du.h"
+#include <algorithm>
+
+/**
+ * @ingroup ccsds
+ * @{
+ */
+namespace ccsds {
+
+tee_service::tee_service(bool concurrent) :
+    concurrent(concurrent)
+{
+
+}
+
+ccsds::error tee_service::attach(ccsds::base_service* subnetwork)
+{
+    if(subnetwork == nullptr){
+        return error(error::code::INVALID_ARG);
+    }
+    subnetworks.push_back(subnetwork);
+    return error();
+}
+
+void tee_service::detach(ccsds::base_service* subnetwork)
+{
+    subnetworks.erase(std::remove(subnetworks.begin(), subnetworks.end(), subnetwork), subnetworks.end());
+}
+
+ccsds::error tee_service::transfer(std::unique_ptr<const ccsds::base_du> du)
+{
+    if(subnetworks.empty()){
+        return error(error::code::NO_NETWORK);
+    }else if(subnetworks.size() == 1){
+        return subnetworks[0]->transfer(std::move(du));
+    }
+
+    // Each subnetwork holds a reference, the payload goes with the last one
+    const shared_payload* payload = shared_payload::create(std::move(du), concurrent);
+    ccsds::error result;
+    for(ccsds::base_service* subnetwork : subnetworks){
+        ccsds::error e = subnetwork->transfer(shared_du::share(*payload));
+        if(e && !result){
+            result = e;
+        }
+    }
+    payload->release();
+    return result;
+}
+
+size_t tee_service::credit() const
+{
+    size_t lowest = SIZE_MAX;
+    for(const ccsds::base_service* subnetwork : subnetworks){
+        lowest = std::min(lowest, subnetwork->credit());
+    }
+    return lowest;
+}
+
+} // namespace ccsds
+/**@} ccsds*/
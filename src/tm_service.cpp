@@ -0,0 +1,340 @@
+/**
+ * @file tm_service.cpp
+ * @ingroup tm
+ */
+
+#include "ccsds/tm.h"
+#include "ccsds/crc.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ccsds {
+namespace tm {
+/**
+ * @ingroup tm
+ * @{
+ */
+
+class frame_service::frame_du : public ccsds::base_du {
+    public:
+        /**
+         * Constructor.
+         * @param master Master channel owning the frame buffer.
+         * @param index Index of the frame buffer.
+         */
+        frame_du(frame_service& master, size_t index) :
+            master(master),
+            index(index)
+        {}
+
+        /**
+         * Destructor, returns the frame buffer to the master channel.
+         */
+        virtual ~frame_du()
+        {
+            master.release(index);
+        }
+
+        virtual size_t size() const override
+        {
+            return master.frame_length;
+        }
+
+        virtual const void* get() const override
+        {
+            return &master.buffers[index * master.frame_length];
+        }
+
+    private:
+        frame_service& master; ///< Master channel owning the frame buffer.
+        size_t         index;  ///< Index of the frame buffer.
+};
+
+/**
+ * Get the length of the primary header and error control field of a frame.
+ * @param error_control Frames have a frame error control field.
+ * @return Length in bytes.
+ */
+static size_t overhead(bool error_control)
+{
+    return sizeof(frame_header) + (error_control ? sizeof(frame_error_control) : 0);
+}
+
+frame_service::frame_service(uint16_t scid, size_t length, ccsds::base_service* subnetwork, size_t frames, bool error_control) :
+    subnetwork(subnetwork),
+    scid(scid),
+    frame_length(std::clamp(length, overhead(error_control) + 1, MAX_FRAME_LENGTH)),
+    frames(std::max<size_t>(frames, 1)),
+    error_control(error_control),
+    count(0),
+    cursor(0),
+    buffers(std::make_unique<uint8_t[]>(this->frames * frame_length)),
+    busy(std::make_unique<std::atomic<bool>[]>(this->frames)),
+    unused(this->frames)
+{
+    for(size_t i = 0; i < this->frames; ++i){
+        busy[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+size_t frame_service::length() const
+{
+    return frame_length;
+}
+
+size_t frame_service::data_length() const
+{
+    return frame_length - overhead(error_control);
+}
+
+size_t frame_service::available() const
+{
+    return unused.load(std::memory_order_acquire);
+}
+
+uint8_t* frame_service::acquire()
+{
+    for(size_t i = 0; i < frames; ++i){
+        size_t index = (cursor + i) % frames;
+        if(!busy[index].load(std::memory_order_acquire)){
+            busy[index].store(true, std::memory_order_relaxed);
+            unused.fetch_sub(1, std::memory_order_relaxed);
+            cursor = index + 1;
+            return &buffers[index * frame_length];
+        }
+    }
+    return nullptr;
+}
+
+void frame_service::release(size_t index)
+{
+    busy[index].store(false, std::memory_order_release);
+    unused.fetch_add(1, std::memory_order_release);
+}
+
+ccsds::error frame_service::transmit(uint8_t* frame)
+{
+    size_t index = (frame - buffers.get()) / frame_length;
+    if(subnetwork == nullptr){
+        release(index);
+        return error(error::code::NO_NETWORK);
+    }
+
+    frame_header* header = reinterpret_cast<frame_header*>(frame);
+    header->mc_count = count++;
+    if(error_control){
+        uint16_t crc = ccsds::htons(ccsds::crc16(frame, frame_length - sizeof(frame_error_control)));
+        memcpy(frame + frame_length - sizeof(frame_error_control), &crc, sizeof(crc));
+    }
+
+    return subnetwork->transfer(std::make_unique<frame_du>(*this, index));
+}
+
+virtual_channel::virtual_channel(frame_service& master, uint8_t vcid, uint8_t pattern) :
+    master(master),
+    vcid(vcid & FRAME_VCID_MASK),
+    count(0),
+    frame(nullptr),
+    offset(0),
+    first_header(FHP_NO_PACKET),
+    idle(nullptr, pattern)
+{
+
+}
+
+virtual_channel::~virtual_channel()
+{
+    if(frame != nullptr){
+        master.release((frame - master.buffers.get()) / master.frame_length);
+    }
+}
+
+uint8_t virtual_channel::id() const
+{
+    return vcid;
+}
+
+ccsds::error virtual_channel::transfer(std::unique_ptr<const ccsds::base_du> du)
+{
+    if(du->totalSize() < sizeof(ccsds::spp::primary_header)){
+        return error(error::code::INVALID_ARG);
+    }
+    return write(*du);
+}
+
+ccsds::error virtual_channel::write(const ccsds::base_du& du)
+{
+    // Reserve every frame the packet needs before writing any of it
+    size_t capacity = master.data_length();
+    size_t space = (frame != nullptr) ? capacity - offset : 0;
+    size_t size = du.totalSize();
+    if((size > space) && (master.available() < (size - space + capacity - 1) / capacity)){
+        return error(error::code::NO_SPACE);
+    }
+
+    ccsds::error result;
+    bool start = true;
+    for(const ccsds::base_du* node = &du; ; node = &node->next()){
+        const uint8_t* data = static_cast<const uint8_t*>(node->get());
+        size_t len = node->size();
+        while(len > 0){
+            if(frame == nullptr){
+                frame = master.acquire();
+                offset = 0;
+                first_header = FHP_NO_PACKET;
+            }
+            if(start){
+                if(first_header == FHP_NO_PACKET){
+                    first_header = offset;
+                }
+                start = false;
+            }
+
+            size_t copy = std::min(len, capacity - offset);
+            memcpy(frame + sizeof(frame_header) + offset, data, copy);
+            offset += copy;
+            data += copy;
+            len -= copy;
+
+            if(offset == capacity){
+                ccsds::error e = emit();
+                if(e && !result){
+                    result = e;
+                }
+            }
+        }
+        if(node->length() == 1){
+            break;
+        }
+    }
+    return result;
+}
+
+ccsds::error virtual_channel::emit()
+{
+    frame_header* header = reinterpret_cast<frame_header*>(frame);
+    header->identification = identification(master.scid, vcid);
+    header->vc_count = count++;
+    header->status = ccsds::htons(STATUS_UNSEGMENTED | first_header);
+
+    uint8_t* full = frame;
+    frame = nullptr;
+    return master.transmit(full);
+}
+
+ccsds::error virtual_channel::flush()
+{
+    if(frame == nullptr){
+        return error();
+    }
+
+    size_t space = master.data_length() - offset;
+    if(space >= ccsds::spp::idle_service::MIN_PACKET_SIZE){
+        // Idle packets fit in the frame
+        if(first_header == FHP_NO_PACKET){
+            first_header = offset;
+        }
+        offset += idle.fill(frame + sizeof(frame_header) + offset, space);
+        return emit();
+    }
+
+    // Start a minimum length idle packet, finishing it in the next frame
+    uint8_t packet[ccsds::spp::idle_service::MIN_PACKET_SIZE];
+    idle.fill(packet, sizeof(packet));
+    ccsds::buffered_du du(packet, sizeof(packet));
+    return write(du);
+}
+
+size_t virtual_channel::pending() const
+{
+    return (frame != nullptr) ? offset : 0;
+}
+
+frame_demux::frame_demux(uint16_t scid, size_t length, bool error_control) :
+    scid(scid & FRAME_SCID_MASK),
+    frame_length(length),
+    error_control(error_control)
+{
+
+}
+
+void frame_demux::channel::packet(const ccsds::buffered_du& packet)
+{
+    ccsds::spp::packet_view view(packet.get(), packet.size());
+    if((service != nullptr) && (view.id() != ccsds::spp::APID_IDLE)){
+        service->reception(view);
+    }
+}
+
+ccsds::error frame_demux::attach(uint8_t vcid, ccsds::spp::packet_service* service)
+{
+    if(vcid >= VIRTUAL_CHANNELS){
+        return error(error::code::INVALID_ARG);
+    }
+
+    if(!channels[vcid]){
+        channels[vcid] = std::make_unique<channel>();
+        channel& ch = *channels[vcid];
+        ch.framer.set_indication(ccsds::spp::packet_framer::indication::bind<&channel::packet>(&ch));
+        ch.count = 0;
+        ch.sync = false;
+    }
+    channels[vcid]->service = service;
+    return error();
+}
+
+ccsds::error frame_demux::reception(void* frame, size_t len)
+{
+    if((len != frame_length) || (len <= overhead(error_control))){
+        return error(error::code::INVALID_ARG);
+    }
+
+    uint8_t* bytes = static_cast<uint8_t*>(frame);
+    frame_header header;
+    memcpy(&header, bytes, sizeof(header));
+    uint16_t ident = ccsds::ntohs(header.identification);
+    if(((ident >> FRAME_VERSION_SHIFT) != FRAME_VERSION_1) || (((ident >> FRAME_SCID_SHIFT) & FRAME_SCID_MASK) != scid)){
+        return error(error::code::INVALID_ARG);
+    }
+    if(error_control && (ccsds::crc16(bytes, len) != 0)){
+        return error(error::code::IO_ERROR);
+    }
+
+    channel* ch = channels[(ident >> FRAME_VCID_SHIFT) & FRAME_VCID_MASK].get();
+    if((ch == nullptr) || (ch->service == nullptr)){
+        return error();
+    }
+
+    uint16_t first_header = ccsds::ntohs(header.status) & STATUS_FHP_MASK;
+    uint8_t* data = bytes + sizeof(frame_header);
+    size_t data_length = len - overhead(error_control);
+    if((first_header != FHP_NO_PACKET) && (first_header != FHP_IDLE) && (first_header >= data_length)){
+        return error(error::code::INVALID_ARG);
+    }
+
+    // A missing frame loses the packet boundaries
+    if(ch->sync && (header.vc_count != static_cast<uint8_t>(ch->count + 1))){
+        ch->sync = false;
+    }
+    ch->count = header.vc_count;
+    if(first_header == FHP_IDLE){
+        return error();
+    }
+
+    if(!ch->sync){
+        ch->framer.reset();
+        if(first_header == FHP_NO_PACKET){
+            return error();
+        }
+        data += first_header;
+        data_length -= first_header;
+        ch->sync = true;
+    }
+
+    ch->framer.reception(data, data_length);
+    return error();
+}
+
+/** @} */ // group tm
+} // namespace tm
+} // namespace ccsds
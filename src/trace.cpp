@@ -0,0 +1,144 @@
+/**
+ * @file trace.cpp
+ */
+
+#include "ccsds/trace.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @ingroup ccsds
+ * @{
+ */
+namespace ccsds {
+namespace trace {
+
+/**
+ * Single producer, single consumer ring of the events of one thread.
+ */
+struct ring {
+    event                 events[RING_SIZE]; ///< Recorded events.
+    std::atomic<size_t>   head;              ///< Next event to record, written by the thread.
+    std::atomic<size_t>   tail;              ///< Next event to drain, written by the tracer.
+    std::atomic<uint64_t> lost;              ///< Events dropped because the ring was full.
+    uint32_t              thread;            ///< Number of the thread.
+
+    /**
+     * Constructor.
+     * @param thread Number of the thread.
+     */
+    explicit ring(uint32_t thread) :
+        head(0),
+        tail(0),
+        lost(0),
+        thread(thread)
+    {}
+};
+
+/**
+ * Rings of every thread that recorded an event.
+ * Rings outlive their thread so its last events can still be drained.
+ */
+static struct {
+    std::mutex                         lock;  ///< Serializes registration and draining.
+    std::vector<std::shared_ptr<ring>> rings; ///< Rings by thread number.
+} registry;
+
+/**
+ * Get the ring of the calling thread, registering it on first use.
+ * @return Ring of the calling thread.
+ */
+static ring& local()
+{
+    thread_local std::shared_ptr<ring> r = [](){
+        std::lock_guard<std::mutex> guard(registry.lock);
+        auto created = std::make_shared<ring>(static_cast<uint32_t>(registry.rings.size()));
+        registry.rings.push_back(created);
+        return created;
+    }();
+    return *r;
+}
+
+const char* name(point where)
+{
+    static const char* const names[POINTS] = {
+        "octet_request",
+        "assembly",
+        "packet_transfer",
+        "subnetwork",
+        "packet_reception",
+        "octet_reception",
+        "indication",
+    };
+    size_t index = static_cast<size_t>(where);
+    return (index < POINTS) ? names[index] : "unknown";
+}
+
+void record(const event& e)
+{
+    ring& r = local();
+    size_t head = r.head.load(std::memory_order_relaxed);
+    if(head - r.tail.load(std::memory_order_acquire) >= RING_SIZE){
+        r.lost.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    event& slot = r.events[head % RING_SIZE];
+    slot = e;
+    slot.thread = r.thread;
+    r.head.store(head + 1, std::memory_order_release);
+}
+
+size_t drain(event* events, size_t max)
+{
+    std::lock_guard<std::mutex> guard(registry.lock);
+    size_t taken = 0;
+    for(const auto& r : registry.rings){
+        size_t tail = r->tail.load(std::memory_order_relaxed);
+        size_t head = r->head.load(std::memory_order_acquire);
+        while((tail != head) && (taken < max)){
+            events[taken++] = r->events[tail % RING_SIZE];
+            ++tail;
+        }
+        r->tail.store(tail, std::memory_order_release);
+    }
+    return taken;
+}
+
+uint64_t dropped()
+{
+    std::lock_guard<std::mutex> guard(registry.lock);
+    uint64_t total = 0;
+    for(const auto& r : registry.rings){
+        total += r->lost.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+ccsds::error dump(std::FILE* out)
+{
+    bool ok = (std::fputs("{\"traceEvents\":[", out) >= 0);
+    event events[256];
+    bool first = true;
+    size_t count;
+    while(ok && ((count = drain(events, 256)) > 0)){
+        for(size_t i = 0; ok && (i < count); ++i){
+            const event& e = events[i];
+            // Complete events, timestamps in microseconds
+            ok = (std::fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%llu.%03u,\"dur\":%llu.%03u,\"pid\":1,\"tid\":%u,"
+                    "\"args\":{\"apid\":%u,\"count\":%d,\"size\":%u}}",
+                    first ? "" : ",", name(e.where),
+                    static_cast<unsigned long long>(e.begin / 1000), static_cast<unsigned>(e.begin % 1000),
+                    static_cast<unsigned long long>((e.end - e.begin) / 1000), static_cast<unsigned>((e.end - e.begin) % 1000),
+                    e.thread, e.apid, (e.count == NO_COUNT) ? -1 : e.count, e.size) >= 0);
+            first = false;
+        }
+    }
+    ok = ok && (std::fputs("\n]}\n", out) >= 0) && (std::fflush(out) == 0);
+    return ok ? error() : error(error::code::IO_ERROR);
+}
+
+} // namespace trace
+} // namespace ccsds
+/**@} ccsds*/
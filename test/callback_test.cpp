@@ -0,0 +1,130 @@
+/**
+ * @file test/callback_test.cpp
+ */
+
+#include "ccsds/callback.h"
+#include "ccsds/spp.h"
+#include "CppUTest/TestHarness.h"
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Callback test group.
+ */
+TEST_GROUP(CallbackTestGroup)
+{
+};
+
+/**
+ * Test function for plain callbacks.
+ */
+static int callback_double(int v)
+{
+    return v * 2;
+}
+
+/**
+ * Test function for callbacks with a context.
+ */
+static int callback_add(void* context, int v)
+{
+    return *static_cast<int*>(context) + v;
+}
+
+/**
+ * Handler object receiving SDUs from an octet service.
+ */
+class callback_handler {
+    public:
+        callback_handler() :
+            received(0),
+            bytes(0)
+        {}
+
+        /**
+         * Receive an SDU.
+         */
+        void receive(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool data_loss)
+        {
+            (void)id;
+            CHECK_FALSE(data_loss);
+            ++received;
+            bytes += sdu->totalSize();
+        }
+
+        /**
+         * Scale a value.
+         */
+        int scale(int v)
+        {
+            return v * 10;
+        }
+
+        size_t received; ///< Number of SDUs received.
+        size_t bytes;    ///< Number of bytes received.
+};
+
+/**
+ * Test making and calling callbacks.
+ */
+TEST(CallbackTestGroup, CallbackTest)
+{
+    ccsds::callback<int(int)> cb;
+    CHECK_FALSE(cb);
+    CHECK(cb == nullptr);
+
+    cb = &callback_double;
+    CHECK(cb != nullptr);
+    CHECK_EQUAL(6, cb(3));
+
+    int offset = 5;
+    cb = ccsds::callback<int(int)>(&callback_add, &offset);
+    CHECK_EQUAL(8, cb(3));
+
+    callback_handler handler;
+    cb = ccsds::callback<int(int)>::bind<&callback_handler::scale>(&handler);
+    CHECK_EQUAL(30, cb(3));
+
+    int calls = 0;
+    auto lambda = [&calls](int v){
+        ++calls;
+        return v + 1;
+    };
+    cb = ccsds::callback<int(int)>::bind(lambda);
+    CHECK_EQUAL(4, cb(3));
+    CHECK_EQUAL(1, calls);
+
+    int (*none)(int) = nullptr;
+    cb = none;
+    CHECK(cb == nullptr);
+}
+
+/**
+ * Test services dispatching into their own handler objects.
+ */
+TEST(CallbackTestGroup, IndicationTest)
+{
+    callback_handler handlers[2];
+    ccsds::spp::octet_service a(static_cast<ccsds::spp::apid>(0x100), nullptr);
+    ccsds::spp::octet_service b(static_cast<ccsds::spp::apid>(0x101), nullptr);
+    a.set_indication(ccsds::spp::octet_service::indication::bind<&callback_handler::receive>(&handlers[0]));
+    b.set_indication(ccsds::spp::octet_service::indication::bind<&callback_handler::receive>(&handlers[1]));
+
+    uint8_t data[4] = {};
+    for(uint16_t i = 0; i < 3; ++i){
+        std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+        (*pdu)->header.identification = ccsds::spp::identification(static_cast<ccsds::spp::apid>(0x100), ccsds::spp::TELEMETRY, false);
+        (*pdu)->header.sequence_control = ccsds::spp::sequence_control(ccsds::spp::SEQUENCE_UNSEGMENTED, i);
+        (*pdu)->header.data_length = ccsds::htons(sizeof(data) - 1);
+        pdu->append(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)));
+        a.reception(std::move(pdu));
+    }
+    CHECK_EQUAL(3, handlers[0].received);
+    CHECK_EQUAL(12, handlers[0].bytes);
+    CHECK_EQUAL(0, handlers[1].received);
+}
+
+/** @} */ // group unittest
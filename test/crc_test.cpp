@@ -0,0 +1,347 @@
+/**
+ * @file test/crc_test.cpp
+ */
+
+#include "ccsds/crc.h"
+#include "ccsds/spp.h"
+#include "ccsds/spp_stats.h"
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * CRC test group.
+ */
+TEST_GROUP(CrcTestGroup)
+{
+};
+
+/**
+ * Compute the CRC-16-CCITT one bit at a time.
+ * @param buf Buffer.
+ * @param len Length of buf in bytes.
+ * @return CRC of buf.
+ */
+static uint16_t crc_reference(const uint8_t* buf, size_t len)
+{
+    uint16_t crc = ccsds::CRC16_INIT;
+    for(size_t i = 0; i < len; ++i){
+        crc ^= static_cast<uint16_t>(buf[i] << 8);
+        for(int bit = 0; bit < 8; ++bit){
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/**
+ * Fill a buffer with a pattern.
+ * @param buf Buffer to fill.
+ * @param len Length of buf in bytes.
+ */
+static void crc_fill(uint8_t* buf, size_t len)
+{
+    uint32_t x = 0x12345678;
+    for(size_t i = 0; i < len; ++i){
+        x = x * 1103515245 + 12345;
+        buf[i] = static_cast<uint8_t>(x >> 16);
+    }
+}
+
+/**
+ * Test the standard check value.
+ */
+TEST(CrcTestGroup, CheckTest)
+{
+    const char* check = "123456789";
+    CHECK_EQUAL(0x29B1, ccsds::crc16(check, strlen(check)));
+    CHECK_EQUAL(ccsds::CRC16_INIT, ccsds::crc16(check, 0));
+}
+
+/**
+ * Test every length against the bitwise CRC, across the folding threshold.
+ */
+TEST(CrcTestGroup, LengthTest)
+{
+    std::vector<uint8_t> buffer(1100);
+    crc_fill(buffer.data(), buffer.size());
+
+    for(size_t len = 0; len < buffer.size(); ++len){
+        CHECK_EQUAL(crc_reference(buffer.data(), len), ccsds::crc16(buffer.data(), len));
+        // Unaligned start
+        CHECK_EQUAL(crc_reference(buffer.data() + 1, len - (len > 0)), ccsds::crc16(buffer.data() + 1, len - (len > 0)));
+    }
+}
+
+/**
+ * Test continuing a CRC across buffers.
+ */
+TEST(CrcTestGroup, StreamTest)
+{
+    std::vector<uint8_t> buffer(4096);
+    crc_fill(buffer.data(), buffer.size());
+    uint16_t expected = crc_reference(buffer.data(), buffer.size());
+
+    const size_t chunks[] = {1, 7, 63, 64, 65, 200, 1000};
+    for(size_t chunk : chunks){
+        uint16_t crc = ccsds::CRC16_INIT;
+        for(size_t offset = 0; offset < buffer.size(); offset += chunk){
+            crc = ccsds::crc16(buffer.data() + offset, std::min(chunk, buffer.size() - offset), crc);
+        }
+        CHECK_EQUAL(expected, crc);
+    }
+}
+
+/**
+ * Test a buffer followed by its CRC has a CRC of 0.
+ */
+TEST(CrcTestGroup, ResidueTest)
+{
+    uint8_t buffer[258];
+    crc_fill(buffer, 256);
+    uint16_t crc = ccsds::htons(ccsds::crc16(buffer, 256));
+    memcpy(buffer + 256, &crc, sizeof(crc));
+    CHECK_EQUAL(0, ccsds::crc16(buffer, sizeof(buffer)));
+}
+
+/**
+ * Test the CRC of a DU chain.
+ */
+TEST(CrcTestGroup, ChainTest)
+{
+    uint8_t buffer[300];
+    crc_fill(buffer, sizeof(buffer));
+
+    ccsds::buffered_du du(buffer, 10);
+    du.extend(std::make_unique<ccsds::buffered_du>(buffer + 10, 0));
+    du.extend(std::make_unique<ccsds::buffered_du>(buffer + 10, 200));
+    du.extend(std::make_unique<ccsds::buffered_du>(buffer + 210, 90));
+    CHECK_EQUAL(crc_reference(buffer, sizeof(buffer)), ccsds::crc16(du));
+
+    ccsds::buffered_du single(buffer, 5);
+    CHECK_EQUAL(crc_reference(buffer, 5), ccsds::crc16(single));
+}
+
+/**
+ * CCSDS service keeping transferred packets for error control tests.
+ */
+class crc_test_service : public ccsds::base_service {
+    public:
+        crc_test_service() = default;
+        virtual ~crc_test_service() = default;
+
+        std::vector<std::unique_ptr<ccsds::spp::pdu>> packets; ///< Transferred packets.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override
+        {
+            // This casting is only safe because we know how the test was written
+            ccsds::base_du* du = const_cast<ccsds::base_du*>(sdu.release());
+            packets.emplace_back(static_cast<ccsds::spp::pdu*>(du));
+            return ccsds::error();
+        }
+};
+
+static size_t      crc_received; ///< Number of SDUs received.
+static size_t      crc_length;   ///< Length of the last SDU received.
+static size_t      crc_nodes;    ///< Number of DUs in the last SDU received.
+static const void* crc_first;    ///< Buffer of the first DU of the last SDU received.
+static uint8_t     crc_data[64]; ///< Contents of the last SDU received.
+
+/**
+ * Test indication function recording the SDU.
+ */
+static void crc_indication(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool packet_loss)
+{
+    (void)id;
+    (void)packet_loss;
+    ++crc_received;
+    crc_length = 0;
+    crc_nodes = sdu->length();
+    crc_first = sdu->get();
+    for(const ccsds::base_du* du = sdu.get(); ; du = &du->next()){
+        for(size_t i = 0; (i < du->size()) && (crc_length < sizeof(crc_data)); ++i){
+            crc_data[crc_length++] = static_cast<const uint8_t*>(du->get())[i];
+        }
+        if(du->length() == 1){
+            break;
+        }
+    }
+}
+
+/**
+ * Test the packet error control field is appended and checked.
+ */
+TEST(CrcTestGroup, ErrorControlTest)
+{
+    crc_test_service network;
+    ccsds::spp::statistics stats;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &network);
+    service.set_error_control(true);
+    service.set_indication(crc_indication);
+    service.set_statistics(&stats);
+    crc_received = 0;
+
+    uint8_t payload[20];
+    crc_fill(payload, sizeof(payload));
+    auto sdu = std::make_unique<ccsds::buffered_du>(payload, 12);
+    sdu->extend(std::make_unique<ccsds::buffered_du>(payload + 12, 8));
+    ccsds::error e = service.request(std::move(sdu), false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    CHECK_EQUAL(1, network.packets.size());
+
+    // Data length covers the user data and the CRC
+    ccsds::spp::pdu& packet = *network.packets[0];
+    CHECK_EQUAL(6 + 20 + 2, packet.totalSize());
+    CHECK_EQUAL(20 + 2 - 1, ccsds::ntohs(packet->header.data_length));
+    CHECK_EQUAL(0, ccsds::crc16(packet));
+
+    // Copy the packet to check the view path and corrupt it later
+    uint8_t buffer[28];
+    ccsds::segment segs[8];
+    size_t count = packet.gather(segs, 8);
+    size_t len = 0;
+    for(size_t i = 0; i < count; ++i){
+        memcpy(buffer + len, segs[i].base, segs[i].len);
+        len += segs[i].len;
+    }
+    CHECK_EQUAL(sizeof(buffer), len);
+
+    // The CRC is removed from the received SDU
+    service.reception(std::move(network.packets[0]));
+    CHECK_EQUAL(1, crc_received);
+    CHECK_EQUAL(20, crc_length);
+    MEMCMP_EQUAL(payload, crc_data, 20);
+
+    service.reception(ccsds::spp::packet_view(buffer, sizeof(buffer)));
+    CHECK_EQUAL(2, crc_received);
+    CHECK_EQUAL(20, crc_length);
+    MEMCMP_EQUAL(payload, crc_data, 20);
+
+    // Corrupted packets are discarded
+    buffer[10] ^= 0x04;
+    service.reception(ccsds::spp::packet_view(buffer, sizeof(buffer)));
+    CHECK_EQUAL(2, crc_received);
+    CHECK_EQUAL(1, stats.snapshot(static_cast<ccsds::spp::apid>(0x1AB)).malformed);
+
+    auto corrupt = std::make_unique<ccsds::spp::pdu>();
+    memcpy(&(*corrupt)->header, buffer, sizeof(ccsds::spp::primary_header));
+    corrupt->append(std::make_unique<ccsds::buffered_du>(buffer + 6, sizeof(buffer) - 6));
+    service.reception(std::move(corrupt));
+    CHECK_EQUAL(2, crc_received);
+    CHECK_EQUAL(2, stats.snapshot(static_cast<ccsds::spp::apid>(0x1AB)).malformed);
+}
+
+/**
+ * Build a received packet from a buffer, split into DUs.
+ * @param buffer Space packet.
+ * @param splits Offsets of the data field DUs after the first, ending with the packet size.
+ * @param count Number of offsets.
+ * @return Space packet PDU.
+ */
+static std::unique_ptr<ccsds::spp::pdu> crc_packet(uint8_t* buffer, const size_t* splits, size_t count)
+{
+    auto pdu = std::make_unique<ccsds::spp::pdu>();
+    memcpy(&(*pdu)->header, buffer, sizeof(ccsds::spp::primary_header));
+    size_t offset = sizeof(ccsds::spp::primary_header);
+    for(size_t i = 0; i < count; ++i){
+        pdu->extend(std::make_unique<ccsds::buffered_du>(buffer + offset, splits[i] - offset));
+        offset = splits[i];
+    }
+    return pdu;
+}
+
+/**
+ * Test only the DUs holding the packet error control field are replaced.
+ */
+TEST(CrcTestGroup, TrimTest)
+{
+    crc_test_service network;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &network);
+    service.set_error_control(true);
+    service.set_indication(crc_indication);
+    crc_received = 0;
+
+    uint8_t payload[20];
+    crc_fill(payload, sizeof(payload));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(std::make_unique<ccsds::buffered_du>(payload, sizeof(payload)), false, ccsds::spp::TELEMETRY)));
+    uint8_t buffer[28];
+    ccsds::segment segs[8];
+    size_t count = network.packets[0]->gather(segs, 8);
+    size_t len = 0;
+    for(size_t i = 0; i < count; ++i){
+        memcpy(buffer + len, segs[i].base, segs[i].len);
+        len += segs[i].len;
+    }
+
+    // The field at the end of the only DU
+    const size_t one[] = {28};
+    service.reception(crc_packet(buffer, one, 1));
+    CHECK_EQUAL(20, crc_length);
+    CHECK_EQUAL(1, crc_nodes);
+    POINTERS_EQUAL(buffer + 6, crc_first);
+    MEMCMP_EQUAL(payload, crc_data, 20);
+
+    // The field in a DU of its own
+    const size_t own[] = {10, 26, 28};
+    service.reception(crc_packet(buffer, own, 3));
+    CHECK_EQUAL(20, crc_length);
+    CHECK_EQUAL(2, crc_nodes);
+    POINTERS_EQUAL(buffer + 6, crc_first);
+    MEMCMP_EQUAL(payload, crc_data, 20);
+
+    // The field split over two DUs
+    const size_t split[] = {10, 27, 28};
+    service.reception(crc_packet(buffer, split, 3));
+    CHECK_EQUAL(20, crc_length);
+    CHECK_EQUAL(2, crc_nodes);
+    POINTERS_EQUAL(buffer + 6, crc_first);
+    MEMCMP_EQUAL(payload, crc_data, 20);
+    CHECK_EQUAL(3, crc_received);
+
+    // User data of a single octet
+    network.packets.clear();
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(std::make_unique<ccsds::buffered_du>(payload, 1), false, ccsds::spp::TELEMETRY)));
+    count = network.packets[0]->gather(segs, 8);
+    len = 0;
+    for(size_t i = 0; i < count; ++i){
+        memcpy(buffer + len, segs[i].base, segs[i].len);
+        len += segs[i].len;
+    }
+    const size_t tiny[] = {7, 9};
+    service.reception(crc_packet(buffer, tiny, 2));
+    CHECK_EQUAL(4, crc_received);
+    CHECK_EQUAL(1, crc_length);
+    CHECK_EQUAL(1, crc_nodes);
+    CHECK_EQUAL(payload[0], crc_data[0]);
+}
+
+/**
+ * Test segments each carry a packet error control field.
+ */
+TEST(CrcTestGroup, SegmentTest)
+{
+    crc_test_service network;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &network);
+    service.set_error_control(true);
+
+    uint8_t payload[20];
+    crc_fill(payload, sizeof(payload));
+    ccsds::error e = service.request_segmented(std::make_unique<ccsds::buffered_du>(payload, sizeof(payload)), false, ccsds::spp::TELEMETRY, 2);
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(e));
+
+    e = service.request_segmented(std::make_unique<ccsds::buffered_du>(payload, sizeof(payload)), false, ccsds::spp::TELEMETRY, 10);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    CHECK_EQUAL(3, network.packets.size());
+    for(const auto& packet : network.packets){
+        CHECK(packet->totalSize() <= 6 + 10);
+        CHECK_EQUAL(0, ccsds::crc16(*packet));
+    }
+}
+
+/** @} */ // group unittest
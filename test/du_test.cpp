@@ -0,0 +1,193 @@
+/**
+ * @file test/du_test.cpp
+ */
+
+#include "ccsds/common.h"
+#include "CppUTest/TestHarness.h"
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Data unit test group.
+ */
+TEST_GROUP(DataUnitTestGroup)
+{
+};
+
+/**
+ * Test exporting a DU chain as segments.
+ */
+TEST(DataUnitTestGroup, GatherTest)
+{
+    uint8_t a[] = {0, 1, 2};
+    uint8_t b[] = {3, 4};
+    uint8_t c[] = {5, 6, 7, 8};
+    std::unique_ptr<ccsds::buffered_du> du = std::make_unique<ccsds::buffered_du>(a, sizeof(a));
+    std::unique_ptr<ccsds::buffered_du> du2 = std::make_unique<ccsds::buffered_du>(b, sizeof(b));
+    std::unique_ptr<ccsds::buffered_du> du3 = std::make_unique<ccsds::buffered_du>(c, 0);
+    std::unique_ptr<ccsds::buffered_du> du4 = std::make_unique<ccsds::buffered_du>(c, sizeof(c));
+    du3->append(std::move(du4));
+    du2->append(std::move(du3));
+    du->append(std::move(du2));
+
+    ccsds::segment segments[4];
+    CHECK_EQUAL(3, du->gather(segments, 4));
+    POINTERS_EQUAL(a, segments[0].base);
+    CHECK_EQUAL(sizeof(a), segments[0].len);
+    POINTERS_EQUAL(b, segments[1].base);
+    CHECK_EQUAL(sizeof(b), segments[1].len);
+    POINTERS_EQUAL(c, segments[2].base);
+    CHECK_EQUAL(sizeof(c), segments[2].len);
+
+    // Segments are only filled up to the given count
+    segments[1].base = nullptr;
+    CHECK_EQUAL(3, du->gather(segments, 1));
+    POINTERS_EQUAL(a, segments[0].base);
+    POINTERS_EQUAL(nullptr, segments[1].base);
+}
+
+/**
+ * Test the size of a DU chain as it is built and taken apart.
+ */
+TEST(DataUnitTestGroup, ChainSizeTest)
+{
+    uint8_t a[] = {0, 1, 2};
+    uint8_t b[] = {3, 4};
+    std::unique_ptr<ccsds::buffered_du> du = std::make_unique<ccsds::buffered_du>(a, sizeof(a));
+    CHECK_EQUAL(1, du->length());
+    CHECK_EQUAL(3, du->totalSize());
+
+    std::unique_ptr<ccsds::buffered_du> du2 = std::make_unique<ccsds::buffered_du>(b, sizeof(b));
+    du2->append(std::make_unique<ccsds::buffered_du>(a, sizeof(a)));
+    du->append(std::move(du2));
+    CHECK_EQUAL(3, du->length());
+    CHECK_EQUAL(8, du->totalSize());
+    CHECK_EQUAL(2, du->next().length());
+    CHECK_EQUAL(5, du->next().totalSize());
+
+    std::unique_ptr<const ccsds::base_du> tail = du->pop();
+    CHECK_EQUAL(1, du->length());
+    CHECK_EQUAL(3, du->totalSize());
+    CHECK_EQUAL(2, tail->length());
+    CHECK_EQUAL(5, tail->totalSize());
+
+    // Appending replaces the previous chain
+    du->append(std::move(tail));
+    du->append(std::make_unique<ccsds::buffered_du>(b, sizeof(b)));
+    CHECK_EQUAL(2, du->length());
+    CHECK_EQUAL(5, du->totalSize());
+    du->append(nullptr);
+    CHECK_EQUAL(1, du->length());
+    CHECK_EQUAL(3, du->totalSize());
+}
+
+/**
+ * Test a very long DU chain.
+ */
+TEST(DataUnitTestGroup, LongChainTest)
+{
+    uint8_t a[] = {0, 1, 2, 3};
+    const size_t count = 1000000;
+    std::unique_ptr<const ccsds::base_du> chain;
+    for(size_t i = 0; i < count; ++i){
+        std::unique_ptr<ccsds::buffered_du> du = std::make_unique<ccsds::buffered_du>(a, sizeof(a));
+        if(chain){
+            du->append(std::move(chain));
+        }
+        chain = std::move(du);
+    }
+    CHECK_EQUAL(count, chain->length());
+    CHECK_EQUAL(count * sizeof(a), chain->totalSize());
+
+    // Destroying the chain does not recurse
+    chain.reset();
+}
+
+/**
+ * Test building a DU chain front to back.
+ */
+TEST(DataUnitTestGroup, BuildTest)
+{
+    uint8_t a[] = {0, 1, 2};
+    uint8_t b[] = {3, 4};
+    ccsds::du_chain chain;
+    CHECK(chain.empty());
+    CHECK(chain.take() == nullptr);
+
+    // Chains of const DUs are linked as well
+    std::unique_ptr<ccsds::buffered_du> pair = std::make_unique<ccsds::buffered_du>(b, sizeof(b));
+    pair->append(std::make_unique<const ccsds::buffered_du>(a, sizeof(a)));
+    chain.append(std::make_unique<const ccsds::buffered_du>(a, sizeof(a)));
+    chain.append(std::move(pair));
+    chain.append(nullptr);
+    chain.append(std::make_unique<ccsds::buffered_du>(b, 0));
+    CHECK_FALSE(chain.empty());
+    CHECK_EQUAL(8, chain.size());
+
+    std::unique_ptr<const ccsds::base_du> du = chain.take();
+    CHECK(chain.empty());
+    CHECK_EQUAL(4, du->length());
+    CHECK_EQUAL(8, du->totalSize());
+    CHECK_EQUAL(3, du->next().length());
+    CHECK_EQUAL(5, du->next().totalSize());
+    CHECK_EQUAL(1, du->next().next().next().length());
+    CHECK_EQUAL(0, du->next().next().next().totalSize());
+
+    // Extending walks through the const DUs
+    std::unique_ptr<ccsds::buffered_du> head = std::make_unique<ccsds::buffered_du>(b, sizeof(b));
+    head->append(std::move(du));
+    head->extend(std::make_unique<ccsds::buffered_du>(a, sizeof(a)));
+    CHECK_EQUAL(6, head->length());
+    CHECK_EQUAL(13, head->totalSize());
+    CHECK_EQUAL(8, head->next().next().totalSize());
+
+    // A long chain is built without walking it for every DU
+    const size_t count = 1000000;
+    for(size_t i = 0; i < count; ++i){
+        chain.append(std::make_unique<ccsds::buffered_du>(a, sizeof(a)));
+    }
+    du = chain.take();
+    CHECK_EQUAL(count, du->length());
+    CHECK_EQUAL(count * sizeof(a), du->totalSize());
+    CHECK_EQUAL(count - 1, du->next().length());
+
+    chain.append(std::move(du));
+    chain.clear();
+    CHECK(chain.empty());
+    CHECK_EQUAL(0, chain.size());
+}
+
+/**
+ * Test owned DUs store small buffers inline.
+ */
+TEST(DataUnitTestGroup, OwnedTest)
+{
+    uint8_t data[32];
+    for(size_t i = 0; i < sizeof(data); ++i){
+        data[i] = static_cast<uint8_t>(i);
+    }
+
+    ccsds::owned_du<16> small(data, 16);
+    CHECK(small.inlined());
+    CHECK_EQUAL(16, small.size());
+    CHECK(small.get() != data);
+    MEMCMP_EQUAL(data, small.get(), 16);
+
+    ccsds::owned_du<16> large(data, sizeof(data));
+    CHECK_FALSE(large.inlined());
+    CHECK_EQUAL(sizeof(data), large.totalSize());
+    MEMCMP_EQUAL(data, large.get(), sizeof(data));
+
+    ccsds::owned_du<16> empty(0);
+    CHECK(empty.inlined());
+    CHECK_EQUAL(0, empty.size());
+
+    auto filled = std::make_unique<ccsds::owned_du<8>>(4);
+    filled->data()[3] = 0xA5;
+    CHECK_EQUAL(0xA5, static_cast<const uint8_t*>(filled->get())[3]);
+}
+
+/** @} */ // group unittest
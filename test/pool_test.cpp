@@ -0,0 +1,154 @@
+/**
+ * @file test/pool_test.cpp
+ */
+
+#include "ccsds/pool.h"
+#include "ccsds/spp.h"
+#include "CppUTest/TestHarness.h"
+#include <thread>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * DU pool test group.
+ */
+TEST_GROUP(PoolTestGroup)
+{
+    void teardown()
+    {
+        ccsds::base_du::set_allocator(nullptr);
+    }
+};
+
+/**
+ * CCSDS service holding the last transferred DU for pool tests.
+ */
+class pool_test_service : public ccsds::base_service {
+    public:
+        pool_test_service() = default;
+        virtual ~pool_test_service() = default;
+
+        std::unique_ptr<const ccsds::base_du> last; ///< Last transferred DU.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override
+        {
+            last.swap(sdu);
+            return ccsds::error();
+        }
+};
+
+/**
+ * Test allocating and releasing blocks.
+ */
+TEST(PoolTestGroup, AllocateTest)
+{
+    static ccsds::du_pool<32, 4> pool;
+    void* blocks[4];
+    for(auto& b : blocks){
+        b = pool.allocate(32);
+        CHECK(b != nullptr);
+        CHECK(pool.owns(b));
+    }
+    POINTERS_EQUAL(nullptr, pool.allocate(32));
+    POINTERS_EQUAL(nullptr, pool.allocate(128));
+
+    int other;
+    CHECK_FALSE(pool.deallocate(&other, sizeof(other)));
+
+    CHECK(pool.deallocate(blocks[2], 32));
+    POINTERS_EQUAL(blocks[2], pool.allocate(16));
+    for(auto& b : blocks){
+        CHECK(pool.deallocate(b, 32));
+    }
+}
+
+/**
+ * Test the packet header is allocated from the pool during assembly.
+ */
+TEST(PoolTestGroup, AssemblyTest)
+{
+    static ccsds::du_pool<64, 8> pool;
+    ccsds::base_du::set_allocator(&pool);
+
+    pool_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+
+    uint8_t data[] = {0, 1, 2, 3};
+    for(int i = 0; i < 16; ++i){
+        ccsds::error e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+        CHECK(pool.owns(test.last.get()));
+        CHECK(pool.owns(&test.last->next()));
+    }
+    test.last.reset();
+
+    // Exhausting the pool falls back to the heap
+    std::vector<std::unique_ptr<ccsds::buffered_du>> held;
+    for(int i = 0; i < 9; ++i){
+        held.push_back(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)));
+    }
+    CHECK_FALSE(pool.owns(held.back().get()));
+}
+
+/**
+ * Test the buffers of large owned DUs are allocated from the pool.
+ */
+TEST(PoolTestGroup, OwnedTest)
+{
+    static ccsds::du_pool<256, 4> pool;
+    ccsds::base_du::set_allocator(&pool);
+
+    uint8_t data[200] = {};
+    auto du = std::make_unique<ccsds::owned_du<16>>(data, sizeof(data));
+    CHECK(pool.owns(du.get()));
+    CHECK(pool.owns(du->get()));
+
+    // Buffers too large for the pool fall back to the heap
+    auto huge = std::make_unique<ccsds::owned_du<16>>(1024);
+    CHECK(pool.owns(huge.get()));
+    CHECK_FALSE(pool.owns(huge->get()));
+}
+
+/**
+ * Test concurrent use of the pool.
+ */
+TEST(PoolTestGroup, ConcurrentTest)
+{
+    static ccsds::du_pool<32, 64> pool;
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t){
+        threads.emplace_back([]{
+            for(int i = 0; i < 10000; ++i){
+                void* a = pool.allocate(32);
+                void* b = pool.allocate(32);
+                if(a != nullptr){
+                    pool.deallocate(a, 32);
+                }
+                if(b != nullptr){
+                    pool.deallocate(b, 32);
+                }
+            }
+        });
+    }
+    for(auto& t : threads){
+        t.join();
+    }
+
+    // Every block is back in the pool exactly once
+    void* blocks[64];
+    for(auto& b : blocks){
+        b = pool.allocate(32);
+        CHECK(b != nullptr);
+    }
+    POINTERS_EQUAL(nullptr, pool.allocate(32));
+    for(auto& b : blocks){
+        pool.deallocate(b, 32);
+    }
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,288 @@
+/**
+ * @file test/queue_test.cpp
+ */
+
+#include "ccsds/queue.h"
+#include "ccsds/spp.h"
+#include "CppUTest/TestHarness.h"
+#include <chrono>
+#include <ctime>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * DU queue test group.
+ */
+TEST_GROUP(QueueTestGroup)
+{
+};
+
+/**
+ * CCSDS service counting transferred DUs for queue tests.
+ */
+class queue_test_service : public ccsds::base_service {
+    public:
+        queue_test_service() :
+            count(0),
+            bytes(0)
+        {}
+        virtual ~queue_test_service() = default;
+
+        std::atomic<size_t> count; ///< Number of transferred DUs.
+        std::atomic<size_t> bytes; ///< Number of transferred bytes.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override
+        {
+            count.fetch_add(1);
+            bytes.fetch_add(du->totalSize());
+            return ccsds::error();
+        }
+};
+
+/**
+ * Test the single producer ring.
+ */
+TEST(QueueTestGroup, SpscRingTest)
+{
+    ccsds::spsc_ring<int, 4> ring;
+    int v;
+    CHECK_FALSE(ring.pop(v));
+    for(int i = 0; i < 4; ++i){
+        v = i;
+        CHECK(ring.push(v));
+    }
+    v = 4;
+    CHECK_FALSE(ring.push(v));
+    CHECK_EQUAL(4, ring.size());
+
+    for(int i = 0; i < 4; ++i){
+        CHECK(ring.pop(v));
+        CHECK_EQUAL(i, v);
+    }
+    CHECK_FALSE(ring.pop(v));
+}
+
+/**
+ * Test the multiple producer ring with concurrent producers.
+ */
+TEST(QueueTestGroup, MpscRingTest)
+{
+    static ccsds::mpsc_ring<int, 64> ring;
+    const int producers = 4;
+    const int per_producer = 10000;
+
+    std::vector<std::thread> threads;
+    for(int p = 0; p < producers; ++p){
+        threads.emplace_back([p]{
+            for(int i = 0; i < per_producer; ++i){
+                int v = (p << 16) | i;
+                while(!ring.push(v)){
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // Elements from each producer arrive in order
+    int next[producers] = {};
+    int received = 0;
+    while(received < producers * per_producer){
+        int v;
+        if(ring.pop(v)){
+            CHECK_EQUAL(next[v >> 16], v & 0xFFFF);
+            ++next[v >> 16];
+            ++received;
+        }
+    }
+    for(auto& t : threads){
+        t.join();
+    }
+    CHECK_EQUAL(0, ring.size());
+}
+
+/**
+ * Test queueing packets from several producer threads.
+ */
+TEST(QueueTestGroup, QueueServiceTest)
+{
+    queue_test_service test;
+    ccsds::mpsc_queue_service<256> queue(&test);
+    ccsds::spp::octet_service a(static_cast<ccsds::spp::apid>(0x100), &queue);
+    ccsds::spp::octet_service b(static_cast<ccsds::spp::apid>(0x101), &queue);
+    queue.start();
+
+    static uint8_t data[] = {0, 1, 2, 3};
+    auto producer = [](ccsds::spp::octet_service* service){
+        for(int i = 0; i < 1000; ++i){
+            while(service->request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY)){
+                std::this_thread::yield();
+            }
+        }
+    };
+    std::thread ta(producer, &a);
+    std::thread tb(producer, &b);
+    ta.join();
+    tb.join();
+    queue.stop();
+
+    CHECK_EQUAL(2000, test.count.load());
+    CHECK_EQUAL(2000 * 10, test.bytes.load());
+    CHECK_EQUAL(0, queue.size());
+    CHECK_EQUAL(0, queue.errors());
+}
+
+/**
+ * Wait for a counter to reach a value.
+ * @param counter Counter to wait for.
+ * @param value Value to reach.
+ * @return true if the value was reached within a second.
+ */
+static bool queue_wait(const std::atomic<size_t>& counter, size_t value)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+    while(counter.load() < value){
+        if(std::chrono::steady_clock::now() > deadline){
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+/**
+ * Test the idle drain thread sleeps and is woken by transfers.
+ */
+TEST(QueueTestGroup, QueueIdleTest)
+{
+    queue_test_service test;
+    ccsds::spsc_queue_service<16> queue(&test);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x100), &queue);
+    queue.start();
+
+    // An idle drain thread uses next to no CPU time
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::clock_t before = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::clock_t used = std::clock() - before;
+    CHECK(used < CLOCKS_PER_SEC / 20);
+
+    // Transfers wake it, whether it spins or sleeps
+    uint8_t data[] = {0, 1, 2, 3};
+    for(size_t i = 1; i <= 200; ++i){
+        ccsds::error e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+        CHECK(queue_wait(test.count, i));
+        if((i % 20) == 0){
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    queue.stop();
+    CHECK_EQUAL(200, test.count.load());
+}
+
+/**
+ * Test a full queue rejects transfers.
+ */
+TEST(QueueTestGroup, QueueFullTest)
+{
+    queue_test_service test;
+    ccsds::spsc_queue_service<2> queue(&test);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x100), &queue);
+
+    uint8_t data[] = {0, 1, 2, 3};
+    for(int i = 0; i < 2; ++i){
+        ccsds::error e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    }
+    ccsds::error e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(e));
+
+    CHECK_EQUAL(1, queue.process(1));
+    CHECK_EQUAL(1, queue.process());
+    CHECK_EQUAL(2, test.count.load());
+}
+
+/**
+ * Completion callback counting results for queue tests.
+ * @param context Counters, indexed by error code.
+ * @param result Result of the transfer.
+ */
+static void queue_completion(void* context, ccsds::error result)
+{
+    static_cast<std::atomic<size_t>*>(context)[static_cast<int>(result)].fetch_add(1);
+}
+
+/**
+ * Test asynchronous transfers with credit.
+ */
+TEST(QueueTestGroup, AsyncTest)
+{
+    queue_test_service test;
+    ccsds::spsc_queue_service<4> queue(&test);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x100), &queue);
+    std::atomic<size_t> results[ccsds::error::code::NO_SPACE + 1] = {};
+    ccsds::base_service::completion done(&queue_completion, results);
+
+    uint8_t data[] = {0, 1, 2, 3};
+    CHECK_EQUAL(4, service.credit());
+    while(service.credit() > 0){
+        ccsds::error e = service.request_async(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY, done);
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    }
+    ccsds::error e = service.request_async(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY, done);
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(e));
+    CHECK_EQUAL(0, results[ccsds::error::code::NONE].load());
+
+    // Completions are called once the subnetwork transferred the packets
+    CHECK_EQUAL(4, queue.process());
+    CHECK_EQUAL(4, results[ccsds::error::code::NONE].load());
+    CHECK_EQUAL(4, test.count.load());
+    CHECK_EQUAL(4, service.credit());
+
+    // Services without a queue complete synchronously
+    ccsds::spp::octet_service direct(static_cast<ccsds::spp::apid>(0x101), &test);
+    CHECK_EQUAL(SIZE_MAX, direct.credit());
+    e = direct.request_async(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY, done);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    CHECK_EQUAL(5, results[ccsds::error::code::NONE].load());
+
+    // Failures are reported to the completion
+    ccsds::spsc_queue_service<4> unconnected(nullptr);
+    ccsds::base_service& stage = unconnected;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(stage.transfer_async(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), done)));
+    unconnected.process();
+    CHECK_EQUAL(1, results[ccsds::error::code::NO_NETWORK].load());
+}
+
+/**
+ * Test a producer throttling on credit while the queue drains.
+ */
+TEST(QueueTestGroup, CreditTest)
+{
+    queue_test_service test;
+    ccsds::spsc_queue_service<8> queue(&test);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x100), &queue);
+    std::atomic<size_t> results[ccsds::error::code::NO_SPACE + 1] = {};
+    ccsds::base_service::completion done(&queue_completion, results);
+    queue.start();
+
+    uint8_t data[] = {0, 1, 2, 3};
+    for(int i = 0; i < 10000; ++i){
+        while(service.credit() == 0){
+            std::this_thread::yield();
+        }
+        ccsds::error e = service.request_async(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY, done);
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    }
+    queue.stop();
+
+    CHECK_EQUAL(10000, results[ccsds::error::code::NONE].load());
+    CHECK_EQUAL(10000, test.count.load());
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,194 @@
+/**
+ * @file test/socket_test.cpp
+ */
+
+#include "ccsds/socket.h"
+#include "ccsds/spp.h"
+#include "CppUTest/TestHarness.h"
+#include <atomic>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Socket subnetwork test group.
+ */
+TEST_GROUP(SocketTestGroup)
+{
+    int fds[2];
+
+    void teardown()
+    {
+        close(fds[0]);
+        close(fds[1]);
+    }
+};
+
+/**
+ * Test sending space packets on a stream socket.
+ */
+TEST(SocketTestGroup, StreamTest)
+{
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ccsds::socket_service sock(fds[0]);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &sock);
+
+    uint8_t data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    for(int i = 0; i < 2; ++i){
+        ccsds::error e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELECOMMAND);
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    }
+
+    uint8_t buf[64];
+    CHECK_EQUAL(32, read(fds[1], buf, sizeof(buf)));
+    const uint8_t header[] = {0x11, 0xAB, 0xC0, 0x00, 0x00, 0x09};
+    MEMCMP_EQUAL(header, buf, sizeof(header));
+    MEMCMP_EQUAL(data, &buf[6], sizeof(data));
+    CHECK_EQUAL(0x01, buf[19]);
+    MEMCMP_EQUAL(data, &buf[22], sizeof(data));
+
+    // Chains longer than the segment limit are written in several calls
+    uint8_t bytes[ccsds::socket_service::MAX_SEGMENTS * 2];
+    std::unique_ptr<const ccsds::base_du> chain;
+    for(size_t i = sizeof(bytes); i > 0; --i){
+        bytes[i - 1] = i - 1;
+        std::unique_ptr<ccsds::buffered_du> du = std::make_unique<ccsds::buffered_du>(&bytes[i - 1], 1);
+        if(chain){
+            du->append(std::move(chain));
+        }
+        chain = std::move(du);
+    }
+    ccsds::base_service& subnetwork = sock;
+    ccsds::error e = subnetwork.transfer(std::move(chain));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+
+    uint8_t received[sizeof(bytes)];
+    CHECK_EQUAL(sizeof(received), read(fds[1], received, sizeof(received)));
+    MEMCMP_EQUAL(bytes, received, sizeof(bytes));
+}
+
+/**
+ * Test sending a batch of space packets on a stream socket.
+ */
+TEST(SocketTestGroup, StreamBatchTest)
+{
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    ccsds::socket_service sock(fds[0]);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &sock);
+
+    // More segments than fit in a single write
+    uint8_t data[] = {0, 1, 2, 3};
+    const size_t count = ccsds::socket_service::MAX_SEGMENTS;
+    std::unique_ptr<const ccsds::base_du> sdus[count];
+    for(auto& sdu : sdus){
+        sdu = std::make_unique<ccsds::buffered_du>(&data, sizeof(data));
+    }
+    ccsds::error e = service.request_batch(sdus, count, false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+
+    uint8_t buf[count * 10];
+    size_t received = 0;
+    while(received < sizeof(buf)){
+        ssize_t n = read(fds[1], &buf[received], sizeof(buf) - received);
+        CHECK(n > 0);
+        received += n;
+    }
+    for(size_t i = 0; i < count; ++i){
+        const uint8_t header[] = {0x01, 0xAB, 0xC0, static_cast<uint8_t>(i), 0x00, 0x03};
+        MEMCMP_EQUAL(header, &buf[i * 10], sizeof(header));
+        MEMCMP_EQUAL(data, &buf[i * 10 + 6], sizeof(data));
+    }
+}
+
+/**
+ * Test sending on a full non-blocking stream socket.
+ */
+TEST(SocketTestGroup, NonBlockingTest)
+{
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    CHECK_EQUAL(0, fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK));
+    ccsds::socket_service sock(fds[0]);
+    ccsds::base_service& subnetwork = sock;
+
+    // Drain the socket once it has been filled
+    std::atomic<bool> full(false);
+    std::vector<uint8_t> received;
+    std::thread reader([&](){
+        while(!full){
+            std::this_thread::yield();
+        }
+        uint8_t buf[4096];
+        ssize_t n;
+        while((n = read(fds[1], buf, sizeof(buf))) > 0){
+            received.insert(received.end(), buf, buf + n);
+        }
+    });
+
+    // A full socket rejects a DU without writing any of it
+    uint8_t small[16] = {};
+    size_t sent = 0;
+    ccsds::error e;
+    while(!(e = subnetwork.transfer(std::make_unique<ccsds::buffered_du>(small, sizeof(small))))){
+        ++sent;
+    }
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(e));
+    full = true;
+
+    // Once part of a DU is written the rest follows it
+    std::vector<uint8_t> large(1 << 20);
+    for(size_t i = 0; i < large.size(); ++i){
+        large[i] = static_cast<uint8_t>(i * 7);
+    }
+    do{
+        e = subnetwork.transfer(std::make_unique<ccsds::buffered_du>(large.data(), large.size()));
+    }while(e == ccsds::error::code::NO_SPACE);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    shutdown(fds[0], SHUT_WR);
+    reader.join();
+
+    CHECK_EQUAL(sent * sizeof(small) + large.size(), received.size());
+    MEMCMP_EQUAL(large.data(), &received[sent * sizeof(small)], large.size());
+}
+
+/**
+ * Test sending a space packet on a datagram socket.
+ */
+TEST(SocketTestGroup, DatagramTest)
+{
+    CHECK_EQUAL(0, socketpair(AF_UNIX, SOCK_DGRAM, 0, fds));
+    ccsds::socket_service sock(fds[0]);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &sock);
+
+    uint8_t data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    ccsds::error e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+
+    uint8_t buf[64];
+    CHECK_EQUAL(16, recv(fds[1], buf, sizeof(buf), 0));
+    const uint8_t header[] = {0x01, 0xAB, 0xC0, 0x00, 0x00, 0x09};
+    MEMCMP_EQUAL(header, buf, sizeof(header));
+    MEMCMP_EQUAL(data, &buf[6], sizeof(data));
+}
+
+/**
+ * Test sending on an invalid socket.
+ */
+TEST(SocketTestGroup, InvalidTest)
+{
+    fds[0] = -1;
+    fds[1] = -1;
+    ccsds::socket_service sock(-1);
+    uint8_t data[] = {0, 1, 2, 3};
+    ccsds::base_service& subnetwork = sock;
+    ccsds::error e = subnetwork.transfer(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)));
+    CHECK_EQUAL(ccsds::error::code::NO_NETWORK, static_cast<int>(e));
+}
+
+/** @} */ // group unittest
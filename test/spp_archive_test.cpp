@@ -0,0 +1,306 @@
+/**
+ * @file test/spp_archive_test.cpp
+ */
+
+#include "ccsds/spp_archive.h"
+#include "CppUTest/TestHarness.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Space packet archive test group.
+ */
+TEST_GROUP(ArchiveTestGroup)
+{
+    void setup()
+    {
+        char name[] = "/tmp/ccsds_archive_XXXXXX";
+        int fd = mkstemp(name);
+        CHECK(fd >= 0);
+        close(fd);
+        path = name;
+    }
+
+    void teardown()
+    {
+        std::remove(path.c_str());
+        std::remove((path + ".idx").c_str());
+    }
+
+    /**
+     * Append packets to the archive.
+     * @param first Sequence count of the first packet.
+     * @param count Number of packets to append.
+     */
+    void append(uint16_t first, size_t count)
+    {
+        ccsds::spp::archive_writer writer;
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(writer.open(path)));
+        ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &writer);
+        for(size_t i = 0; i < count; ++i){
+            uint16_t n = first + i;
+            data[n][0] = n;
+            data[n][1] = 0xA5;
+            std::unique_ptr<ccsds::buffered_du> sdu = std::make_unique<ccsds::buffered_du>(&data[n][0], 1);
+            sdu->append(std::make_unique<ccsds::buffered_du>(&data[n][1], (n % 3) + 1));
+            CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(std::move(sdu), false, ccsds::spp::TELEMETRY)));
+        }
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(writer.sync()));
+    }
+
+    /**
+     * Check the packets in an archive.
+     * @param reader Open archive.
+     * @param count Expected number of packets.
+     */
+    void check(const ccsds::spp::archive_reader& reader, size_t count)
+    {
+        CHECK_EQUAL(count, reader.size());
+        for(size_t i = 0; i < count; ++i){
+            std::unique_ptr<const ccsds::base_du> view = reader.view(i);
+            CHECK_EQUAL(1, view->length());
+            CHECK_EQUAL(sizeof(ccsds::spp::primary_header) + (i % 3) + 2, view->size());
+            const uint8_t* bytes = static_cast<const uint8_t*>(view->get());
+            CHECK_EQUAL(0x01, bytes[0]);
+            CHECK_EQUAL(0xAB, bytes[1]);
+            CHECK_EQUAL(i, bytes[6]);
+
+            std::unique_ptr<ccsds::spp::pdu> pdu = reader.packet(i);
+            CHECK_EQUAL(view->size(), pdu->totalSize());
+            CHECK_EQUAL(ccsds::spp::identification(static_cast<ccsds::spp::apid>(0x1AB), ccsds::spp::TELEMETRY, false), (*pdu)->header.identification);
+            CHECK_EQUAL(0xA5, static_cast<const uint8_t*>(pdu->next().get())[1]);
+        }
+        CHECK(reader.view(count) == nullptr);
+        CHECK(reader.packet(count) == nullptr);
+    }
+
+    std::string path;     ///< Path to the archive.
+    uint8_t data[16][4]; ///< User data of the archived packets.
+};
+
+/**
+ * Test writing and reading an archive.
+ */
+TEST(ArchiveTestGroup, ReadWriteTest)
+{
+    append(0, 5);
+
+    ccsds::spp::archive_reader reader;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+
+    // Views keep the archive mapped
+    std::unique_ptr<const ccsds::base_du> view = reader.view(4);
+    reader.close();
+    CHECK_EQUAL(0, reader.size());
+    CHECK_EQUAL(4, static_cast<const uint8_t*>(view->get())[6]);
+}
+
+/**
+ * Test the index file is reused and extended.
+ */
+TEST(ArchiveTestGroup, IndexTest)
+{
+    append(0, 5);
+    ccsds::spp::archive_reader reader;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    struct stat st;
+    CHECK_EQUAL(0, stat((path + ".idx").c_str(), &st));
+    CHECK_EQUAL(56 + (5 * 8), st.st_size);
+
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+
+    append(5, 3);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 8);
+    CHECK_EQUAL(0, stat((path + ".idx").c_str(), &st));
+    CHECK_EQUAL(56 + (8 * 8), st.st_size);
+
+    // An index not matching the archive is rebuilt
+    CHECK_EQUAL(0, truncate(path.c_str(), 0));
+    append(0, 2);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 2);
+}
+
+/**
+ * Overwrite part of a file.
+ * @param path Path to the file.
+ * @param offset Offset to write at in bytes.
+ * @param buf Bytes to write.
+ * @param len Length of buf in bytes.
+ */
+static void archive_patch(const std::string& path, size_t offset, const void* buf, size_t len)
+{
+    FILE* f = std::fopen(path.c_str(), "r+b");
+    CHECK(f != nullptr);
+    CHECK_EQUAL(0, std::fseek(f, offset, SEEK_SET));
+    CHECK_EQUAL(1, std::fwrite(buf, len, 1, f));
+    CHECK_EQUAL(0, std::fclose(f));
+}
+
+/**
+ * Overwrite a 64 bit word of the index file.
+ * @param path Path to the archive.
+ * @param word Index of the word, the header is words 0 to 6.
+ * @param value Value to write.
+ */
+static void archive_patch(const std::string& path, size_t word, uint64_t value)
+{
+    archive_patch(path + ".idx", word * sizeof(value), &value, sizeof(value));
+}
+
+/**
+ * Set the modification time of a file.
+ * @param path Path to the file.
+ * @param mtime Modification time.
+ */
+static void archive_touch(const std::string& path, const struct timespec& mtime)
+{
+    struct timespec times[2] = {{0, UTIME_OMIT}, mtime};
+    CHECK_EQUAL(0, utimensat(AT_FDCWD, path.c_str(), times, 0));
+}
+
+/**
+ * Test inconsistent index files are rebuilt.
+ */
+TEST(ArchiveTestGroup, CorruptIndexTest)
+{
+    append(0, 5);
+    ccsds::spp::archive_reader reader;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    reader.close();
+    const uint64_t first = 0;
+    const uint64_t second = sizeof(ccsds::spp::primary_header) + 2;
+
+    // A count whose size in bytes overflows to the length of the entries
+    archive_patch(path, 2, (UINT64_C(1) << 61) + 5);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+    reader.close();
+
+    // Offsets out of order
+    archive_patch(path, 7, second);
+    archive_patch(path, 8, first);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+    reader.close();
+
+    // An offset beyond the covered bytes
+    archive_patch(path, 11, UINT64_C(1) << 40);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+    reader.close();
+
+    // Offsets closer than the smallest packet
+    archive_patch(path, 9, second + 3);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+    reader.close();
+
+    // The index of another archive, with an offset that would otherwise
+    // be trusted
+    archive_patch(path, 8, second + 1);
+    archive_patch(path, 6, 0);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+    reader.close();
+
+    // An archive rewritten in place since the index was written
+    archive_patch(path, 8, second + 1);
+    struct timespec mtime = {1, 0};
+    archive_touch(path, mtime);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+
+    // The rebuilt index is valid again
+    struct stat st;
+    CHECK_EQUAL(0, stat((path + ".idx").c_str(), &st));
+    CHECK_EQUAL(56 + (5 * 8), st.st_size);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 5);
+}
+
+/**
+ * Test packets are bounds checked when viewed through a trusted index.
+ */
+TEST(ArchiveTestGroup, BoundsTest)
+{
+    append(0, 5);
+    ccsds::spp::archive_reader reader;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    reader.close();
+
+    // Corrupt the data length of the last packet without changing the
+    // identity of the archive
+    struct stat st;
+    CHECK_EQUAL(0, stat(path.c_str(), &st));
+    const uint8_t length[2] = {0xFF, 0xFF};
+    archive_patch(path, 35 + 4, length, sizeof(length));
+    archive_touch(path, st.st_mtim);
+
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    CHECK_EQUAL(5, reader.size());
+    CHECK(reader.view(3) != nullptr);
+    CHECK(reader.view(4) == nullptr);
+    CHECK(reader.packet(4) == nullptr);
+}
+
+/**
+ * Test an incomplete packet at the end of the archive is skipped.
+ */
+TEST(ArchiveTestGroup, TruncatedTest)
+{
+    append(0, 3);
+    struct stat st;
+    CHECK_EQUAL(0, stat(path.c_str(), &st));
+    CHECK_EQUAL(0, truncate(path.c_str(), st.st_size - 1));
+
+    ccsds::spp::archive_reader reader;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path, false)));
+    check(reader, 2);
+    CHECK(stat((path + ".idx").c_str(), &st) != 0);
+
+    CHECK_EQUAL(ccsds::error::code::IO_ERROR, static_cast<int>(reader.open(path + ".missing")));
+    CHECK_EQUAL(0, reader.size());
+}
+
+/**
+ * Test appending a batch of packets.
+ */
+TEST(ArchiveTestGroup, BatchTest)
+{
+    ccsds::spp::archive_writer writer;
+    ccsds::base_service& subnetwork = writer;
+    std::unique_ptr<const ccsds::base_du> dus[1];
+    dus[0] = std::make_unique<ccsds::buffered_du>(&data[0][0], 1);
+    CHECK_EQUAL(ccsds::error::code::NO_NETWORK, static_cast<int>(subnetwork.transfer_batch(dus, 1)));
+
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(writer.open(path)));
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &writer);
+    std::unique_ptr<const ccsds::base_du> sdus[6];
+    for(size_t i = 0; i < 6; ++i){
+        data[i][0] = i;
+        data[i][1] = 0xA5;
+        sdus[i] = std::make_unique<ccsds::buffered_du>(&data[i][0], (i % 3) + 2);
+    }
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request_batch(sdus, 6, false, ccsds::spp::TELEMETRY)));
+    for(size_t i = 0; i < 6; ++i){
+        CHECK(sdus[i] == nullptr);
+    }
+    writer.close();
+
+    ccsds::spp::archive_reader reader;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path)));
+    check(reader, 6);
+}
+
+/** @} */ // group unittest
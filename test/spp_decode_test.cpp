@@ -0,0 +1,160 @@
+/**
+ * @file test/spp_decode_test.cpp
+ */
+
+#include "ccsds/spp_decode.h"
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Number of headers in decoding tests, covering every kernel block size.
+ */
+static constexpr size_t DECODE_COUNT = 16 + 8 + 3;
+
+/**
+ * Decoded header fields for unit tests.
+ */
+struct decode_test_fields {
+    uint16_t apid[DECODE_COUNT];      ///< APID.
+    uint8_t  type[DECODE_COUNT];      ///< Packet type.
+    uint8_t  secondary[DECODE_COUNT]; ///< Secondary header flag.
+    uint8_t  flags[DECODE_COUNT];     ///< Sequence flags.
+    uint16_t count[DECODE_COUNT];     ///< Packet sequence count.
+    uint32_t length[DECODE_COUNT];    ///< Packet data field length.
+
+    /**
+     * Get the field arrays.
+     * @return Field arrays.
+     */
+    ccsds::spp::header_fields fields()
+    {
+        return {apid, type, secondary, flags, count, length};
+    }
+};
+
+/**
+ * Bulk header decoding test group.
+ */
+TEST_GROUP(DecodeTestGroup)
+{
+    void setup()
+    {
+        for(size_t i = 0; i < DECODE_COUNT; ++i){
+            headers[i].identification = ccsds::spp::identification(static_cast<ccsds::spp::apid>(0x700 + i),
+                    static_cast<ccsds::spp::packet_type>(i & 1), (i & 2) != 0);
+            headers[i].sequence_control = ccsds::spp::sequence_control(i & 3, 0x3FF0 + i);
+            headers[i].data_length = ccsds::htons(i * 3);
+        }
+    }
+
+    /**
+     * Check decoded fields against the test headers.
+     * @param fields Decoded fields.
+     * @param count Number of headers to check.
+     */
+    void check(const decode_test_fields& fields, size_t count)
+    {
+        for(size_t i = 0; i < count; ++i){
+            CHECK_EQUAL(0x700 + i, fields.apid[i]);
+            CHECK_EQUAL(i & 1, fields.type[i]);
+            CHECK_EQUAL((i & 2) != 0, fields.secondary[i]);
+            CHECK_EQUAL(i & 3, fields.flags[i]);
+            CHECK_EQUAL((0x3FF0 + i) & ccsds::spp::SEQUENCE_COUNT_MASK, fields.count[i]);
+            CHECK_EQUAL((i * 3) + 1, fields.length[i]);
+        }
+    }
+
+    ccsds::spp::primary_header headers[DECODE_COUNT]; ///< Test headers.
+};
+
+/**
+ * Test decoding an array of headers.
+ */
+TEST(DecodeTestGroup, HeadersTest)
+{
+    decode_test_fields fields;
+    CHECK_EQUAL(DECODE_COUNT, ccsds::spp::decode_headers(headers, DECODE_COUNT, fields.fields()));
+    check(fields, DECODE_COUNT);
+}
+
+/**
+ * Test decoding stops at an invalid version number in each block.
+ */
+TEST(DecodeTestGroup, VersionTest)
+{
+    const size_t invalid[] = {5, 19, 25};
+    for(size_t bad : invalid){
+        setup();
+        headers[bad].identification |= ccsds::htons(1 << ccsds::spp::PACKET_VERSION_SHIFT);
+        decode_test_fields fields;
+        CHECK_EQUAL(bad, ccsds::spp::decode_headers(headers, DECODE_COUNT, fields.fields()));
+        check(fields, bad);
+    }
+}
+
+/**
+ * Test decoding every number of headers, with the invalid header at
+ * every position, including the blocks overlapping at the end.
+ */
+TEST(DecodeTestGroup, CountTest)
+{
+    for(size_t count = 0; count <= DECODE_COUNT; ++count){
+        decode_test_fields fields;
+        CHECK_EQUAL(count, ccsds::spp::decode_headers(headers, count, fields.fields()));
+        check(fields, count);
+    }
+    for(size_t bad = 0; bad < DECODE_COUNT; ++bad){
+        setup();
+        headers[bad].data_length = ccsds::htons(1000);
+        decode_test_fields fields;
+        CHECK_EQUAL(bad, ccsds::spp::decode_headers(headers, DECODE_COUNT, fields.fields(), 100));
+        check(fields, bad);
+    }
+}
+
+/**
+ * Test decoding stops at a packet data field longer than the maximum.
+ */
+TEST(DecodeTestGroup, LengthTest)
+{
+    decode_test_fields fields;
+    CHECK_EQUAL(21, ccsds::spp::decode_headers(headers, DECODE_COUNT, fields.fields(), 61));
+    check(fields, 21);
+    CHECK_EQUAL(0, ccsds::spp::decode_headers(headers, DECODE_COUNT, fields.fields(), 0));
+}
+
+/**
+ * Test decoding packets held back to back in a buffer.
+ */
+TEST(DecodeTestGroup, StreamTest)
+{
+    std::vector<uint8_t> stream;
+    for(size_t i = 0; i < DECODE_COUNT; ++i){
+        const uint8_t* header = reinterpret_cast<const uint8_t*>(&headers[i]);
+        stream.insert(stream.end(), header, header + sizeof(headers[i]));
+        stream.resize(stream.size() + (i * 3) + 1, static_cast<uint8_t>(i));
+    }
+
+    // The last packet is incomplete
+    decode_test_fields fields;
+    size_t offsets[DECODE_COUNT];
+    size_t n = ccsds::spp::decode_stream(stream.data(), stream.size() - 1, offsets, DECODE_COUNT, fields.fields());
+    CHECK_EQUAL(DECODE_COUNT - 1, n);
+    check(fields, n);
+    for(size_t i = 0; i < n; ++i){
+        CHECK_EQUAL(0, std::memcmp(&stream[offsets[i]], &headers[i], sizeof(headers[i])));
+    }
+
+    n = ccsds::spp::decode_stream(stream.data(), stream.size(), offsets, DECODE_COUNT, fields.fields());
+    CHECK_EQUAL(DECODE_COUNT, n);
+    n = ccsds::spp::decode_stream(stream.data(), stream.size(), offsets, 4, fields.fields());
+    CHECK_EQUAL(4, n);
+}
+
+/** @} */ // group unittest
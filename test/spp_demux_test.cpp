@@ -0,0 +1,111 @@
+/**
+ * @file test/spp_demux_test.cpp
+ */
+
+#include "ccsds/spp_demux.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Space Packet demultiplexer test group.
+ */
+TEST_GROUP(SpacePacketDemuxTestGroup)
+{
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/**
+ * Build a received space packet.
+ * @param id APID of the packet.
+ * @param count Packet sequence count.
+ * @param data Packet data field.
+ * @param len Length of data in bytes.
+ * @return Space packet PDU.
+ */
+static std::unique_ptr<ccsds::spp::pdu> demux_packet(uint16_t id, uint16_t count, uint8_t* data, size_t len)
+{
+    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+    (*pdu)->header.identification = ccsds::htons(id);
+    (*pdu)->header.sequence_control = ccsds::htons(0xC000 | count);
+    (*pdu)->header.data_length = ccsds::htons(len - 1);
+    pdu->append(std::make_unique<ccsds::buffered_du>(data, len));
+    return pdu;
+}
+
+/**
+ * Test indication function for the first registered APID.
+ */
+static void demux_indication_a(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool data_loss)
+{
+    mock().actualCall("demux_indication_a");
+    CHECK_EQUAL(4, sdu->size());
+    CHECK_EQUAL(0x123, id);
+    CHECK_FALSE(data_loss);
+}
+
+/**
+ * Test indication function for the second registered APID.
+ */
+static void demux_indication_b(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool data_loss)
+{
+    mock().actualCall("demux_indication_b");
+    (void)sdu;
+    CHECK_EQUAL(0x7FE, id);
+    CHECK_FALSE(data_loss);
+}
+
+/**
+ * Test indication function for unregistered and idle APIDs.
+ */
+static void demux_indication_other(std::unique_ptr<const ccsds::spp::pdu> pdu, ccsds::spp::apid id)
+{
+    mock().actualCall("demux_indication_other");
+    CHECK(pdu != nullptr);
+    CHECK(id == 0x055 || id == 0x123 || id == ccsds::spp::APID_IDLE);
+}
+
+/**
+ * Test routing packets by APID.
+ */
+TEST(SpacePacketDemuxTestGroup, RoutingTest)
+{
+    ccsds::spp::demux_service demux;
+    ccsds::spp::octet_service a(static_cast<ccsds::spp::apid>(0x123), nullptr);
+    ccsds::spp::octet_service b(ccsds::spp::APID_MAX, nullptr);
+    a.set_indication(&demux_indication_a);
+    b.set_indication(&demux_indication_b);
+    demux.set_indication(&demux_indication_other);
+
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(demux.attach(static_cast<ccsds::spp::apid>(0x123), &a)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(demux.attach(ccsds::spp::APID_MAX, &b)));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(demux.attach(ccsds::spp::APID_IDLE, &a)));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(demux.attach(static_cast<ccsds::spp::apid>(0x055), &a)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(demux.attach(static_cast<ccsds::spp::apid>(0x055), nullptr)));
+
+    uint8_t data[] = {0, 1, 2, 3};
+    mock().expectNCalls(2, "demux_indication_a");
+    mock().expectOneCall("demux_indication_b");
+    mock().expectNCalls(2, "demux_indication_other");
+    demux.reception(demux_packet(0x1123, 0, data, sizeof(data)));
+    demux.reception(demux_packet(0x07FE, 0, data, sizeof(data)));
+    demux.reception(demux_packet(0x1055, 0, data, sizeof(data)));
+    demux.reception(demux_packet(0x07FF, 0, data, sizeof(data)));
+    demux.reception(demux_packet(0x1123, 1, data, sizeof(data)));
+    mock().checkExpectations();
+
+    // Unregistered APIDs go to the indication callback
+    demux.detach(static_cast<ccsds::spp::apid>(0x123));
+    mock().expectOneCall("demux_indication_other");
+    demux.reception(demux_packet(0x1123, 2, data, sizeof(data)));
+    mock().checkExpectations();
+}
+
+/** @} */ // group unittest
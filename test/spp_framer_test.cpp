@@ -0,0 +1,128 @@
+/**
+ * @file test/spp_framer_test.cpp
+ */
+
+#include "ccsds/spp_framer.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include <cstring>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Space Packet framer test group.
+ */
+TEST_GROUP(SpacePacketFramerTestGroup)
+{
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/**
+ * Stream of three space packets with 3, 1, and 5 byte data fields.
+ */
+static const uint8_t framer_stream[] = {
+    0x01, 0x23, 0xC0, 0x00, 0x00, 0x02, 0xA0, 0xA1, 0xA2,
+    0x01, 0x23, 0xC0, 0x01, 0x00, 0x00, 0xB0,
+    0x01, 0x23, 0xC0, 0x02, 0x00, 0x04, 0xC0, 0xC1, 0xC2, 0xC3, 0xC4,
+};
+
+static const uint8_t* framer_buffer; ///< Buffer currently given to the framer.
+static size_t         framer_offset; ///< Offset of the next expected packet in framer_stream.
+static size_t         framer_copies; ///< Number of packets not viewed in framer_buffer.
+
+/**
+ * Test indication function for framed packets.
+ */
+static void framer_indication(const ccsds::buffered_du& packet)
+{
+    mock().actualCall("framer_indication");
+    const uint8_t* bytes = static_cast<const uint8_t*>(packet.get());
+    if((bytes < framer_buffer) || (bytes >= framer_buffer + sizeof(framer_stream))){
+        ++framer_copies;
+    }
+    MEMCMP_EQUAL(&framer_stream[framer_offset], bytes, packet.size());
+    framer_offset += packet.size();
+}
+
+/**
+ * Test framing packets contained in a single buffer.
+ */
+TEST(SpacePacketFramerTestGroup, SingleBufferTest)
+{
+    ccsds::spp::packet_framer framer;
+    framer.set_indication(&framer_indication);
+
+    uint8_t buf[sizeof(framer_stream)];
+    std::memcpy(buf, framer_stream, sizeof(buf));
+    framer_buffer = buf;
+    framer_offset = 0;
+    framer_copies = 0;
+
+    mock().expectNCalls(3, "framer_indication");
+    framer.reception(buf, sizeof(buf));
+    mock().checkExpectations();
+    CHECK_EQUAL(sizeof(framer_stream), framer_offset);
+    CHECK_EQUAL(0, framer_copies);
+    CHECK_EQUAL(0, framer.pending());
+}
+
+/**
+ * Test framing packets split across buffers at every possible offset.
+ */
+TEST(SpacePacketFramerTestGroup, SplitBufferTest)
+{
+    for(size_t split = 1; split < sizeof(framer_stream); ++split){
+        ccsds::spp::packet_framer framer;
+        framer.set_indication(&framer_indication);
+
+        uint8_t buf[sizeof(framer_stream)];
+        std::memcpy(buf, framer_stream, sizeof(buf));
+        framer_buffer = buf;
+        framer_offset = 0;
+        framer_copies = 0;
+
+        mock().expectNCalls(3, "framer_indication");
+        framer.reception(buf, split);
+        framer.reception(&buf[split], sizeof(buf) - split);
+        mock().checkExpectations();
+        mock().clear();
+        CHECK_EQUAL(sizeof(framer_stream), framer_offset);
+        CHECK(framer_copies <= 1);
+        CHECK_EQUAL(0, framer.pending());
+    }
+}
+
+/**
+ * Test framing a stream delivered one byte at a time.
+ */
+TEST(SpacePacketFramerTestGroup, ByteStreamTest)
+{
+    ccsds::spp::packet_framer framer;
+    framer.set_indication(&framer_indication);
+
+    uint8_t buf[sizeof(framer_stream)];
+    std::memcpy(buf, framer_stream, sizeof(buf));
+    framer_buffer = buf;
+    framer_offset = 0;
+
+    mock().expectNCalls(3, "framer_indication");
+    for(size_t i = 0; i < sizeof(buf); ++i){
+        framer.reception(&buf[i], 1);
+    }
+    mock().checkExpectations();
+    CHECK_EQUAL(sizeof(framer_stream), framer_offset);
+
+    // A partial packet is held until reset
+    framer.reception(buf, 4);
+    CHECK_EQUAL(4, framer.pending());
+    framer.reset();
+    CHECK_EQUAL(0, framer.pending());
+}
+
+/** @} */ // group unittest
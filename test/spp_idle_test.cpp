@@ -0,0 +1,139 @@
+/**
+ * @file test/spp_idle_test.cpp
+ */
+
+#include "ccsds/spp_idle.h"
+#include "CppUTest/TestHarness.h"
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Idle packet test group.
+ */
+TEST_GROUP(IdleTestGroup)
+{
+};
+
+/**
+ * CCSDS service recording the size of transferred packets.
+ */
+class idle_test_service : public ccsds::base_service {
+    public:
+        idle_test_service() = default;
+        virtual ~idle_test_service() = default;
+
+        std::vector<size_t> sizes; ///< Sizes of transferred packets.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override
+        {
+            sizes.push_back(du->totalSize());
+            return ccsds::error();
+        }
+};
+
+/**
+ * Check a buffer holds idle packets back to back.
+ * @param buf Buffer to check.
+ * @param len Length of buf in bytes.
+ * @return Number of idle packets in buf.
+ */
+static size_t idle_check(const uint8_t* buf, size_t len)
+{
+    size_t packets = 0;
+    size_t offset = 0;
+    while(offset < len){
+        ccsds::spp::packet_view view(buf + offset, len - offset);
+        CHECK(view.valid());
+        CHECK_EQUAL(ccsds::spp::APID_IDLE, view.id());
+        CHECK_EQUAL(0xA5, view.data()[0]);
+        CHECK_EQUAL(0xA5, view.data()[view.data_length() - 1]);
+        offset += view.size();
+        ++packets;
+    }
+    CHECK_EQUAL(len, offset);
+    return packets;
+}
+
+/**
+ * Test idle packets share their idle data.
+ */
+TEST(IdleTestGroup, PacketTest)
+{
+    ccsds::spp::idle_service service(nullptr, 0xA5);
+    std::unique_ptr<const ccsds::spp::pdu> first = service.packet(7);
+    std::unique_ptr<const ccsds::spp::pdu> second = service.packet(ccsds::spp::idle_service::MAX_PACKET_SIZE);
+    CHECK(first != nullptr);
+    CHECK(second != nullptr);
+    CHECK_EQUAL(7, first->totalSize());
+    CHECK_EQUAL(ccsds::spp::idle_service::MAX_PACKET_SIZE, second->totalSize());
+
+    CHECK_EQUAL(ccsds::htons(ccsds::spp::APID_IDLE), (*first)->header.identification);
+    CHECK_EQUAL(0, ccsds::ntohs((*first)->header.data_length));
+    CHECK_EQUAL(1, ccsds::ntohs((*second)->header.sequence_control) & ccsds::spp::SEQUENCE_COUNT_MASK);
+    CHECK_EQUAL(0xA5, *static_cast<const uint8_t*>(first->next().get()));
+    POINTERS_EQUAL(first->next().get(), second->next().get());
+
+    CHECK(service.packet(6) == nullptr);
+    CHECK(service.packet(ccsds::spp::idle_service::MAX_PACKET_SIZE + 1) == nullptr);
+}
+
+/**
+ * Test idle packets keep the idle data alive after the service.
+ */
+TEST(IdleTestGroup, LifetimeTest)
+{
+    std::unique_ptr<const ccsds::spp::pdu> packet;
+    {
+        ccsds::spp::idle_service service(nullptr, 0x5A);
+        packet = service.packet(ccsds::spp::idle_service::MAX_PACKET_SIZE);
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(packet->next().get());
+    CHECK_EQUAL(0x5A, data[0]);
+    CHECK_EQUAL(0x5A, data[ccsds::spp::MAX_DATA_LENGTH - 1]);
+}
+
+/**
+ * Test sending idle packets.
+ */
+TEST(IdleTestGroup, RequestTest)
+{
+    idle_test_service subnetwork;
+    ccsds::spp::idle_service service(&subnetwork);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(100)));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(service.request(3)));
+    CHECK_EQUAL(1, subnetwork.sizes.size());
+    CHECK_EQUAL(100, subnetwork.sizes[0]);
+
+    ccsds::spp::idle_service unconnected(nullptr);
+    CHECK_EQUAL(ccsds::error::code::NO_NETWORK, static_cast<int>(unconnected.request(100)));
+}
+
+/**
+ * Test filling buffers with idle packets.
+ */
+TEST(IdleTestGroup, FillTest)
+{
+    ccsds::spp::idle_service service(nullptr, 0xA5);
+    std::vector<uint8_t> buffer(3 * ccsds::spp::idle_service::MAX_PACKET_SIZE);
+
+    CHECK_EQUAL(0, service.fill(buffer.data(), 6));
+    CHECK_EQUAL(7, service.fill(buffer.data(), 7));
+    CHECK_EQUAL(1, idle_check(buffer.data(), 7));
+    CHECK_EQUAL(1000, service.fill(buffer.data(), 1000));
+    CHECK_EQUAL(1, idle_check(buffer.data(), 1000));
+
+    // Large fills are split without leaving a remainder too short for a packet
+    size_t len = ccsds::spp::idle_service::MAX_PACKET_SIZE + 3;
+    CHECK_EQUAL(len, service.fill(buffer.data(), len));
+    CHECK_EQUAL(2, idle_check(buffer.data(), len));
+    len = buffer.size();
+    CHECK_EQUAL(len, service.fill(buffer.data(), len));
+    CHECK_EQUAL(3, idle_check(buffer.data(), len));
+}
+
+/** @} */ // group unittest
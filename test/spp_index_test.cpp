@@ -0,0 +1,153 @@
+/**
+ * @file test/spp_index_test.cpp
+ */
+
+#include "ccsds/spp_index.h"
+#include "CppUTest/TestHarness.h"
+#include <cstdio>
+#include <unistd.h>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+typedef ccsds::spp::secondary_field<0, ccsds::cuc<4, 2>> index_time; ///< Time code of indexed packets.
+
+/**
+ * Number of packets in the test archive.
+ */
+static constexpr size_t INDEX_PACKETS = 1000;
+
+/**
+ * Space packet archive index test group.
+ */
+TEST_GROUP(IndexTestGroup)
+{
+    void setup()
+    {
+        char name[] = "/tmp/ccsds_index_XXXXXX";
+        int fd = mkstemp(name);
+        CHECK(fd >= 0);
+        close(fd);
+        path = name;
+
+        // Packet i has APID 0x100 + i % 3 and a time of i seconds, every
+        // tenth packet of APID 0x102 has no secondary header
+        ccsds::spp::archive_writer writer;
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(writer.open(path)));
+        ccsds::spp::octet_service services[] = {
+            {static_cast<ccsds::spp::apid>(0x100), &writer},
+            {static_cast<ccsds::spp::apid>(0x101), &writer},
+            {static_cast<ccsds::spp::apid>(0x102), &writer},
+        };
+        for(uint32_t i = 0; i < INDEX_PACKETS; ++i){
+            uint8_t data[16] = {0};
+            index_time::encode(data, ccsds::timestamp{i, 0});
+            bool secondary = ((i % 3) != 2) || ((i % 10) != 2);
+            std::unique_ptr<ccsds::buffered_du> sdu = std::make_unique<ccsds::buffered_du>(&data, 6 + (i % 7));
+            CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(services[i % 3].request(std::move(sdu), secondary, ccsds::spp::TELEMETRY)));
+        }
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(writer.sync()));
+    }
+
+    void teardown()
+    {
+        std::remove(path.c_str());
+        std::remove((path + ".idx").c_str());
+    }
+
+    /**
+     * Check the result of a query.
+     * @param packets Packets found.
+     * @param id Expected APID of the packets.
+     * @param begin Time of the first packet expected, in seconds.
+     * @param end Time after the last packet expected, in seconds.
+     */
+    void check(const std::vector<std::unique_ptr<const ccsds::base_du>>& packets, uint16_t id, uint32_t begin, uint32_t end)
+    {
+        size_t n = 0;
+        for(uint32_t i = begin; i < end; ++i){
+            if(((i % 3) == (id - 0x100u)) && ((id != 0x102) || ((i % 10) != 2))){
+                CHECK(n < packets.size());
+                ccsds::spp::packet_view view(packets[n]->get(), packets[n]->size());
+                CHECK(view.valid());
+                CHECK_EQUAL(id, view.id());
+                CHECK_EQUAL(i, index_time::decode(view).seconds);
+                ++n;
+            }
+        }
+        CHECK_EQUAL(n, packets.size());
+    }
+
+    std::string path; ///< Path to the test archive.
+};
+
+/**
+ * Convert seconds to an index time.
+ * @param seconds Seconds to convert.
+ * @return Index time.
+ */
+static uint64_t index_ticks(uint32_t seconds)
+{
+    return ccsds::spp::archive_index::ticks(ccsds::timestamp{seconds, 0});
+}
+
+/**
+ * Test querying an archive by APID and time.
+ */
+TEST(IndexTestGroup, QueryTest)
+{
+    ccsds::spp::archive_reader reader;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path, false)));
+    ccsds::spp::archive_index index(&ccsds::spp::archive_index::secondary_time<index_time>);
+    CHECK_EQUAL(INDEX_PACKETS, index.build(reader));
+    reader.close();
+
+    CHECK_EQUAL(334, index.count(static_cast<ccsds::spp::apid>(0x100)));
+    CHECK_EQUAL(333, index.count(static_cast<ccsds::spp::apid>(0x102)));
+    CHECK_EQUAL(0, index.count(static_cast<ccsds::spp::apid>(0x103)));
+
+    // Views remain valid after the reader is closed
+    std::vector<std::unique_ptr<const ccsds::base_du>> packets;
+    CHECK_EQUAL(333, index.query(static_cast<ccsds::spp::apid>(0x101), packets));
+    check(packets, 0x101, 0, INDEX_PACKETS);
+
+    packets.clear();
+    index.query(static_cast<ccsds::spp::apid>(0x100), index_ticks(100), index_ticks(400), packets);
+    check(packets, 0x100, 100, 400);
+
+    packets.clear();
+    index.query(static_cast<ccsds::spp::apid>(0x102), index_ticks(0), index_ticks(1000), packets);
+    check(packets, 0x102, 0, 1000);
+
+    packets.clear();
+    CHECK_EQUAL(0, index.query(static_cast<ccsds::spp::apid>(0x101), index_ticks(5000), UINT64_MAX, packets));
+}
+
+/**
+ * Test building an index with several threads.
+ */
+TEST(IndexTestGroup, ParallelTest)
+{
+    ccsds::spp::archive_reader reader;
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(reader.open(path, false)));
+    ccsds::spp::archive_index index(&ccsds::spp::archive_index::secondary_time<index_time>);
+    CHECK_EQUAL(INDEX_PACKETS, index.build(reader.owner(), reader.data(), reader.length(), 7));
+
+    std::vector<std::unique_ptr<const ccsds::base_du>> packets;
+    index.query(static_cast<ccsds::spp::apid>(0x101), index_ticks(123), index_ticks(877), packets);
+    check(packets, 0x101, 123, 877);
+
+    // Rebuilding replaces the index
+    CHECK_EQUAL(INDEX_PACKETS, index.build(reader, 3));
+    CHECK_EQUAL(334, index.count(static_cast<ccsds::spp::apid>(0x100)));
+    packets.clear();
+    index.query(static_cast<ccsds::spp::apid>(0x100), 0, UINT64_MAX, packets);
+    check(packets, 0x100, 0, INDEX_PACKETS);
+
+    // Truncated buffers stop at the last complete packet
+    CHECK_EQUAL(INDEX_PACKETS - 1, index.build(nullptr, reader.data(), reader.length() - 1, 2));
+}
+
+/** @} */ // group unittest
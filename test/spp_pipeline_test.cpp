@@ -0,0 +1,193 @@
+/**
+ * @file test/spp_pipeline_test.cpp
+ */
+
+#include "ccsds/spp_pipeline.h"
+#include "CppUTest/TestHarness.h"
+#include <chrono>
+#include <ctime>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Space packet receive pipeline test group.
+ */
+TEST_GROUP(PipelineTestGroup)
+{
+};
+
+/**
+ * Handler counting SDUs of one APID for pipeline tests.
+ */
+class pipeline_handler {
+    public:
+        pipeline_handler() :
+            received(0),
+            lost(0)
+        {}
+
+        /**
+         * Receive an SDU.
+         */
+        void receive(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool data_loss)
+        {
+            (void)sdu;
+            (void)id;
+            if(data_loss){
+                ++lost;
+            }
+            if(received == 0){
+                thread = std::this_thread::get_id();
+            }else if(thread != std::this_thread::get_id()){
+                ++lost;
+            }
+            ++received;
+        }
+
+        size_t          received; ///< Number of SDUs received.
+        size_t          lost;     ///< Number of SDUs out of order or on another thread.
+        std::thread::id thread;   ///< Thread receiving the SDUs.
+};
+
+/**
+ * Build a received space packet.
+ * @param id APID of the packet.
+ * @param count Packet sequence count.
+ * @return Space packet PDU.
+ */
+static std::unique_ptr<ccsds::spp::pdu> pipeline_packet(uint16_t id, uint16_t count)
+{
+    static uint8_t data[4];
+    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+    (*pdu)->header.identification = ccsds::spp::identification(static_cast<ccsds::spp::apid>(id), ccsds::spp::TELEMETRY, false);
+    (*pdu)->header.sequence_control = ccsds::spp::sequence_control(ccsds::spp::SEQUENCE_UNSEGMENTED, count);
+    (*pdu)->header.data_length = ccsds::htons(sizeof(data) - 1);
+    pdu->append(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)));
+    return pdu;
+}
+
+/**
+ * Test routing packets to shards without worker threads.
+ */
+TEST(PipelineTestGroup, ProcessTest)
+{
+    ccsds::spp::receive_pipeline pipeline(3);
+    CHECK_EQUAL(3, pipeline.shards());
+    pipeline_handler handler;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x101), nullptr);
+    service.set_indication(ccsds::spp::octet_service::indication::bind<&pipeline_handler::receive>(&handler));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(pipeline.attach(static_cast<ccsds::spp::apid>(0x101), &service)));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(pipeline.attach(ccsds::spp::APID_IDLE, &service)));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(pipeline.attach(static_cast<ccsds::spp::apid>(0x102), &service)));
+
+    size_t i = pipeline.shard_of(static_cast<ccsds::spp::apid>(0x101));
+    for(uint16_t n = 0; n < ccsds::spp::receive_pipeline::DEPTH; ++n){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(pipeline.reception(pipeline_packet(0x101, n))));
+    }
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(pipeline.reception(pipeline_packet(0x101, 0))));
+
+    CHECK_EQUAL(0, pipeline.process((i + 1) % 3));
+    CHECK_EQUAL(10, pipeline.process(i, 10));
+    CHECK_EQUAL(ccsds::spp::receive_pipeline::DEPTH - 10, pipeline.process(i));
+    CHECK_EQUAL(ccsds::spp::receive_pipeline::DEPTH, handler.received);
+    CHECK_EQUAL(0, handler.lost);
+}
+
+/**
+ * Test receiving packets of several APIDs on worker threads.
+ */
+TEST(PipelineTestGroup, ThreadTest)
+{
+    const size_t apids = 8;
+    ccsds::spp::receive_pipeline pipeline(4);
+    pipeline_handler handlers[apids];
+    std::vector<std::unique_ptr<ccsds::spp::octet_service>> services;
+    for(size_t i = 0; i < apids; ++i){
+        ccsds::spp::apid id = static_cast<ccsds::spp::apid>(0x200 + i);
+        services.push_back(std::make_unique<ccsds::spp::octet_service>(id, nullptr));
+        services[i]->set_indication(ccsds::spp::octet_service::indication::bind<&pipeline_handler::receive>(&handlers[i]));
+        pipeline.attach(id, services[i].get());
+    }
+    pipeline.start();
+
+    for(uint16_t n = 0; n < 5000; ++n){
+        for(size_t i = 0; i < apids; ++i){
+            std::unique_ptr<ccsds::spp::pdu> pdu = pipeline_packet(0x200 + i, n);
+            while(pipeline.reception(std::move(pdu))){
+                pdu = pipeline_packet(0x200 + i, n);
+                std::this_thread::yield();
+            }
+        }
+    }
+    pipeline.stop();
+
+    // Every APID is received in order on a single thread
+    for(size_t i = 0; i < apids; ++i){
+        CHECK_EQUAL(5000, handlers[i].received);
+        CHECK_EQUAL(0, handlers[i].lost);
+    }
+    CHECK(handlers[0].thread != handlers[1].thread);
+}
+
+/**
+ * Handler counting SDUs across threads for pipeline tests.
+ */
+class pipeline_counter {
+    public:
+        pipeline_counter() :
+            received(0)
+        {}
+
+        /**
+         * Receive an SDU.
+         */
+        void receive(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool data_loss)
+        {
+            (void)sdu;
+            (void)id;
+            (void)data_loss;
+            received.fetch_add(1);
+        }
+
+        std::atomic<size_t> received; ///< Number of SDUs received.
+};
+
+/**
+ * Test idle workers sleep and are woken by received packets.
+ */
+TEST(PipelineTestGroup, IdleTest)
+{
+    ccsds::spp::receive_pipeline pipeline(2);
+    pipeline_counter counter;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x101), nullptr);
+    service.set_indication(ccsds::spp::octet_service::indication::bind<&pipeline_counter::receive>(&counter));
+    pipeline.attach(static_cast<ccsds::spp::apid>(0x101), &service);
+    pipeline.start();
+
+    // Idle workers use next to no CPU time
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    std::clock_t before = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::clock_t used = std::clock() - before;
+    CHECK(used < CLOCKS_PER_SEC / 20);
+
+    // Packets wake the worker of their shard, whether it spins or sleeps
+    for(uint16_t n = 0; n < 200; ++n){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(pipeline.reception(pipeline_packet(0x101, n))));
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while((counter.received.load() <= n) && (std::chrono::steady_clock::now() < deadline)){
+            std::this_thread::yield();
+        }
+        CHECK_EQUAL(n + 1u, counter.received.load());
+        if((n % 20) == 0){
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+    pipeline.stop();
+    CHECK_EQUAL(200, counter.received.load());
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,261 @@
+/**
+ * @file test/spp_qos_test.cpp
+ */
+
+#include "ccsds/spp_qos.h"
+#include "CppUTest/TestHarness.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Space packet QoS test group.
+ */
+TEST_GROUP(QosTestGroup)
+{
+};
+
+/**
+ * CCSDS service with limited credit recording transferred packets.
+ */
+class qos_test_service : public ccsds::base_service {
+    public:
+        qos_test_service() :
+            available(0)
+        {}
+        virtual ~qos_test_service() = default;
+
+        virtual size_t credit() const override
+        {
+            return available;
+        }
+
+        std::atomic<size_t>   available; ///< Number of packets the service accepts, read from any thread.
+        std::vector<uint16_t> order;     ///< Sequence counts of transferred packets.
+        std::vector<uint16_t> apids;     ///< APIDs of transferred packets.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override
+        {
+            // Packets from octet services are not always PDUs, read the header bytes
+            const uint8_t* header = static_cast<const uint8_t*>(du->get());
+            order.push_back(((header[2] << 8) | header[3]) & ccsds::spp::SEQUENCE_COUNT_MASK);
+            apids.push_back(((header[0] << 8) | header[1]) & ccsds::spp::PACKET_APID_MASK);
+            --available;
+            return ccsds::error();
+        }
+};
+
+/**
+ * Build a space packet to send.
+ * @param count Packet sequence count.
+ * @return Space packet PDU.
+ */
+static std::unique_ptr<const ccsds::spp::pdu> qos_packet(uint16_t count)
+{
+    static uint8_t data[4];
+    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+    (*pdu)->header.identification = ccsds::spp::identification(static_cast<ccsds::spp::apid>(0x1AB), ccsds::spp::TELEMETRY, false);
+    (*pdu)->header.sequence_control = ccsds::spp::sequence_control(ccsds::spp::SEQUENCE_UNSEGMENTED, count);
+    (*pdu)->header.data_length = ccsds::htons(sizeof(data) - 1);
+    pdu->append(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)));
+    return pdu;
+}
+
+/**
+ * Test strict priority draining.
+ */
+TEST(QosTestGroup, StrictTest)
+{
+    qos_test_service test;
+    ccsds::spp::priority_scheduler scheduler(ccsds::spp::priority_scheduler::STRICT, {1, 1, 1, 1}, {8, 8, 8, 8});
+    ccsds::spp::packet_service service(&test);
+    service.set_scheduler(&scheduler);
+
+    // The link is saturated
+    const int qos[] = {3, 3, 1, 0, 2, 0};
+    for(uint16_t i = 0; i < 6; ++i){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(i), qos[i])));
+    }
+    CHECK_EQUAL(0, test.order.size());
+    CHECK_EQUAL(2, scheduler.size(0));
+
+    test.available = 4;
+    CHECK_EQUAL(4, service.process());
+    const uint16_t expected[] = {3, 5, 2, 4, 0, 1};
+    for(size_t i = 0; i < 4; ++i){
+        CHECK_EQUAL(expected[i], test.order[i]);
+    }
+
+    // A high priority packet goes ahead of the queued bulk packets
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(6), 0)));
+    test.available = 10;
+    CHECK_EQUAL(3, service.process());
+    CHECK_EQUAL(7, test.order.size());
+    CHECK_EQUAL(6, test.order[4]);
+    CHECK_EQUAL(0, test.order[5]);
+    CHECK_EQUAL(1, test.order[6]);
+
+    // Packets are passed on immediately while the link has credit
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(7), 3)));
+    CHECK_EQUAL(8, test.order.size());
+    CHECK_EQUAL(0, scheduler.errors());
+}
+
+/**
+ * Test weighted round robin draining.
+ */
+TEST(QosTestGroup, WeightedTest)
+{
+    qos_test_service test;
+    ccsds::spp::priority_scheduler scheduler(ccsds::spp::priority_scheduler::WEIGHTED, {3, 1, 1, 1}, {8, 8, 8, 8});
+    ccsds::spp::packet_service service(&test);
+    service.set_scheduler(&scheduler);
+
+    // Counts 0-5 in class 0, 10-11 in class 1, 20-21 in class 3
+    for(uint16_t i = 0; i < 6; ++i){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(i), 0)));
+    }
+    for(uint16_t i = 0; i < 2; ++i){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(10 + i), 1)));
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(20 + i), 3)));
+    }
+
+    test.available = 10;
+    CHECK_EQUAL(10, service.process());
+    const uint16_t expected[] = {0, 1, 2, 10, 20, 3, 4, 5, 11, 21};
+    for(size_t i = 0; i < 10; ++i){
+        CHECK_EQUAL(expected[i], test.order[i]);
+    }
+}
+
+/**
+ * Test bounded classes and invalid classes.
+ */
+TEST(QosTestGroup, LimitTest)
+{
+    qos_test_service test;
+    ccsds::spp::priority_scheduler scheduler(ccsds::spp::priority_scheduler::STRICT, {1, 1, 1, 1}, {2, 2, 2, 1000});
+    ccsds::spp::packet_service service(&test);
+    service.set_scheduler(&scheduler);
+
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(0), 1)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(1), 1)));
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(service.request(qos_packet(2), 1)));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(service.request(qos_packet(3), 4)));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(service.request(qos_packet(4), -1)));
+    for(uint16_t i = 0; i < ccsds::spp::priority_scheduler::DEPTH; ++i){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(qos_packet(i), 3)));
+    }
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(service.request(qos_packet(0), 3)));
+
+    ccsds::spp::packet_service unconnected(nullptr);
+    unconnected.set_scheduler(&scheduler);
+    CHECK_EQUAL(ccsds::error::code::NO_NETWORK, static_cast<int>(unconnected.request(qos_packet(0), 0)));
+    CHECK_EQUAL(0, unconnected.process());
+}
+
+/**
+ * Completion callback counting results for QoS tests.
+ * @param context Counters, indexed by error code.
+ * @param result Result of the transfer.
+ */
+static void qos_completion(void* context, ccsds::error result)
+{
+    static_cast<size_t*>(context)[static_cast<int>(result)]++;
+}
+
+/**
+ * Test octet services are scheduled in their QoS class.
+ */
+TEST(QosTestGroup, OctetServiceTest)
+{
+    qos_test_service test;
+    ccsds::spp::priority_scheduler scheduler(ccsds::spp::priority_scheduler::STRICT, {1, 1, 1, 1}, {8, 8, 8, 4});
+    ccsds::spp::octet_service commands(static_cast<ccsds::spp::apid>(0x10), &test);
+    ccsds::spp::octet_service bulk(static_cast<ccsds::spp::apid>(0x20), &test);
+    commands.set_scheduler(&scheduler, 0);
+    bulk.set_scheduler(&scheduler, 3);
+
+    // The link is saturated, the bulk class fills up
+    uint8_t data[] = {0, 1, 2, 3};
+    CHECK_EQUAL(4, bulk.credit());
+    for(int i = 0; i < 3; ++i){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(bulk.request(&data, sizeof(data), false, ccsds::spp::TELEMETRY)));
+    }
+    size_t results[ccsds::error::code::NO_SPACE + 1] = {};
+    ccsds::base_service::completion done(&qos_completion, results);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(bulk.request_async(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY, done)));
+    CHECK_EQUAL(0, bulk.credit());
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(bulk.request(&data, sizeof(data), false, ccsds::spp::TELEMETRY)));
+    std::unique_ptr<const ccsds::base_du> sdus[2] = {
+        std::make_unique<ccsds::buffered_du>(&data, sizeof(data)),
+        std::make_unique<ccsds::buffered_du>(&data, sizeof(data)),
+    };
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(commands.request_batch(sdus, 2, false, ccsds::spp::TELECOMMAND)));
+    CHECK_EQUAL(0, test.order.size());
+    CHECK_EQUAL(0, results[ccsds::error::code::NONE]);
+
+    // Commands go ahead of the queued bulk packets
+    test.available = 3;
+    CHECK_EQUAL(3, commands.process());
+    const uint16_t apids[] = {0x10, 0x10, 0x20};
+    for(size_t i = 0; i < 3; ++i){
+        CHECK_EQUAL(apids[i], test.apids[i]);
+    }
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(commands.request(&data, sizeof(data), false, ccsds::spp::TELECOMMAND)));
+    test.available = 10;
+    CHECK_EQUAL(4, bulk.process());
+    CHECK_EQUAL(0x10, test.apids[3]);
+    CHECK_EQUAL(7, test.order.size());
+    CHECK_EQUAL(1, results[ccsds::error::code::NONE]);
+
+    // Invalid classes are rejected
+    bulk.set_scheduler(&scheduler, 4);
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(bulk.request(&data, sizeof(data), false, ccsds::spp::TELEMETRY)));
+
+    // Without a scheduler packets bypass the queues
+    bulk.set_scheduler(nullptr);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(bulk.request(&data, sizeof(data), false, ccsds::spp::TELEMETRY)));
+    CHECK_EQUAL(8, test.order.size());
+    CHECK_EQUAL(0, scheduler.errors());
+}
+
+/**
+ * Test requesting packets from several threads.
+ */
+TEST(QosTestGroup, ConcurrentTest)
+{
+    qos_test_service test;
+    test.available = SIZE_MAX;
+    ccsds::spp::priority_scheduler scheduler(ccsds::spp::priority_scheduler::WEIGHTED, {4, 3, 2, 1}, {256, 256, 256, 256});
+    ccsds::spp::packet_service service(&test);
+    service.set_scheduler(&scheduler);
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t){
+        threads.emplace_back([&service, t]{
+            for(uint16_t i = 0; i < 2000; ++i){
+                while(service.request(qos_packet(i), t)){
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for(auto& t : threads){
+        t.join();
+    }
+
+    // Only one thread transfers at a time and no packet is left behind
+    CHECK_EQUAL(8000, test.order.size());
+    for(int t = 0; t < 4; ++t){
+        CHECK_EQUAL(0, scheduler.size(t));
+    }
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,103 @@
+/**
+ * @file test/spp_secondary_test.cpp
+ */
+
+#include "ccsds/spp_decode.h"
+#include "ccsds/spp_secondary.h"
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Secondary header test group.
+ */
+TEST_GROUP(SecondaryTestGroup)
+{
+};
+
+typedef ccsds::spp::secondary_field<0, ccsds::cuc<4, 2>> test_time;        ///< Time code of the test layout.
+typedef ccsds::spp::secondary_field<6, ccsds::octets<1>> test_function;    ///< Function code of the test layout.
+typedef ccsds::spp::secondary_header<test_function, test_time> test_layout; ///< Test secondary header layout.
+
+/**
+ * Write a space packet with a test secondary header.
+ * @param buf Buffer to write the packet to.
+ * @param seconds Seconds of the time code.
+ * @param function Function code.
+ * @param len Length of the user data in bytes.
+ * @return Size of the packet in bytes.
+ */
+static size_t secondary_packet(uint8_t* buf, uint32_t seconds, uint8_t function, size_t len)
+{
+    ccsds::spp::primary_header header;
+    header.identification = ccsds::spp::identification(static_cast<ccsds::spp::apid>(0x1AB), ccsds::spp::TELEMETRY, true);
+    header.sequence_control = ccsds::spp::sequence_control(ccsds::spp::SEQUENCE_UNSEGMENTED, 0);
+    header.data_length = ccsds::htons(test_layout::SIZE + len - 1);
+    memcpy(buf, &header, sizeof(header));
+
+    ccsds::timestamp time = {seconds, 0x12340000};
+    test_layout::encode(buf + sizeof(header), function, time);
+    memset(buf + sizeof(header) + test_layout::SIZE, 0, len);
+    return sizeof(header) + test_layout::SIZE + len;
+}
+
+/**
+ * Test the layout of a secondary header.
+ */
+TEST(SecondaryTestGroup, LayoutTest)
+{
+    CHECK_EQUAL(7, test_layout::SIZE);
+    CHECK_EQUAL(6, test_function::BEGIN);
+    CHECK_EQUAL(6, test_time::END);
+
+    uint8_t buffer[32];
+    size_t size = secondary_packet(buffer, 0xCAFE, 0x42, 4);
+    const uint8_t expected[] = {0x00, 0x00, 0xCA, 0xFE, 0x12, 0x34, 0x42};
+    MEMCMP_EQUAL(expected, buffer + 6, sizeof(expected));
+
+    ccsds::spp::packet_view view(buffer, size);
+    CHECK(test_layout::present(view));
+    CHECK_EQUAL(0x42, test_function::decode(view));
+    CHECK_EQUAL(0xCAFE, test_time::decode(view).seconds);
+    CHECK_EQUAL(0x12340000, test_time::decode(view).fraction);
+
+    // Too short for the secondary header
+    size = secondary_packet(buffer, 0, 0, 0);
+    buffer[5] = 5;
+    CHECK_FALSE(test_layout::present(ccsds::spp::packet_view(buffer, size)));
+}
+
+/**
+ * Test decoding time codes of a stream of packets.
+ */
+TEST(SecondaryTestGroup, StreamTest)
+{
+    uint8_t buffer[256];
+    size_t len = 0;
+    for(uint32_t i = 0; i < 10; ++i){
+        len += secondary_packet(buffer + len, 100 + i, 0, i);
+    }
+
+    uint16_t apid[16];
+    uint8_t type[16];
+    uint8_t secondary[16];
+    uint8_t flags[16];
+    uint16_t counts[16];
+    uint32_t length[16];
+    ccsds::spp::header_fields fields = {apid, type, secondary, flags, counts, length};
+    size_t offsets[16];
+    size_t count = ccsds::spp::decode_stream(buffer, len, offsets, 16, fields);
+    CHECK_EQUAL(10, count);
+
+    ccsds::timestamp times[16];
+    test_time::decode(buffer, offsets, count, times);
+    for(uint32_t i = 0; i < 10; ++i){
+        CHECK_EQUAL(100 + i, times[i].seconds);
+    }
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,277 @@
+/**
+ * @file test/spp_segment_test.cpp
+ */
+
+#include "ccsds/spp.h"
+#include "CppUTest/TestHarness.h"
+#include "CppUTestExt/MockSupport.h"
+#include <thread>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Space packet segmentation test group.
+ */
+TEST_GROUP(SegmentTestGroup)
+{
+    void teardown()
+    {
+        mock().clear();
+    }
+};
+
+/**
+ * CCSDS service keeping transferred packets for segmentation tests.
+ */
+class segment_test_service : public ccsds::base_service {
+    public:
+        segment_test_service() = default;
+        virtual ~segment_test_service() = default;
+
+        std::vector<std::unique_ptr<ccsds::spp::pdu>> packets; ///< Transferred packets.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override
+        {
+            // This casting is only safe because we know how the test was written
+            ccsds::base_du* du = const_cast<ccsds::base_du*>(sdu.release());
+            packets.emplace_back(static_cast<ccsds::spp::pdu*>(du));
+            return ccsds::error();
+        }
+};
+
+/**
+ * Copy the buffers of a DU chain.
+ * @param du DU chain to copy.
+ * @param buf Buffer to copy to.
+ * @param len Size of buf in bytes.
+ * @return Number of bytes copied.
+ */
+static size_t segment_copy(const ccsds::base_du& du, uint8_t* buf, size_t len)
+{
+    ccsds::segment segs[8];
+    size_t count = du.gather(segs, 8);
+    size_t total = 0;
+    for(size_t i = 0; i < count; ++i){
+        for(size_t j = 0; (j < segs[i].len) && (total < len); ++j){
+            buf[total++] = static_cast<const uint8_t*>(segs[i].base)[j];
+        }
+    }
+    return total;
+}
+
+static size_t segment_length; ///< Length of the last user data received.
+static bool   segment_loss;   ///< Packet loss of the last user data received.
+
+/**
+ * Test indication function checking reassembled user data.
+ */
+static void segment_indication(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool packet_loss)
+{
+    mock().actualCall("segment_indication");
+    CHECK_EQUAL(0x1AB, id);
+
+    uint8_t buf[16];
+    segment_length = segment_copy(*sdu, buf, sizeof(buf));
+    segment_loss = packet_loss;
+    for(size_t i = 0; i < segment_length; ++i){
+        CHECK_EQUAL(i, buf[i]);
+    }
+}
+
+/**
+ * Segment ten bytes of chained user data into packets of up to three bytes.
+ * @param test Service receiving the packets.
+ * @param service Service segmenting the user data.
+ */
+static void segment_data(segment_test_service& test, ccsds::spp::octet_service& service)
+{
+    static uint8_t data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    size_t count = test.packets.size();
+    std::unique_ptr<ccsds::buffered_du> sdu = std::make_unique<ccsds::buffered_du>(&data[0], 4);
+    sdu->append(std::make_unique<ccsds::buffered_du>(&data[4], 6));
+    ccsds::error e = service.request_segmented(std::move(sdu), true, ccsds::spp::TELEMETRY, 3);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    CHECK_EQUAL(count + 4, test.packets.size());
+}
+
+/**
+ * Test segmenting user data.
+ */
+TEST(SegmentTestGroup, SegmentationTest)
+{
+    segment_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+    segment_data(test, service);
+
+    const uint16_t flags[] = {ccsds::spp::SEQUENCE_FIRST, ccsds::spp::SEQUENCE_CONTINUATION,
+                              ccsds::spp::SEQUENCE_CONTINUATION, ccsds::spp::SEQUENCE_LAST};
+    const size_t lengths[] = {3, 3, 3, 1};
+    uint8_t next = 0;
+    for(size_t i = 0; i < 4; ++i){
+        const ccsds::spp::primary_header* header = &(*test.packets[i])->header;
+        uint16_t ident = ccsds::ntohs(header->identification);
+        uint16_t sequence = ccsds::ntohs(header->sequence_control);
+        CHECK_EQUAL(0x1AB, ident & ccsds::spp::PACKET_APID_MASK);
+        CHECK_EQUAL(i == 0, (ident >> ccsds::spp::PACKET_SEC_HDR_SHIFT) & 1);
+        CHECK_EQUAL(flags[i], sequence >> ccsds::spp::SEQUENCE_FLAGS_SHIFT);
+        CHECK_EQUAL(i, sequence & ccsds::spp::SEQUENCE_COUNT_MASK);
+        CHECK_EQUAL(lengths[i] - 1, ccsds::ntohs(header->data_length));
+        CHECK_EQUAL(lengths[i] + 6, test.packets[i]->totalSize());
+
+        // The second segment spans both nodes of the user data
+        uint8_t buf[3];
+        CHECK_EQUAL(lengths[i], segment_copy(test.packets[i]->next(), buf, sizeof(buf)));
+        for(size_t j = 0; j < lengths[i]; ++j){
+            CHECK_EQUAL(next++, buf[j]);
+        }
+    }
+}
+
+/**
+ * Test user data small enough for one packet is not segmented.
+ */
+TEST(SegmentTestGroup, UnsegmentedTest)
+{
+    segment_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+
+    uint8_t data[] = {0, 1, 2};
+    ccsds::error e = service.request_segmented(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY, 3);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    CHECK_EQUAL(1, test.packets.size());
+    uint16_t sequence = ccsds::ntohs((*test.packets[0])->header.sequence_control);
+    CHECK_EQUAL(ccsds::spp::SEQUENCE_UNSEGMENTED, sequence >> ccsds::spp::SEQUENCE_FLAGS_SHIFT);
+
+    e = service.request_segmented(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY, 0);
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(e));
+}
+
+/**
+ * Test reassembling segmented user data.
+ */
+TEST(SegmentTestGroup, ReassemblyTest)
+{
+    segment_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+    ccsds::spp::octet_service receiver(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    receiver.set_indication(&segment_indication);
+    segment_data(test, service);
+
+    mock().expectOneCall("segment_indication");
+    for(auto& pdu : test.packets){
+        receiver.reception(std::move(pdu));
+    }
+    mock().checkExpectations();
+    CHECK_EQUAL(10, segment_length);
+    CHECK_FALSE(segment_loss);
+}
+
+/**
+ * Test a lost segment discards the user data.
+ */
+TEST(SegmentTestGroup, LostSegmentTest)
+{
+    segment_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+    ccsds::spp::octet_service receiver(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    receiver.set_indication(&segment_indication);
+
+    // Lose a middle segment of the first user data
+    segment_data(test, service);
+    test.packets.erase(test.packets.begin() + 1);
+    segment_data(test, service);
+
+    mock().expectOneCall("segment_indication");
+    for(auto& pdu : test.packets){
+        receiver.reception(std::move(pdu));
+    }
+    mock().checkExpectations();
+    CHECK_EQUAL(10, segment_length);
+    CHECK(segment_loss);
+}
+
+/**
+ * Test incomplete user data is discarded after the timeout.
+ */
+TEST(SegmentTestGroup, TimeoutTest)
+{
+    segment_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+    ccsds::spp::octet_service receiver(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    receiver.set_indication(&segment_indication);
+    receiver.set_reassembly(16, std::chrono::milliseconds(1));
+    segment_data(test, service);
+
+    receiver.reception(std::move(test.packets[0]));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    for(size_t i = 1; i < test.packets.size(); ++i){
+        receiver.reception(std::move(test.packets[i]));
+    }
+    mock().checkExpectations();
+}
+
+/**
+ * Test stale incomplete user data is freed without further packets.
+ */
+TEST(SegmentTestGroup, ExpireTest)
+{
+    segment_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+    ccsds::spp::octet_service receiver(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    receiver.set_indication(&segment_indication);
+    receiver.set_reassembly(16, std::chrono::milliseconds(20));
+    segment_data(test, service);
+
+    // The first segment views a buffer, owned until the segment is freed
+    std::shared_ptr<uint8_t> buffer(new uint8_t[16], std::default_delete<uint8_t[]>());
+    size_t len = segment_copy(*test.packets[0], buffer.get(), 16);
+    std::weak_ptr<uint8_t> owner = buffer;
+    ccsds::spp::packet_view packet(buffer.get(), len);
+    receiver.reception(packet, std::move(buffer));
+    CHECK_FALSE(owner.expired());
+    CHECK_FALSE(receiver.expire());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    CHECK(receiver.expire());
+    CHECK(owner.expired());
+    CHECK_FALSE(receiver.expire());
+
+    // The remaining segments are incomplete, the next user data reports the loss
+    for(size_t i = 1; i < test.packets.size(); ++i){
+        receiver.reception(std::move(test.packets[i]));
+    }
+    mock().checkExpectations();
+    mock().expectOneCall("segment_indication");
+    segment_data(test, service);
+    for(size_t i = 4; i < test.packets.size(); ++i){
+        receiver.reception(std::move(test.packets[i]));
+    }
+    mock().checkExpectations();
+    CHECK_EQUAL(10, segment_length);
+    CHECK(segment_loss);
+}
+
+/**
+ * Test user data longer than the reassembly limit is discarded.
+ */
+TEST(SegmentTestGroup, LimitTest)
+{
+    segment_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+    ccsds::spp::octet_service receiver(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    receiver.set_indication(&segment_indication);
+    receiver.set_reassembly(8, std::chrono::seconds(10));
+    segment_data(test, service);
+
+    for(auto& pdu : test.packets){
+        receiver.reception(std::move(pdu));
+    }
+    mock().checkExpectations();
+}
+
+/** @} */ // group unittest
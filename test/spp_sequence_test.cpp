@@ -0,0 +1,181 @@
+/**
+ * @file test/spp_sequence_test.cpp
+ */
+
+#include "ccsds/spp.h"
+#include "ccsds/spp_stats.h"
+#include "CppUTest/TestHarness.h"
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Packet sequence count tracker test group.
+ */
+TEST_GROUP(SequenceTestGroup)
+{
+};
+
+/**
+ * Track a sequence of packet sequence counts.
+ * @param tracker Tracker to update.
+ * @param counts Packet sequence counts.
+ * @param len Number of counts.
+ * @param tolerance Reorder tolerance.
+ * @return Total number of packets found lost.
+ */
+static unsigned sequence_track(ccsds::spp::sequence_tracker& tracker, const uint16_t* counts, size_t len, uint8_t tolerance)
+{
+    unsigned lost = 0;
+    for(size_t i = 0; i < len; ++i){
+        lost += tracker.update(counts[i], tolerance).missing;
+    }
+    return lost;
+}
+
+/**
+ * Test exact gap counts without reordering.
+ */
+TEST(SequenceTestGroup, GapTest)
+{
+    ccsds::spp::sequence_tracker tracker;
+    ccsds::spp::sequence_tracker::status s = tracker.update(100, 0);
+    CHECK_EQUAL(0, s.missing);
+    CHECK_FALSE(s.late);
+    CHECK_EQUAL(0, tracker.update(101, 0).missing);
+    CHECK_EQUAL(3, tracker.update(105, 0).missing);
+    CHECK_EQUAL(0, tracker.update(106, 0).missing);
+
+    // Counts wrap around
+    tracker.reset();
+    CHECK_EQUAL(0, tracker.update(0x3FFE, 0).missing);
+    CHECK_EQUAL(0, tracker.update(0x3FFF, 0).missing);
+    CHECK_EQUAL(0, tracker.update(0, 0).missing);
+    CHECK_EQUAL(1, tracker.update(2, 0).missing);
+}
+
+/**
+ * Test packets reordered within the tolerance are not lost.
+ */
+TEST(SequenceTestGroup, ReorderTest)
+{
+    ccsds::spp::sequence_tracker tracker;
+    const uint16_t counts[] = {0, 2, 1, 4, 3, 5, 8, 7, 6, 9};
+    CHECK_EQUAL(0, sequence_track(tracker, counts, 10, 3));
+
+    // Without a tolerance every late packet restarts the sequence
+    tracker.reset();
+    tracker.update(0, 0);
+    CHECK_EQUAL(1, tracker.update(2, 0).missing);
+    ccsds::spp::sequence_tracker::status s = tracker.update(1, 0);
+    CHECK_EQUAL(0, s.missing);
+    CHECK(s.late);
+
+    // Late across the wrap
+    tracker.reset();
+    const uint16_t wrap[] = {0x3FFE, 0, 0x3FFF, 1};
+    CHECK_EQUAL(0, sequence_track(tracker, wrap, 4, 1));
+}
+
+/**
+ * Test missing packets are lost once they leave the window.
+ */
+TEST(SequenceTestGroup, EvictTest)
+{
+    ccsds::spp::sequence_tracker tracker;
+    tracker.update(0, 4);
+    CHECK_EQUAL(0, tracker.update(3, 4).missing);
+    CHECK_EQUAL(0, tracker.update(4, 4).missing);
+    CHECK_EQUAL(0, tracker.update(5, 4).missing);
+    CHECK_EQUAL(1, tracker.update(6, 4).missing);
+    CHECK_EQUAL(1, tracker.update(7, 4).missing);
+
+    // A gap beyond the window is counted at once
+    CHECK_EQUAL(5, tracker.update(17, 4).missing);
+    CHECK_EQUAL(4, tracker.update(22, 4).missing);
+
+    // The widest window
+    tracker.reset();
+    tracker.update(0, 255);
+    CHECK_EQUAL(0, tracker.update(64, 255).missing);
+    CHECK_EQUAL(63, tracker.update(127, 255).missing);
+}
+
+/**
+ * Test duplicates and restarted sequences.
+ */
+TEST(SequenceTestGroup, RestartTest)
+{
+    ccsds::spp::sequence_tracker tracker;
+    tracker.update(10, 2);
+    ccsds::spp::sequence_tracker::status s = tracker.update(10, 2);
+    CHECK_EQUAL(0, s.missing);
+    CHECK(s.late);
+
+    // A jump ahead loses the packet missing from the window and the gap
+    CHECK_EQUAL(0, tracker.update(12, 2).missing);
+    s = tracker.update(500, 2);
+    CHECK_EQUAL(486, s.missing);
+    CHECK_FALSE(s.late);
+
+    // Packets still missing when the sequence restarts are lost
+    s = tracker.update(5, 2);
+    CHECK_EQUAL(2, s.missing);
+    CHECK(s.late);
+    CHECK_EQUAL(0, tracker.update(8, 2).missing);
+    s = tracker.update(1, 2);
+    CHECK_EQUAL(2, s.missing);
+    CHECK(s.late);
+    CHECK_EQUAL(0, tracker.update(2, 2).missing);
+}
+
+/**
+ * Build a received space packet.
+ * @param id APID of the packet.
+ * @param count Packet sequence count.
+ * @param data Packet data field.
+ * @return Space packet PDU.
+ */
+static std::unique_ptr<ccsds::spp::pdu> sequence_packet(uint16_t id, uint16_t count, uint8_t* data)
+{
+    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+    (*pdu)->header.identification = ccsds::htons(id);
+    (*pdu)->header.sequence_control = ccsds::htons(0xC000 | count);
+    (*pdu)->header.data_length = ccsds::htons(0);
+    pdu->append(std::make_unique<ccsds::buffered_du>(data, 1));
+    return pdu;
+}
+
+/**
+ * Test the packet service tracks each APID on its own.
+ */
+TEST(SequenceTestGroup, PacketServiceTest)
+{
+    ccsds::spp::statistics stats;
+    ccsds::spp::packet_service service(nullptr);
+    service.set_statistics(&stats);
+    service.set_reorder_tolerance(2);
+
+    uint8_t data[1] = {};
+    service.reception(sequence_packet(0x10, 0, data));
+    service.reception(sequence_packet(0x20, 50, data));
+    service.reception(sequence_packet(0x10, 2, data));
+    service.reception(sequence_packet(0x20, 51, data));
+    service.reception(sequence_packet(0x10, 1, data));
+    service.reception(sequence_packet(0x20, 53, data));
+    service.reception(sequence_packet(0x10, 3, data));
+    service.reception(sequence_packet(0x20, 54, data));
+    service.reception(sequence_packet(0x20, 55, data));
+
+    ccsds::spp::counters c = stats.snapshot(static_cast<ccsds::spp::apid>(0x10));
+    CHECK_EQUAL(4, c.packets);
+    CHECK_EQUAL(0, c.missing);
+    c = stats.snapshot(static_cast<ccsds::spp::apid>(0x20));
+    CHECK_EQUAL(5, c.packets);
+    CHECK_EQUAL(1, c.gaps);
+    CHECK_EQUAL(1, c.missing);
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,178 @@
+/**
+ * @file test/spp_static_test.cpp
+ */
+
+#include "ccsds/spp_static.h"
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Static dispatch space packet test group.
+ */
+TEST_GROUP(StaticServiceTestGroup)
+{
+};
+
+/**
+ * Check value of the CRC-16-CCITT.
+ */
+static constexpr uint8_t STATIC_CHECK[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+static_assert(ccsds::spp::static_crc16(STATIC_CHECK, sizeof(STATIC_CHECK)) == 0x29B1,
+        "CRC is computed at compile time");
+
+/**
+ * Static dispatch octet service keeping transmitted and received data.
+ * @tparam ERROR_CONTROL Packets have a packet error control field.
+ */
+template<bool ERROR_CONTROL>
+class static_test_service : public ccsds::spp::static_octet_service<static_test_service<ERROR_CONTROL>,
+        static_cast<ccsds::spp::apid>(0x1AB), ccsds::spp::TELEMETRY, true, 32, ERROR_CONTROL> {
+    public:
+        std::vector<uint8_t> packet;   ///< Last transmitted packet.
+        std::vector<uint8_t> received; ///< Last received user data.
+        bool                 loss;     ///< Loss indicated with the last received user data.
+        int                  count;    ///< Number of indications.
+
+        static_test_service() :
+            loss(false),
+            count(0)
+        {}
+
+        ccsds::error transmit(const uint8_t* buf, size_t len)
+        {
+            packet.assign(buf, buf + len);
+            return ccsds::error();
+        }
+
+        void indication(const uint8_t* data, size_t len, bool lost)
+        {
+            received.assign(data, data + len);
+            loss = lost;
+            ++count;
+        }
+};
+
+/**
+ * CCSDS service keeping the last transferred packet.
+ */
+class static_test_subnetwork : public ccsds::base_service {
+    public:
+        std::vector<uint8_t> packet; ///< Last transferred packet.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override
+        {
+            packet.resize(du->totalSize());
+            ccsds::segment segs[8];
+            size_t count = du->gather(segs, 8);
+            size_t offset = 0;
+            for(size_t i = 0; i < count; ++i){
+                memcpy(packet.data() + offset, segs[i].base, segs[i].len);
+                offset += segs[i].len;
+            }
+            return ccsds::error();
+        }
+};
+
+/**
+ * Test packets are the same as those of the octet service.
+ */
+TEST(StaticServiceTestGroup, WireTest)
+{
+    static_test_service<false> fixed;
+    static_test_subnetwork subnetwork;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &subnetwork);
+
+    uint8_t data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    for(int i = 0; i < 3; ++i){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(fixed.request(data)));
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(data, sizeof(data), true, ccsds::spp::TELEMETRY)));
+        CHECK_EQUAL(subnetwork.packet.size(), fixed.packet.size());
+        MEMCMP_EQUAL(subnetwork.packet.data(), fixed.packet.data(), fixed.packet.size());
+    }
+
+    uint8_t large[33] = {};
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(fixed.request(large, sizeof(large))));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(fixed.request(large, 0)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(fixed.request(large, 32)));
+    CHECK_EQUAL(38, fixed.packet.size());
+
+    // With the packet error control field
+    static_test_service<true> checked;
+    service.set_error_control(true);
+    // Catch up with the packet count of the octet service
+    for(int i = 0; i < 3; ++i){
+        checked.request(data, sizeof(data));
+    }
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(checked.request(data, sizeof(data))));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(service.request(data, sizeof(data), true, ccsds::spp::TELEMETRY)));
+    CHECK_EQUAL(subnetwork.packet.size(), checked.packet.size());
+    MEMCMP_EQUAL(subnetwork.packet.data(), checked.packet.data(), checked.packet.size());
+}
+
+/**
+ * Test receiving packets of the octet service.
+ */
+TEST(StaticServiceTestGroup, ReceptionTest)
+{
+    static_test_service<true> fixed;
+    static_test_subnetwork subnetwork;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &subnetwork);
+    service.set_error_control(true);
+
+    uint8_t data[] = {9, 8, 7, 6};
+    service.request(data, sizeof(data), true, ccsds::spp::TELEMETRY);
+    fixed.reception(subnetwork.packet.data(), subnetwork.packet.size());
+    CHECK_EQUAL(1, fixed.count);
+    CHECK_EQUAL(sizeof(data), fixed.received.size());
+    MEMCMP_EQUAL(data, fixed.received.data(), sizeof(data));
+    CHECK_FALSE(fixed.loss);
+
+    // Lost packets
+    service.request(data, sizeof(data), true, ccsds::spp::TELEMETRY);
+    service.request(data, sizeof(data), true, ccsds::spp::TELEMETRY);
+    service.request(data, sizeof(data), true, ccsds::spp::TELEMETRY);
+    fixed.reception(subnetwork.packet.data(), subnetwork.packet.size());
+    CHECK_EQUAL(2, fixed.count);
+    CHECK(fixed.loss);
+    CHECK_EQUAL(2, fixed.missing());
+
+    // Corrupted packets, short buffers and other APIDs
+    service.request(data, sizeof(data), true, ccsds::spp::TELEMETRY);
+    subnetwork.packet[7] ^= 0x10;
+    fixed.reception(subnetwork.packet.data(), subnetwork.packet.size());
+    fixed.reception(subnetwork.packet.data(), 4);
+    subnetwork.packet[7] ^= 0x10;
+    fixed.reception(subnetwork.packet.data(), subnetwork.packet.size() - 1);
+    CHECK_EQUAL(2, fixed.count);
+    CHECK_EQUAL(2, fixed.malformed());
+    subnetwork.packet[1] ^= 0x01;
+    fixed.reception(subnetwork.packet.data(), subnetwork.packet.size());
+    CHECK_EQUAL(2, fixed.malformed());
+
+    // Packets of the static service are received by the octet service
+    static_test_service<true> sender;
+    bool received = false;
+    struct indication_test {
+        bool& received;
+        void indication(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid, bool loss)
+        {
+            received = (sdu->totalSize() == 4) && !loss;
+        }
+    } handler{received};
+    ccsds::spp::octet_service receiver(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    receiver.set_error_control(true);
+    receiver.set_indication(ccsds::spp::octet_service::indication::bind<&indication_test::indication>(&handler));
+    sender.request(data);
+    receiver.reception(ccsds::spp::packet_view(sender.packet.data(), sender.packet.size()), nullptr);
+    CHECK(received);
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,157 @@
+/**
+ * @file test/spp_stats_test.cpp
+ */
+
+#include "ccsds/spp_stats.h"
+#include "CppUTest/TestHarness.h"
+#include <thread>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Space packet statistics test group.
+ */
+TEST_GROUP(StatisticsTestGroup)
+{
+};
+
+/**
+ * Build a received space packet.
+ * @param id Identification field of the packet.
+ * @param count Packet sequence count.
+ * @param data Packet data field.
+ * @param len Length of data in bytes.
+ * @return Space packet PDU.
+ */
+static std::unique_ptr<ccsds::spp::pdu> stats_packet(uint16_t id, uint16_t count, uint8_t* data, size_t len)
+{
+    std::unique_ptr<ccsds::spp::pdu> pdu = std::make_unique<ccsds::spp::pdu>();
+    (*pdu)->header.identification = ccsds::htons(id);
+    (*pdu)->header.sequence_control = ccsds::htons(0xC000 | count);
+    (*pdu)->header.data_length = ccsds::htons(len - 1);
+    pdu->append(std::make_unique<ccsds::buffered_du>(data, len));
+    return pdu;
+}
+
+/**
+ * Test counting packets received by the packet service.
+ */
+TEST(StatisticsTestGroup, PacketServiceTest)
+{
+    ccsds::spp::statistics stats;
+    ccsds::spp::packet_service service(nullptr);
+    service.set_statistics(&stats);
+
+    uint8_t data[4] = {};
+    service.reception(stats_packet(0x123, 0, data, 4));
+    service.reception(stats_packet(0x123, 1, data, 4));
+    service.reception(stats_packet(0x123, 5, data, 4));
+    service.reception(stats_packet(0x123, 9, data, 2));
+    service.reception(stats_packet(ccsds::spp::APID_IDLE, 10, data, 1));
+
+    // Invalid version number and data length
+    service.reception(stats_packet(0x2123, 11, data, 4));
+    std::unique_ptr<ccsds::spp::pdu> pdu = stats_packet(0x123, 11, data, 4);
+    (*pdu)->header.data_length = ccsds::htons(4);
+    service.reception(std::move(pdu));
+
+    ccsds::spp::counters c = stats.snapshot(static_cast<ccsds::spp::apid>(0x123));
+    CHECK_EQUAL(4, c.packets);
+    CHECK_EQUAL((3 * 10) + 8, c.bytes);
+    CHECK_EQUAL(2, c.gaps);
+    CHECK_EQUAL(6, c.missing);
+    CHECK_EQUAL(0, c.idle);
+    CHECK_EQUAL(2, c.malformed);
+
+    c = stats.snapshot(ccsds::spp::APID_IDLE);
+    CHECK_EQUAL(0, c.packets);
+    CHECK_EQUAL(1, c.idle);
+    CHECK_EQUAL(7, c.bytes);
+
+    c = stats.total();
+    CHECK_EQUAL(4, c.packets);
+    CHECK_EQUAL(1, c.idle);
+    CHECK_EQUAL(45, c.bytes);
+
+    std::array<ccsds::spp::counters, ccsds::spp::statistics::SIZE> all;
+    stats.snapshot(all);
+    CHECK_EQUAL(4, all[0x123].packets);
+    CHECK_EQUAL(0, all[0x124].packets);
+
+    stats.reset();
+    CHECK_EQUAL(0, stats.total().packets);
+}
+
+/**
+ * Test the packet service counts gaps of multiplexed APIDs separately.
+ */
+TEST(StatisticsTestGroup, MultiplexTest)
+{
+    ccsds::spp::statistics stats;
+    ccsds::spp::packet_service service(nullptr);
+    service.set_statistics(&stats);
+
+    // Interleaved APIDs, each starting at its own count, are contiguous
+    uint8_t data[4] = {};
+    const uint16_t start[3] = {0, 1000, 0x3FFE};
+    for(uint16_t n = 0; n < 10; ++n){
+        for(uint16_t a = 0; a < 3; ++a){
+            service.reception(stats_packet(0x100 + a, (start[a] + n) & ccsds::spp::SEQUENCE_COUNT_MASK, data, 4));
+        }
+    }
+    for(uint16_t a = 0; a < 3; ++a){
+        ccsds::spp::counters c = stats.snapshot(static_cast<ccsds::spp::apid>(0x100 + a));
+        CHECK_EQUAL(10, c.packets);
+        CHECK_EQUAL(0, c.gaps);
+        CHECK_EQUAL(0, c.missing);
+    }
+
+    // A gap in one APID is only counted for that APID
+    service.reception(stats_packet(0x101, 1013, data, 4));
+    service.reception(stats_packet(0x100, 10, data, 4));
+    CHECK_EQUAL(1, stats.snapshot(static_cast<ccsds::spp::apid>(0x101)).gaps);
+    CHECK_EQUAL(3, stats.snapshot(static_cast<ccsds::spp::apid>(0x101)).missing);
+    CHECK_EQUAL(0, stats.snapshot(static_cast<ccsds::spp::apid>(0x100)).gaps);
+    CHECK_EQUAL(3, stats.total().missing);
+}
+
+/**
+ * Test counting packets received by octet services on several threads.
+ */
+TEST(StatisticsTestGroup, OctetServiceTest)
+{
+    static ccsds::spp::statistics stats;
+    stats.reset();
+
+    std::vector<std::thread> threads;
+    for(uint16_t t = 0; t < 4; ++t){
+        threads.emplace_back([t]{
+            ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x100 + t), nullptr);
+            service.set_statistics(&stats);
+            uint8_t data[8] = {};
+            for(uint16_t i = 0; i < 1000; ++i){
+                // Every tenth packet is lost
+                if((i % 10) != 9){
+                    service.reception(stats_packet(0x100 + t, i, data, sizeof(data)));
+                }
+            }
+        });
+    }
+    for(auto& t : threads){
+        t.join();
+    }
+
+    for(uint16_t t = 0; t < 4; ++t){
+        ccsds::spp::counters c = stats.snapshot(static_cast<ccsds::spp::apid>(0x100 + t));
+        CHECK_EQUAL(900, c.packets);
+        CHECK_EQUAL(900 * 14, c.bytes);
+        CHECK_EQUAL(99, c.gaps);
+        CHECK_EQUAL(99, c.missing);
+    }
+}
+
+/** @} */ // group unittest
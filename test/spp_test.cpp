@@ -3,8 +3,13 @@
  */
 
 #include "ccsds/spp.h"
+#include "ccsds/crc.h"
 #include "CppUTest/TestHarness.h"
 #include "CppUTestExt/MockSupport.h"
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 /**
  * @ingroup unittest
@@ -70,10 +75,17 @@ class loopback_service : public ccsds::base_service {
         virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override
         {
             if(service != nullptr){
-                // This casting is only safe because we know how the test was written
-                ccsds::base_du* du = const_cast<ccsds::base_du*>(sdu.release());
-                std::unique_ptr<ccsds::spp::pdu> pdu(reinterpret_cast<ccsds::spp::pdu*>(du));
-                service->reception(std::move(pdu));
+                // Flatten the packet and receive it in place
+                ccsds::segment segments[8];
+                size_t count = sdu->gather(segments, 8);
+                CHECK(count <= 8);
+                std::shared_ptr<uint8_t[]> buffer(new uint8_t[sdu->totalSize()]);
+                size_t offset = 0;
+                for(size_t i = 0; i < count; ++i){
+                    memcpy(buffer.get() + offset, segments[i].base, segments[i].len);
+                    offset += segments[i].len;
+                }
+                service->reception(ccsds::spp::packet_view(buffer.get(), offset), buffer);
             }else{
                 FAIL("Loopback service has not been set.");
             }
@@ -192,4 +204,180 @@ TEST(SpacePacketTestGroup, AssemblyTest)
     }
 }
 
+/**
+ * Test space packet batch assembly.
+ */
+TEST(SpacePacketTestGroup, BatchAssemblyTest)
+{
+    test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+
+    uint8_t data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    std::unique_ptr<const ccsds::base_du> sdus[3];
+    for(auto& sdu : sdus){
+        sdu = std::make_unique<ccsds::buffered_du>(&data, sizeof(data));
+    }
+    ccsds::error e = service.request_batch(sdus, 3, true, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    for(auto& sdu : sdus){
+        POINTERS_EQUAL(nullptr, sdu.get());
+    }
+
+    const ccsds::base_du& packet = test.get();
+    CHECK_EQUAL(2, packet.length());
+    CHECK_EQUAL(16, packet.totalSize());
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(packet.get());
+    CHECK_EQUAL(0x09, bytes[0]); // telemetry, secondary header, high byte of 1AB
+    CHECK_EQUAL(0xAB, bytes[1]); // low byte of 1AB
+    CHECK_EQUAL(0xC0, bytes[2]); // sequence flags, high byte of packet count
+    CHECK_EQUAL(0x02, bytes[3]); // low byte of packet count
+    CHECK_EQUAL(0x00, bytes[4]); // high byte of data length
+    CHECK_EQUAL(sizeof(data)-1, bytes[5]); // low byte of data length
+
+    // The next packet continues the packet count
+    e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    bytes = static_cast<const uint8_t*>(test.get().get());
+    CHECK_EQUAL(0x03, bytes[3]); // low byte of packet count
+}
+
+/**
+ * Test space packet assembly with a compile-time identification field.
+ */
+TEST(SpacePacketTestGroup, FixedAssemblyTest)
+{
+    test_service test;
+    typedef ccsds::spp::octet_service_t<static_cast<ccsds::spp::apid>(0x1AB), ccsds::spp::TELECOMMAND, true> fixed_service;
+    static_assert(fixed_service::IDENTIFICATION == ccsds::htons(0x19AB));
+    fixed_service service(&test);
+
+    uint8_t data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    for(uint8_t i = 0; i < 2; ++i){
+        ccsds::error e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)));
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+
+        const ccsds::base_du& packet = test.get();
+        CHECK_EQUAL(2, packet.length());
+        CHECK_EQUAL(16, packet.totalSize());
+
+        const uint8_t* bytes = static_cast<const uint8_t*>(packet.get());
+        CHECK_EQUAL(0x19, bytes[0]); // telecommand, secondary header, high byte of 1AB
+        CHECK_EQUAL(0xAB, bytes[1]); // low byte of 1AB
+        CHECK_EQUAL(0xC0, bytes[2]); // sequence flags, high byte of packet count
+        CHECK_EQUAL(i, bytes[3]);    // low byte of packet count
+        CHECK_EQUAL(0x00, bytes[4]); // high byte of data length
+        CHECK_EQUAL(sizeof(data)-1, bytes[5]); // low byte of data length
+    }
+
+    // The general requests share the packet count
+    ccsds::error e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    const uint8_t* bytes = static_cast<const uint8_t*>(test.get().get());
+    CHECK_EQUAL(0x01, bytes[0]); // telemetry, high byte of 1AB
+    CHECK_EQUAL(0x02, bytes[3]); // low byte of packet count
+}
+
+/**
+ * Test sending a copy of user data in a single DU.
+ */
+TEST(SpacePacketTestGroup, CopyRequestTest)
+{
+    test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test);
+
+    uint8_t data[] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    ccsds::error e = service.request(data, sizeof(data), true, ccsds::spp::TELECOMMAND);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+
+    // The header and user data share one inline buffer
+    const ccsds::base_du& packet = test.get();
+    CHECK_EQUAL(1, packet.length());
+    CHECK_EQUAL(16, packet.totalSize());
+    CHECK(static_cast<const ccsds::spp::packet_du&>(packet).inlined());
+    ccsds::spp::packet_view view(packet.get(), packet.size());
+    CHECK(view.valid());
+    CHECK_EQUAL(0x1AB, view.id());
+    CHECK(view.secondary());
+    CHECK_EQUAL(ccsds::spp::TELECOMMAND, view.type());
+    CHECK_EQUAL(0, view.count());
+    CHECK_EQUAL(sizeof(data), view.data_length());
+    MEMCMP_EQUAL(data, view.data(), sizeof(data));
+
+    // Packet counts are shared with the other requests
+    e = service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    service.set_error_control(true);
+    uint8_t large[100] = {};
+    e = service.request(large, sizeof(large), false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(e));
+    ccsds::spp::packet_view checked(test.get().get(), test.get().size());
+    CHECK_FALSE(static_cast<const ccsds::spp::packet_du&>(test.get()).inlined());
+    CHECK_EQUAL(2, checked.count());
+    CHECK_EQUAL(sizeof(large) + 2, checked.data_length());
+    CHECK_EQUAL(0, ccsds::crc16(checked.get(), checked.size()));
+
+    e = service.request(data, 0, false, ccsds::spp::TELEMETRY);
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(e));
+}
+
+/**
+ * CCSDS service recording packet counts from multiple threads.
+ */
+class concurrent_test_service : public ccsds::base_service {
+    public:
+        concurrent_test_service() :
+            seen(ccsds::spp::SEQUENCE_COUNT_MASK + 1, 0)
+        {}
+        virtual ~concurrent_test_service() = default;
+
+        std::vector<int> seen; ///< Number of packets seen for each packet count.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> sdu) override
+        {
+            const uint8_t* bytes = static_cast<const uint8_t*>(sdu->get());
+            uint16_t count = ((bytes[2] << 8) | bytes[3]) & ccsds::spp::SEQUENCE_COUNT_MASK;
+            std::lock_guard<std::mutex> lock(mutex);
+            ++seen[count];
+            return ccsds::error();
+        }
+
+        std::mutex mutex; ///< Lock for seen.
+};
+
+/**
+ * Test requesting packets from multiple threads.
+ */
+TEST(SpacePacketTestGroup, ConcurrentRequestTest)
+{
+    concurrent_test_service test;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), &test, true);
+
+    static uint8_t data[] = {0, 1, 2, 3};
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t){
+        threads.emplace_back([&service]{
+            for(int i = 0; i < 1000; ++i){
+                service.request(std::make_unique<ccsds::buffered_du>(&data, sizeof(data)), false, ccsds::spp::TELEMETRY);
+            }
+            std::unique_ptr<const ccsds::base_du> sdus[8];
+            for(int i = 0; i < 100; ++i){
+                for(auto& sdu : sdus){
+                    sdu = std::make_unique<ccsds::buffered_du>(&data, sizeof(data));
+                }
+                service.request_batch(sdus, 8, false, ccsds::spp::TELEMETRY);
+            }
+        });
+    }
+    for(auto& t : threads){
+        t.join();
+    }
+
+    // Every packet count is used exactly once
+    for(size_t i = 0; i < test.seen.size(); ++i){
+        CHECK_EQUAL((i < 7200) ? 1 : 0, test.seen[i]);
+    }
+}
+
 /** @} */ // group unittest
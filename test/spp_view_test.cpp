@@ -0,0 +1,193 @@
+/**
+ * @file test/spp_view_test.cpp
+ */
+
+#include "ccsds/spp.h"
+#include "ccsds/spp_demux.h"
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Space packet view test group.
+ */
+TEST_GROUP(PacketViewTestGroup)
+{
+};
+
+/**
+ * Receiver recording packets received in place.
+ */
+class view_receiver {
+    public:
+        view_receiver() :
+            received(0),
+            lost(0),
+            length(0),
+            first(0)
+        {}
+
+        /**
+         * Receive a packet from a packet service.
+         */
+        void packet(const ccsds::spp::packet_view& packet, ccsds::spp::apid id, bool packet_loss)
+        {
+            CHECK_EQUAL(packet.id(), id);
+            count(packet_loss, packet.data_length(), packet.data()[0]);
+        }
+
+        /**
+         * Receive an SDU from an octet service.
+         */
+        void octets(std::unique_ptr<const ccsds::base_du> sdu, ccsds::spp::apid id, bool data_loss)
+        {
+            (void)id;
+            count(data_loss, sdu->totalSize(), *static_cast<const uint8_t*>(sdu->get()));
+            last = std::move(sdu);
+        }
+
+        /**
+         * Receive an unregistered packet from a demultiplexer.
+         */
+        void unrouted(const ccsds::spp::packet_view& packet, ccsds::spp::apid id)
+        {
+            CHECK_EQUAL(packet.id(), id);
+            count(false, packet.data_length(), packet.data()[0]);
+        }
+
+        size_t                                received; ///< Number of packets received.
+        size_t                                lost;     ///< Number of packets with loss indicated.
+        size_t                                length;   ///< Length of the last packet data field.
+        uint8_t                               first;    ///< First octet of the last packet data field.
+        std::unique_ptr<const ccsds::base_du> last;     ///< Last SDU received.
+
+    private:
+        void count(bool loss, size_t len, uint8_t octet)
+        {
+            ++received;
+            if(loss){
+                ++lost;
+            }
+            length = len;
+            first = octet;
+        }
+};
+
+/**
+ * Write a space packet into a buffer.
+ * @param buf Buffer to write the packet to.
+ * @param id APID of the packet.
+ * @param count Packet sequence count.
+ * @param len Length of the packet data field in bytes.
+ * @return Size of the packet in bytes.
+ */
+static size_t view_packet(uint8_t* buf, uint16_t id, uint16_t count, size_t len)
+{
+    ccsds::spp::primary_header header;
+    header.identification = ccsds::spp::identification(static_cast<ccsds::spp::apid>(id), ccsds::spp::TELECOMMAND, true);
+    header.sequence_control = ccsds::spp::sequence_control(ccsds::spp::SEQUENCE_UNSEGMENTED, count);
+    header.data_length = ccsds::htons(len - 1);
+    memcpy(buf, &header, sizeof(header));
+    for(size_t i = 0; i < len; ++i){
+        buf[sizeof(header) + i] = static_cast<uint8_t>(count + i);
+    }
+    return sizeof(header) + len;
+}
+
+/**
+ * Test the field accessors of a packet view.
+ */
+TEST(PacketViewTestGroup, FieldTest)
+{
+    uint8_t buffer[32];
+    size_t size = view_packet(buffer + 1, 0x1AB, 0x123, 10);
+
+    // The header does not need to be aligned
+    ccsds::spp::packet_view view(buffer + 1, size);
+    CHECK(view.valid());
+    CHECK_EQUAL(0, view.version());
+    CHECK_EQUAL(ccsds::spp::TELECOMMAND, view.type());
+    CHECK(view.secondary());
+    CHECK_EQUAL(0x1AB, view.id());
+    CHECK_EQUAL(ccsds::spp::SEQUENCE_UNSEGMENTED, view.flags());
+    CHECK_EQUAL(0x123, view.count());
+    CHECK_EQUAL(10, view.data_length());
+    CHECK_EQUAL(16, view.size());
+    POINTERS_EQUAL(buffer + 7, view.data());
+    POINTERS_EQUAL(buffer + 1, view.get());
+
+    // Too short for the header or the data field
+    CHECK_FALSE(ccsds::spp::packet_view(buffer + 1, 5).valid());
+    CHECK_FALSE(ccsds::spp::packet_view(buffer + 1, size - 1).valid());
+    CHECK(ccsds::spp::packet_view(buffer + 1, size + 4).valid());
+
+    // Wrong version
+    buffer[1] |= 0x20;
+    CHECK_FALSE(view.valid());
+}
+
+/**
+ * Test receiving packets in place on a packet service.
+ */
+TEST(PacketViewTestGroup, PacketServiceTest)
+{
+    uint8_t buffer[64];
+    view_receiver receiver;
+    ccsds::spp::packet_service service(nullptr);
+    service.set_view_indication(ccsds::spp::packet_service::view_indication::bind<&view_receiver::packet>(&receiver));
+
+    size_t size = view_packet(buffer, 0x1AB, 0, 8);
+    service.reception(ccsds::spp::packet_view(buffer, size));
+    CHECK_EQUAL(1, receiver.received);
+    CHECK_EQUAL(0, receiver.lost);
+    CHECK_EQUAL(8, receiver.length);
+
+    size = view_packet(buffer, 0x1AB, 2, 4);
+    service.reception(ccsds::spp::packet_view(buffer, size));
+    CHECK_EQUAL(2, receiver.received);
+    CHECK_EQUAL(1, receiver.lost);
+    CHECK_EQUAL(4, receiver.length);
+    CHECK_EQUAL(2, receiver.first);
+
+    // Truncated packets are discarded
+    service.reception(ccsds::spp::packet_view(buffer, size - 1));
+    service.reception(ccsds::spp::packet_view(buffer, 3));
+    CHECK_EQUAL(2, receiver.received);
+}
+
+/**
+ * Test receiving packets in place on an octet service through a demultiplexer.
+ */
+TEST(PacketViewTestGroup, OctetServiceTest)
+{
+    std::shared_ptr<uint8_t[]> buffer(new uint8_t[64]);
+    view_receiver receiver;
+    view_receiver others;
+    ccsds::spp::demux_service demux;
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x1AB), nullptr);
+    service.set_indication(ccsds::spp::octet_service::indication::bind<&view_receiver::octets>(&receiver));
+    demux.attach(static_cast<ccsds::spp::apid>(0x1AB), &service);
+    demux.set_view_indication(ccsds::spp::demux_service::view_indication::bind<&view_receiver::unrouted>(&others));
+
+    size_t size = view_packet(buffer.get(), 0x1AB, 0, 12);
+    demux.reception(ccsds::spp::packet_view(buffer.get(), size), buffer);
+    CHECK_EQUAL(1, receiver.received);
+    CHECK_EQUAL(0, receiver.lost);
+    CHECK_EQUAL(12, receiver.length);
+
+    // The SDU views the buffer and keeps it alive
+    POINTERS_EQUAL(buffer.get() + 6, receiver.last->get());
+    CHECK_EQUAL(2, buffer.use_count());
+
+    size = view_packet(buffer.get(), 0x0AB, 0, 3);
+    demux.reception(ccsds::spp::packet_view(buffer.get(), size), buffer);
+    CHECK_EQUAL(1, receiver.received);
+    CHECK_EQUAL(1, others.received);
+    CHECK_EQUAL(3, others.length);
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,231 @@
+/**
+ * @file test/tee_test.cpp
+ */
+
+#include "ccsds/tee.h"
+#include "ccsds/shared_du.h"
+#include "CppUTest/TestHarness.h"
+#include <thread>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Tee service test group.
+ */
+TEST_GROUP(TeeTestGroup)
+{
+};
+
+/**
+ * DU recording when it is destroyed.
+ */
+class tee_test_du : public ccsds::buffered_du {
+    public:
+        tee_test_du(void* buf, size_t len, bool& destroyed) :
+            ccsds::buffered_du(buf, len),
+            destroyed(destroyed)
+        {
+            destroyed = false;
+        }
+
+        virtual ~tee_test_du()
+        {
+            destroyed = true;
+        }
+
+    private:
+        bool& destroyed; ///< Set when destroyed.
+};
+
+/**
+ * CCSDS service keeping transferred DUs.
+ */
+class tee_test_service : public ccsds::base_service {
+    public:
+        tee_test_service(ccsds::error result = ccsds::error(), size_t available = SIZE_MAX) :
+            result(result),
+            available(available)
+        {}
+
+        virtual ~tee_test_service() = default;
+
+        virtual size_t credit() const override
+        {
+            return available;
+        }
+
+        std::vector<std::unique_ptr<const ccsds::base_du>> dus; ///< Transferred DUs.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override
+        {
+            dus.push_back(std::move(du));
+            return result;
+        }
+
+        ccsds::error result;    ///< Result of each transfer.
+        size_t       available; ///< Credit of the service.
+};
+
+/**
+ * Test a DU is shared by every subnetwork without copying.
+ */
+TEST(TeeTestGroup, FanOutTest)
+{
+    tee_test_service primary;
+    tee_test_service recorder;
+    tee_test_service monitor;
+    ccsds::tee_service tee;
+    CHECK_EQUAL(ccsds::error::code::NO_NETWORK, static_cast<int>(tee.transfer(std::make_unique<ccsds::buffered_du>(nullptr, 0))));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(tee.attach(nullptr)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tee.attach(&primary)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tee.attach(&recorder)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tee.attach(&monitor)));
+
+    uint8_t header[6] = {0, 1, 2, 3, 4, 5};
+    uint8_t data[10] = {};
+    bool destroyed = false;
+    auto du = std::make_unique<tee_test_du>(header, sizeof(header), destroyed);
+    du->extend(std::make_unique<ccsds::buffered_du>(nullptr, 0));
+    du->extend(std::make_unique<ccsds::buffered_du>(data, sizeof(data)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tee.transfer(std::move(du))));
+
+    // Every chain views the original buffers, empty buffers are skipped
+    tee_test_service* services[] = {&primary, &recorder, &monitor};
+    for(tee_test_service* service : services){
+        CHECK_EQUAL(1, service->dus.size());
+        const ccsds::base_du& chain = *service->dus[0];
+        CHECK_EQUAL(16, chain.totalSize());
+        CHECK_EQUAL(2, chain.length());
+        POINTERS_EQUAL(header, chain.get());
+        POINTERS_EQUAL(data, chain.next().get());
+    }
+
+    // The original chain lives until the last view is released
+    primary.dus.clear();
+    recorder.dus.clear();
+    CHECK_FALSE(destroyed);
+    monitor.dus.clear();
+    CHECK(destroyed);
+}
+
+/**
+ * Test a single subnetwork gets the DU unchanged.
+ */
+TEST(TeeTestGroup, SingleTest)
+{
+    tee_test_service primary;
+    ccsds::tee_service tee;
+    tee.attach(&primary);
+
+    uint8_t data[4];
+    auto du = std::make_unique<ccsds::buffered_du>(data, sizeof(data));
+    const ccsds::base_du* p = du.get();
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tee.transfer(std::move(du))));
+    POINTERS_EQUAL(p, primary.dus[0].get());
+
+    tee.detach(&primary);
+    CHECK_EQUAL(ccsds::error::code::NO_NETWORK, static_cast<int>(tee.transfer(std::make_unique<ccsds::buffered_du>(data, 1))));
+}
+
+/**
+ * Test errors and credit of the subnetworks.
+ */
+TEST(TeeTestGroup, ErrorTest)
+{
+    tee_test_service primary(ccsds::error(), 10);
+    tee_test_service failing(ccsds::error(ccsds::error::code::IO_ERROR), 3);
+    tee_test_service monitor;
+    ccsds::tee_service tee;
+    CHECK_EQUAL(SIZE_MAX, tee.credit());
+    tee.attach(&primary);
+    tee.attach(&failing);
+    tee.attach(&monitor);
+    CHECK_EQUAL(3, tee.credit());
+
+    // Later subnetworks still get the DU
+    uint8_t data[4];
+    CHECK_EQUAL(ccsds::error::code::IO_ERROR, static_cast<int>(tee.transfer(std::make_unique<ccsds::buffered_du>(data, sizeof(data)))));
+    CHECK_EQUAL(1, primary.dus.size());
+    CHECK_EQUAL(1, failing.dus.size());
+    CHECK_EQUAL(1, monitor.dus.size());
+}
+
+/**
+ * Test the reference count of a shared payload.
+ */
+TEST(TeeTestGroup, ReferenceTest)
+{
+    uint8_t data[8];
+    bool destroyed = false;
+    const ccsds::shared_payload* payload = ccsds::shared_payload::create(std::make_unique<tee_test_du>(data, sizeof(data), destroyed));
+    CHECK_EQUAL(1, payload->references());
+    {
+        auto a = ccsds::shared_du::share(*payload);
+        auto b = ccsds::shared_du::share(*payload);
+        CHECK_EQUAL(3, payload->references());
+        POINTERS_EQUAL(data, a->get());
+        CHECK_EQUAL(8, b->size());
+    }
+    CHECK_EQUAL(1, payload->references());
+    CHECK_FALSE(destroyed);
+    payload->release();
+    CHECK(destroyed);
+}
+
+/**
+ * Test sharing a long DU chain.
+ */
+TEST(TeeTestGroup, LongChainTest)
+{
+    uint8_t data[4];
+    const size_t count = 100000;
+    ccsds::du_chain chain;
+    for(size_t i = 0; i < count; ++i){
+        chain.append(std::make_unique<ccsds::buffered_du>(data, (i % 2) * sizeof(data)));
+    }
+    const ccsds::shared_payload* payload = ccsds::shared_payload::create(chain.take());
+
+    // Empty DUs are skipped, every view caches the totals after it
+    std::unique_ptr<const ccsds::base_du> views = ccsds::shared_du::share(*payload);
+    CHECK_EQUAL(count / 2, views->length());
+    CHECK_EQUAL(count / 2 * sizeof(data), views->totalSize());
+    CHECK_EQUAL(count / 2 - 1, views->next().length());
+    CHECK_EQUAL((count / 2 - 1) * sizeof(data), views->next().totalSize());
+    CHECK_EQUAL(count / 2 + 1, payload->references());
+    views.reset();
+    payload->release();
+}
+
+/**
+ * Test releasing views of a concurrent payload from several threads.
+ */
+TEST(TeeTestGroup, ConcurrentTest)
+{
+    uint8_t data[8];
+    bool destroyed = false;
+    const ccsds::shared_payload* payload = ccsds::shared_payload::create(std::make_unique<tee_test_du>(data, sizeof(data), destroyed), true);
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t){
+        std::vector<std::unique_ptr<const ccsds::base_du>> views;
+        for(int i = 0; i < 1000; ++i){
+            views.push_back(ccsds::shared_du::share(*payload));
+        }
+        threads.emplace_back([views = std::move(views)]() mutable {
+            views.clear();
+        });
+    }
+    for(auto& t : threads){
+        t.join();
+    }
+    CHECK_EQUAL(1, payload->references());
+    payload->release();
+    CHECK(destroyed);
+}
+
+/** @} */ // group unittest
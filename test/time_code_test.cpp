@@ -0,0 +1,125 @@
+/**
+ * @file test/time_code_test.cpp
+ */
+
+#include "ccsds/time_code.h"
+#include "CppUTest/TestHarness.h"
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Time code test group.
+ */
+TEST_GROUP(TimeCodeTestGroup)
+{
+};
+
+/**
+ * Test encoding and decoding big endian integers.
+ */
+TEST(TimeCodeTestGroup, OctetsTest)
+{
+    const uint8_t in[] = {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08};
+    CHECK_EQUAL(0x01, ccsds::octets<1>::decode(in));
+    CHECK_EQUAL(0x010203, ccsds::octets<3>::decode(in));
+    CHECK_EQUAL(0x0102030405ULL, ccsds::octets<5>::decode(in));
+    CHECK_EQUAL(0x0102030405060708ULL, ccsds::octets<8>::decode(in));
+
+    uint8_t out[8] = {0};
+    ccsds::octets<3>::encode(out, 0xAABBCCDD);
+    CHECK_EQUAL(0xBB, out[0]);
+    CHECK_EQUAL(0xCC, out[1]);
+    CHECK_EQUAL(0xDD, out[2]);
+    CHECK_EQUAL(0, out[3]);
+    ccsds::octets<8>::encode(out, 0x0102030405060708ULL);
+    MEMCMP_EQUAL(in, out, sizeof(in));
+}
+
+/**
+ * Test encoding and decoding CUC time codes.
+ */
+TEST(TimeCodeTestGroup, CucTest)
+{
+    CHECK_EQUAL(0x1E, (ccsds::cuc<4, 2>::PFIELD));
+    CHECK_EQUAL(0x10, (ccsds::cuc<1, 0>::PFIELD));
+    CHECK_EQUAL(6, (ccsds::cuc<4, 2>::SIZE));
+
+    const uint8_t in[] = {0x12, 0x34, 0x56, 0x78, 0x80, 0x01, 0xFF};
+    ccsds::timestamp time = ccsds::cuc<4, 2>::decode(in);
+    CHECK_EQUAL(0x12345678, time.seconds);
+    CHECK_EQUAL(0x80010000, time.fraction);
+
+    time = ccsds::cuc<4, 0>::decode(in);
+    CHECK_EQUAL(0x12345678, time.seconds);
+    CHECK_EQUAL(0, time.fraction);
+
+    time = ccsds::cuc<2, 3>::decode(in);
+    CHECK_EQUAL(0x1234, time.seconds);
+    CHECK_EQUAL(0x56788000, time.fraction);
+
+    // The fraction is truncated to the fine octets
+    uint8_t out[7] = {0};
+    time.seconds = 0xAB123456;
+    time.fraction = 0xC0DEFFFF;
+    ccsds::cuc<3, 2>::encode(out, time);
+    const uint8_t expected[] = {0x12, 0x34, 0x56, 0xC0, 0xDE, 0x00, 0x00};
+    MEMCMP_EQUAL(expected, out, sizeof(expected));
+    time = ccsds::cuc<3, 2>::decode(out);
+    CHECK_EQUAL(0x123456, time.seconds);
+    CHECK_EQUAL(0xC0DE0000, time.fraction);
+}
+
+/**
+ * Test encoding and decoding CDS time codes.
+ */
+TEST(TimeCodeTestGroup, CdsTest)
+{
+    CHECK_EQUAL(0x40, (ccsds::cds<2, 0>::PFIELD));
+    CHECK_EQUAL(0x45, (ccsds::cds<3, 2>::PFIELD));
+    CHECK_EQUAL(0x42, (ccsds::cds<2, 4>::PFIELD));
+    CHECK_EQUAL(11, (ccsds::cds<3, 4>::SIZE));
+
+    const uint8_t in[] = {0x5A, 0x1B, 0x04, 0x00, 0x12, 0x34, 0x03, 0xE7, 0x00, 0x01};
+    ccsds::cds_time time = ccsds::cds<2, 2>::decode(in);
+    CHECK_EQUAL(0x5A1B, time.days);
+    CHECK_EQUAL(0x04001234, time.milliseconds);
+    CHECK_EQUAL(999, time.submilliseconds);
+
+    time = ccsds::cds<3, 0>::decode(in);
+    CHECK_EQUAL(0x5A1B04, time.days);
+    CHECK_EQUAL(0x00123403, time.milliseconds);
+    CHECK_EQUAL(0, time.submilliseconds);
+
+    uint8_t out[10];
+    ccsds::cds<2, 4>::encode(out, ccsds::cds<2, 4>::decode(in));
+    MEMCMP_EQUAL(in, out, sizeof(in));
+}
+
+/**
+ * Test decoding and encoding batches of time codes.
+ */
+TEST(TimeCodeTestGroup, BatchTest)
+{
+    uint8_t buffer[64] = {0};
+    size_t offsets[] = {0, 7, 20, 50};
+    ccsds::timestamp times[4];
+    for(uint32_t i = 0; i < 4; ++i){
+        times[i].seconds = 1000 + i;
+        times[i].fraction = i << 24;
+    }
+    ccsds::encode_batch<ccsds::cuc<4, 1>>(buffer, offsets, 4, times);
+    CHECK_EQUAL(0xEA, buffer[20 + 3]);
+    CHECK_EQUAL(0x02, buffer[20 + 4]);
+
+    ccsds::timestamp decoded[4];
+    ccsds::decode_batch<ccsds::cuc<4, 1>>(buffer, offsets, 4, decoded);
+    for(size_t i = 0; i < 4; ++i){
+        CHECK_EQUAL(times[i].seconds, decoded[i].seconds);
+        CHECK_EQUAL(times[i].fraction, decoded[i].fraction);
+    }
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,281 @@
+/**
+ * @file test/tm_test.cpp
+ */
+
+#include "ccsds/tm.h"
+#include "ccsds/crc.h"
+#include "CppUTest/TestHarness.h"
+#include <cstring>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * TM transfer frame test group.
+ */
+TEST_GROUP(TransferFrameTestGroup)
+{
+};
+
+/**
+ * Physical channel copying transmitted frames.
+ */
+class tm_test_channel : public ccsds::base_service {
+    public:
+        tm_test_channel() :
+            hold(false)
+        {}
+
+        virtual ~tm_test_channel() = default;
+
+        bool                                               hold;   ///< Keep frames instead of releasing them.
+        std::vector<std::vector<uint8_t>>                  frames; ///< Transmitted frames.
+        std::vector<std::unique_ptr<const ccsds::base_du>> held;   ///< Frames not released.
+
+    private:
+        virtual ccsds::error transfer(std::unique_ptr<const ccsds::base_du> du) override
+        {
+            const uint8_t* p = static_cast<const uint8_t*>(du->get());
+            frames.emplace_back(p, p + du->size());
+            if(hold){
+                held.push_back(std::move(du));
+            }
+            return ccsds::error();
+        }
+};
+
+/**
+ * Receiver recording packets extracted from frames.
+ */
+class tm_test_receiver {
+    public:
+        /**
+         * Receive a packet.
+         */
+        void packet(const ccsds::spp::packet_view& packet, ccsds::spp::apid id, bool packet_loss)
+        {
+            (void)packet_loss;
+            ids.push_back(id);
+            const uint8_t* p = static_cast<const uint8_t*>(packet.get());
+            packets.emplace_back(p, p + packet.size());
+        }
+
+        std::vector<ccsds::spp::apid>     ids;     ///< APID of each packet.
+        std::vector<std::vector<uint8_t>> packets; ///< Received packets.
+};
+
+/**
+ * Send a packet with a pattern.
+ * @param service Service to send with.
+ * @param len Length of the user data in bytes.
+ * @param seed First octet of the user data.
+ * @return Result of the request.
+ */
+static ccsds::error tm_send(ccsds::spp::octet_service& service, size_t len, uint8_t seed)
+{
+    std::vector<uint8_t> data(len);
+    for(size_t i = 0; i < len; ++i){
+        data[i] = static_cast<uint8_t>(seed + i);
+    }
+    // Split the user data over two DUs to exercise chains spanning frames
+    auto sdu = std::make_unique<ccsds::buffered_du>(data.data(), len / 2);
+    sdu->extend(std::make_unique<ccsds::buffered_du>(data.data() + len / 2, len - len / 2));
+    return service.request(std::move(sdu), false, ccsds::spp::TELEMETRY);
+}
+
+/**
+ * Get the first header pointer of a frame.
+ */
+static uint16_t tm_first_header(const std::vector<uint8_t>& frame)
+{
+    return ((frame[4] << 8) | frame[5]) & ccsds::tm::STATUS_FHP_MASK;
+}
+
+/**
+ * Test packets of several services are multiplexed into frames and extracted again.
+ */
+TEST(TransferFrameTestGroup, MultiplexTest)
+{
+    tm_test_channel physical;
+    ccsds::tm::frame_service master(0x123, 64, &physical, 4, true);
+    ccsds::tm::virtual_channel channel(master, 3);
+    CHECK_EQUAL(64, master.length());
+    CHECK_EQUAL(64 - 6 - 2, master.data_length());
+    CHECK_EQUAL(3, channel.id());
+
+    ccsds::spp::octet_service first(static_cast<ccsds::spp::apid>(0x10), &channel);
+    ccsds::spp::octet_service second(static_cast<ccsds::spp::apid>(0x20), &channel);
+
+    // 26 + 56 + 106 + 7 = 195 bytes of packets
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tm_send(first, 20, 0)));
+    CHECK_EQUAL(0, physical.frames.size());
+    CHECK_EQUAL(26, channel.pending());
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tm_send(second, 50, 100)));
+    CHECK_EQUAL(1, physical.frames.size());
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tm_send(first, 100, 200)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tm_send(second, 1, 50)));
+    CHECK_EQUAL(3, physical.frames.size());
+    CHECK_EQUAL(195 - 3 * 56, channel.pending());
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(channel.flush()));
+    CHECK_EQUAL(4, physical.frames.size());
+    CHECK_EQUAL(0, channel.pending());
+    CHECK_EQUAL(4, master.available());
+
+    // Headers and first header pointers
+    for(size_t i = 0; i < physical.frames.size(); ++i){
+        const std::vector<uint8_t>& frame = physical.frames[i];
+        CHECK_EQUAL(64, frame.size());
+        CHECK_EQUAL(ccsds::ntohs(ccsds::tm::identification(0x123, 3)), (frame[0] << 8) | frame[1]);
+        CHECK_EQUAL(i, frame[2]);
+        CHECK_EQUAL(i, frame[3]);
+        CHECK_EQUAL(0, ccsds::crc16(frame.data(), frame.size()));
+    }
+    CHECK_EQUAL(0, tm_first_header(physical.frames[0]));
+    CHECK_EQUAL(26, tm_first_header(physical.frames[1]));
+    CHECK_EQUAL(ccsds::tm::FHP_NO_PACKET, tm_first_header(physical.frames[2]));
+    CHECK_EQUAL(188 - 168, tm_first_header(physical.frames[3]));
+
+    // Extract the packets again
+    tm_test_receiver received;
+    ccsds::spp::packet_service service(nullptr);
+    service.set_view_indication(ccsds::spp::packet_service::view_indication::bind<&tm_test_receiver::packet>(&received));
+    ccsds::tm::frame_demux demux(0x123, 64, true);
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(demux.attach(8, &service)));
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(demux.attach(3, &service)));
+    for(auto& frame : physical.frames){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(demux.reception(frame.data(), frame.size())));
+    }
+
+    // The idle packets completing the last frame are not passed on
+    CHECK_EQUAL(4, received.packets.size());
+    CHECK_EQUAL(0x10, received.ids[0]);
+    CHECK_EQUAL(0x20, received.ids[1]);
+    CHECK_EQUAL(0x10, received.ids[2]);
+    CHECK_EQUAL(0x20, received.ids[3]);
+    CHECK_EQUAL(26, received.packets[0].size());
+    CHECK_EQUAL(56, received.packets[1].size());
+    CHECK_EQUAL(106, received.packets[2].size());
+    CHECK_EQUAL(7, received.packets[3].size());
+    for(size_t i = 0; i < 100; ++i){
+        CHECK_EQUAL(static_cast<uint8_t>(200 + i), received.packets[2][6 + i]);
+    }
+}
+
+/**
+ * Test completing a frame with an idle packet continuing in the next frame.
+ */
+TEST(TransferFrameTestGroup, FlushTest)
+{
+    tm_test_channel physical;
+    ccsds::tm::frame_service master(0x1, 32, &physical);
+    ccsds::tm::virtual_channel channel(master, 0, 0x55);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x10), &channel);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(channel.flush()));
+    CHECK_EQUAL(0, physical.frames.size());
+
+    // 4 octets left in the frame, too short for an idle packet
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tm_send(service, 16, 0)));
+    CHECK_EQUAL(22, channel.pending());
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(channel.flush()));
+    CHECK_EQUAL(1, physical.frames.size());
+    CHECK_EQUAL(3, channel.pending());
+    CHECK_EQUAL(0x07, physical.frames[0][6 + 22]);
+    CHECK_EQUAL(0xFF, physical.frames[0][6 + 23]);
+
+    // The rest of the idle packet starts the next frame
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(channel.flush()));
+    CHECK_EQUAL(2, physical.frames.size());
+    CHECK_EQUAL(3, tm_first_header(physical.frames[1]));
+    CHECK_EQUAL(0x55, physical.frames[1][6 + 2]);
+
+    tm_test_receiver received;
+    ccsds::spp::packet_service packets(nullptr);
+    packets.set_view_indication(ccsds::spp::packet_service::view_indication::bind<&tm_test_receiver::packet>(&received));
+    ccsds::tm::frame_demux demux(0x1, 32);
+    demux.attach(0, &packets);
+    for(auto& frame : physical.frames){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(demux.reception(frame.data(), frame.size())));
+    }
+    CHECK_EQUAL(1, received.packets.size());
+    CHECK_EQUAL(22, received.packets[0].size());
+}
+
+/**
+ * Test packets are rejected without enough free frame buffers.
+ */
+TEST(TransferFrameTestGroup, NoSpaceTest)
+{
+    tm_test_channel physical;
+    physical.hold = true;
+    ccsds::tm::frame_service master(0x1, 32, &physical, 2);
+    ccsds::tm::virtual_channel channel(master, 0);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x10), &channel);
+
+    // 2 full frames and one more octet
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(tm_send(service, 2 * 26 - 6 + 1, 0)));
+    CHECK_EQUAL(0, physical.frames.size());
+    CHECK_EQUAL(2, master.available());
+
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tm_send(service, 30, 0)));
+    CHECK_EQUAL(1, physical.frames.size());
+    CHECK_EQUAL(0, master.available());
+    CHECK_EQUAL(ccsds::error::code::NO_SPACE, static_cast<int>(tm_send(service, 30, 0)));
+
+    // Released frames are reused
+    physical.held.clear();
+    CHECK_EQUAL(1, master.available());
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tm_send(service, 30, 0)));
+    CHECK_EQUAL(2, physical.frames.size());
+
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG,
+            static_cast<int>(channel.transfer(std::make_unique<ccsds::buffered_du>(nullptr, 0))));
+    physical.held.clear();
+}
+
+/**
+ * Test resynchronizing on the first header pointer after a missing frame.
+ */
+TEST(TransferFrameTestGroup, LossTest)
+{
+    tm_test_channel physical;
+    ccsds::tm::frame_service master(0x1, 32, &physical, 4, true);
+    ccsds::tm::virtual_channel channel(master, 1);
+    ccsds::spp::octet_service service(static_cast<ccsds::spp::apid>(0x10), &channel);
+    for(uint8_t i = 0; i < 6; ++i){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(tm_send(service, 14, i)));
+    }
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(channel.flush()));
+    CHECK_EQUAL(5, physical.frames.size());
+
+    tm_test_receiver received;
+    ccsds::spp::packet_service packets(nullptr);
+    packets.set_view_indication(ccsds::spp::packet_service::view_indication::bind<&tm_test_receiver::packet>(&received));
+    ccsds::tm::frame_demux demux(0x1, 32, true);
+    demux.attach(1, &packets);
+
+    // Frames of other spacecraft, or corrupted, are rejected
+    ccsds::tm::frame_demux other(0x2, 32, true);
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(other.reception(physical.frames[0].data(), 32)));
+    CHECK_EQUAL(ccsds::error::code::INVALID_ARG, static_cast<int>(demux.reception(physical.frames[0].data(), 31)));
+    std::vector<uint8_t> corrupt = physical.frames[0];
+    corrupt[10] ^= 0x01;
+    CHECK_EQUAL(ccsds::error::code::IO_ERROR, static_cast<int>(demux.reception(corrupt.data(), corrupt.size())));
+
+    // 20 byte packets in 24 byte data fields, drop the second frame
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(demux.reception(physical.frames[0].data(), 32)));
+    CHECK_EQUAL(1, received.packets.size());
+    for(size_t i = 2; i < physical.frames.size(); ++i){
+        CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(demux.reception(physical.frames[i].data(), 32)));
+    }
+
+    // The packets in the missing frame and the one straddling it are lost
+    CHECK_EQUAL(4, received.packets.size());
+    CHECK_EQUAL(3, received.packets[1][6]);
+    CHECK_EQUAL(4, received.packets[2][6]);
+    CHECK_EQUAL(5, received.packets[3][6]);
+}
+
+/** @} */ // group unittest
@@ -0,0 +1,153 @@
+/**
+ * @file test/trace_test.cpp
+ */
+
+#ifndef CCSDS_TRACE
+#define CCSDS_TRACE
+#endif
+#include "ccsds/trace.h"
+#include "ccsds/spp.h"
+#include "CppUTest/TestHarness.h"
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+/**
+ * @ingroup unittest
+ * @{
+ */
+
+/**
+ * Tracing test group.
+ */
+TEST_GROUP(TraceTestGroup)
+{
+    void setup()
+    {
+        // Discard events of earlier tests
+        ccsds::trace::event events[64];
+        while(ccsds::trace::drain(events, 64) > 0){}
+    }
+};
+
+/**
+ * Test scopes record nested events.
+ */
+TEST(TraceTestGroup, ScopeTest)
+{
+    uint8_t header[6] = {0x08, 0x12, 0xC0, 0x2A, 0x00, 0x03};
+    uint8_t data[4] = {};
+    ccsds::buffered_du packet(header, sizeof(header));
+    packet.extend(std::make_unique<ccsds::buffered_du>(data, sizeof(data)));
+    {
+        CCSDS_TRACE_SCOPE(OCTET_REQUEST, 0x12, ccsds::trace::NO_COUNT, 4);
+        CCSDS_TRACE_SCOPE(SUBNETWORK, packet);
+    }
+
+    ccsds::trace::event events[4];
+    CHECK_EQUAL(2, ccsds::trace::drain(events, 4));
+
+    // The inner scope ends first
+    CHECK(events[0].where == ccsds::trace::point::SUBNETWORK);
+    CHECK_EQUAL(0x12, events[0].apid);
+    CHECK_EQUAL(0x2A, events[0].count);
+    CHECK_EQUAL(10, events[0].size);
+    CHECK(events[1].where == ccsds::trace::point::OCTET_REQUEST);
+    CHECK_EQUAL(ccsds::trace::NO_COUNT, events[1].count);
+    CHECK_EQUAL(4, events[1].size);
+    CHECK(events[1].begin <= events[0].begin);
+    CHECK(events[0].begin <= events[0].end);
+    CHECK(events[0].end <= events[1].end);
+    CHECK_EQUAL(0, ccsds::trace::drain(events, 4));
+}
+
+/**
+ * Test a full ring drops events instead of blocking.
+ */
+TEST(TraceTestGroup, FullTest)
+{
+    uint64_t before = ccsds::trace::dropped();
+    for(size_t i = 0; i < ccsds::trace::RING_SIZE + 10; ++i){
+        CCSDS_TRACE_SCOPE(INDICATION, 1, i & 0x3FFF, 0);
+    }
+    CHECK_EQUAL(10, ccsds::trace::dropped() - before);
+
+    std::vector<ccsds::trace::event> events(ccsds::trace::RING_SIZE + 1);
+    CHECK_EQUAL(ccsds::trace::RING_SIZE, ccsds::trace::drain(events.data(), events.size()));
+    CHECK_EQUAL(ccsds::trace::RING_SIZE - 1, events[ccsds::trace::RING_SIZE - 1].count);
+}
+
+/**
+ * Test draining events of several threads while they are recorded.
+ */
+TEST(TraceTestGroup, ThreadTest)
+{
+    constexpr size_t EVENTS = 20000;
+    uint64_t before = ccsds::trace::dropped();
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 3; ++t){
+        threads.emplace_back([t](){
+            for(size_t i = 0; i < EVENTS; ++i){
+                CCSDS_TRACE_SCOPE(PACKET_RECEPTION, t, i & 0x3FFF, i);
+            }
+        });
+    }
+
+    size_t taken = 0;
+    ccsds::trace::event events[256];
+    while(!threads.empty()){
+        size_t count = ccsds::trace::drain(events, 256);
+        for(size_t i = 0; i < count; ++i){
+            CHECK(events[i].where == ccsds::trace::point::PACKET_RECEPTION);
+            CHECK_EQUAL(events[i].size & 0x3FFF, events[i].count);
+        }
+        taken += count;
+        if(count == 0){
+            for(auto& t : threads){
+                t.join();
+            }
+            threads.clear();
+        }
+    }
+
+    // Every event is either drained or dropped
+    size_t count;
+    while((count = ccsds::trace::drain(events, 256)) > 0){
+        taken += count;
+    }
+    CHECK_EQUAL(3 * EVENTS, taken + (ccsds::trace::dropped() - before));
+}
+
+/**
+ * Test writing events in the Chrome trace event format.
+ */
+TEST(TraceTestGroup, DumpTest)
+{
+    {
+        CCSDS_TRACE_SCOPE(ASSEMBLY, 0x7F, 5, 100);
+    }
+    {
+        CCSDS_TRACE_SCOPE(OCTET_REQUEST, 0x7F, ccsds::trace::NO_COUNT, 100);
+    }
+
+    std::FILE* f = std::tmpfile();
+    CHECK(f != nullptr);
+    CHECK_EQUAL(ccsds::error::code::NONE, static_cast<int>(ccsds::trace::dump(f)));
+    std::rewind(f);
+    char json[1024] = {};
+    size_t len = std::fread(json, 1, sizeof(json) - 1, f);
+    std::fclose(f);
+
+    CHECK(len > 0);
+    CHECK(std::strncmp(json, "{\"traceEvents\":[", 16) == 0);
+    CHECK(std::strstr(json, "\"name\":\"assembly\",\"ph\":\"X\"") != nullptr);
+    CHECK(std::strstr(json, "\"args\":{\"apid\":127,\"count\":5,\"size\":100}}") != nullptr);
+    CHECK(std::strstr(json, "\"name\":\"octet_request\"") != nullptr);
+    CHECK(std::strstr(json, "\"count\":-1") != nullptr);
+    CHECK(std::strstr(json, "},\n{") != nullptr);
+    CHECK(std::strcmp(json + len - 4, "\n]}\n") == 0);
+    STRCMP_EQUAL("indication", ccsds::trace::name(ccsds::trace::point::INDICATION));
+}
+
+/** @} */ // group unittest